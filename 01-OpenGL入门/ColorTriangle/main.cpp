@@ -16,6 +16,7 @@
 #include "shader_s.h"
 #include <iostream>
 #include "glhelp.h"
+#include "headless.h"
 
 const unsigned int SCR_WIDTH = 800;
 const unsigned int SCR_HEIGHT = 600;
@@ -30,25 +31,37 @@ void framebuffer_size_callback(GLFWwindow* window, int width, int height);
 void processInput(GLFWwindow *window);
 
 int main(int argc, const char * argv[]) {
-    // --------------- 初始化 GLFW ---------------
-    glfwInitialize();
-    // --------------- 创建窗口 ---------------
-    GLFWwindow *window = glfwCreateWindow(SCR_WIDTH,
-                                          SCR_HEIGHT,
-                                          "Color Triangle",
-                                          NULL,
-                                          NULL);
-    if (window == NULL) {
-        std::cout << "创建窗口失败" << std::endl;
-        glfwTerminate();
-        return -1;
-    }
-    glfwMakeContextCurrent(window);
-    glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
-    // --------------- 初始化 GLAD ---------------
-    if (!gladInitialize()) {
-        std::cout << "初始化 GLAD 拓展失败" << std::endl;
-        return -1;
+    // --------------- 离屏模式 ---------------
+    // 参数 --headless [宽x高] / --frames N / --dump FILE：不创建窗口，渲染到 FBO 中，渲染满 N 帧后退出
+    Headless &headless = Headless::instance();
+    headless.parseArguments(argc, argv);
+    GLFWwindow *window = NULL;
+    if (headless.enabled()) {
+        if (!headless.initialize()) {
+            std::cout << "创建离屏渲染上下文失败" << std::endl;
+            return -1;
+        }
+    } else {
+        // --------------- 初始化 GLFW ---------------
+        glfwInitialize();
+        // --------------- 创建窗口 ---------------
+        window = glfwCreateWindow(SCR_WIDTH,
+                                  SCR_HEIGHT,
+                                  "Color Triangle",
+                                  NULL,
+                                  NULL);
+        if (window == NULL) {
+            std::cout << "创建窗口失败" << std::endl;
+            glfwTerminate();
+            return -1;
+        }
+        glfwMakeContextCurrent(window);
+        glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+        // --------------- 初始化 GLAD ---------------
+        if (!gladInitialize()) {
+            std::cout << "初始化 GLAD 拓展失败" << std::endl;
+            return -1;
+        }
     }
     // --------------- 构建着色器程序 ---------------
     Shader ourShader("./shader.vs", "./shader.fs");
@@ -66,9 +79,10 @@ int main(int argc, const char * argv[]) {
     glBindBuffer(GL_ARRAY_BUFFER, 0);
     glBindVertexArray(0);
     // --------------- 渲染循环 ---------------
-    while (!glfwWindowShouldClose(window)) {
+    while (headless.running(window)) {
         // 1. 处理用户输入
-        processInput(window);
+        if (!headless.enabled())
+            processInput(window);
         // 2. 背景渲染颜色
         glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT);
@@ -80,11 +94,16 @@ int main(int argc, const char * argv[]) {
         // 3-3: 绘制顶点数组
         glDrawArrays(GL_TRIANGLES, 0, 3);
         // 4. 交换缓冲
-        glfwSwapBuffers(window);
-        // 5. 处理事件
-        glfwPollEvents();
+        if (headless.enabled()) {
+            headless.present();
+        } else {
+            glfwSwapBuffers(window);
+            // 5. 处理事件
+            glfwPollEvents();
+        }
     }
     // 释放/删除之前的分配的所有资源
+    headless.release();
     glfwTerminate();
     return 0;
 }
@@ -36,6 +36,7 @@
 #include <GLFW/glfw3.h>
 #include "shader_s.h"
 #include "glhelp.h"
+#include "headless.h"
 #include <iostream>
 
 const unsigned int SCR_WIDTH = 800;
@@ -133,25 +134,37 @@ void processInput(GLFWwindow *window);
 
 
 int main(int argc, const char * argv[]) {
-    // --------------- 初始化 GLFW ---------------
-    glfwInitialize();
-    // --------------- 创建窗口 ---------------
-    GLFWwindow *window = glfwCreateWindow(SCR_WIDTH,
-                                          SCR_HEIGHT,
-                                          "Free Move Camera",
-                                          NULL,
-                                          NULL);
-    if (window == NULL) {
-        std::cout << "创建窗口失败" << std::endl;
-        glfwTerminate();
-        return -1;
-    }
-    glfwMakeContextCurrent(window);
-    glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
-    // --------------- 初始化 GLAD ---------------
-    if (!gladInitialize()) {
-        std::cout << "初始化 GLAD 拓展失败" << std::endl;
-        return -1;
+    // --------------- 离屏模式 ---------------
+    // 参数 --headless [宽x高] / --frames N / --dump FILE：不创建窗口，渲染到 FBO 中，渲染满 N 帧后退出
+    Headless &headless = Headless::instance();
+    headless.parseArguments(argc, argv);
+    GLFWwindow *window = NULL;
+    if (headless.enabled()) {
+        if (!headless.initialize()) {
+            std::cout << "创建离屏渲染上下文失败" << std::endl;
+            return -1;
+        }
+    } else {
+        // --------------- 初始化 GLFW ---------------
+        glfwInitialize();
+        // --------------- 创建窗口 ---------------
+        window = glfwCreateWindow(SCR_WIDTH,
+                                  SCR_HEIGHT,
+                                  "Free Move Camera",
+                                  NULL,
+                                  NULL);
+        if (window == NULL) {
+            std::cout << "创建窗口失败" << std::endl;
+            glfwTerminate();
+            return -1;
+        }
+        glfwMakeContextCurrent(window);
+        glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+        // --------------- 初始化 GLAD ---------------
+        if (!gladInitialize()) {
+            std::cout << "初始化 GLAD 拓展失败" << std::endl;
+            return -1;
+        }
     }
     // --------------- 构建着色器程序 ---------------
     Shader ourShader("./shader.vs", "./shader.fs");
@@ -242,17 +255,25 @@ int main(int argc, const char * argv[]) {
     // 启用深度测试 -> 绘制遮挡效果
     glEnable(GL_DEPTH_TEST);
     
-    // 告诉 GLFW 应该隐藏光标
-    glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
-    // 设置鼠标移动回调
-    glfwSetCursorPosCallback(window, mouse_callback);
-    // 设置鼠标滚轮回调
-    glfwSetScrollCallback(window, scroll_callback);
+    if (headless.enabled()) {
+        // 脚本相机：从初始位置开始绕原点环绕
+        headless.cameraPath().setOrbit(glm::vec3(0.0f, 0.0f, 0.0f), cameraPos);
+    } else {
+        // 告诉 GLFW 应该隐藏光标
+        glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+        // 设置鼠标移动回调
+        glfwSetCursorPosCallback(window, mouse_callback);
+        // 设置鼠标滚轮回调
+        glfwSetScrollCallback(window, scroll_callback);
+    }
     
     // --------------- 渲染循环 ---------------
-    while (!glfwWindowShouldClose(window)) {
+    while (headless.running(window)) {
         // 1. 处理用户输入
-        processInput(window);
+        if (headless.enabled())
+            headless.cameraPath().sample(headless.time(), cameraPos, cameraFront);
+        else
+            processInput(window);
         
         // --------------------------------------------------------
         // 2. 背景渲染颜色
@@ -282,7 +303,7 @@ int main(int argc, const char * argv[]) {
         // 投影矩阵 - 3D 变 2D 变换
         glm::mat4 projection = glm::mat4(1.0f);
         projection = glm::perspective(glm::radians(fov),
-                                      ((float)SCR_WIDTH / (float)SCR_HEIGHT),
+                                      headless.aspect((float)SCR_WIDTH / (float)SCR_HEIGHT),
                                       0.1f,
                                       100.0f);
         // 设置 uniform 属性
@@ -301,11 +322,16 @@ int main(int argc, const char * argv[]) {
         }
         
         // 4. 交换缓冲
-        glfwSwapBuffers(window);
-        // 5. 处理事件
-        glfwPollEvents();
+        if (headless.enabled()) {
+            headless.present();
+        } else {
+            glfwSwapBuffers(window);
+            // 5. 处理事件
+            glfwPollEvents();
+        }
     }
     // 释放/删除之前的分配的所有资源
+    headless.release();
     glfwTerminate();
     return 0;
 }
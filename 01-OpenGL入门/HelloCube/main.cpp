@@ -18,6 +18,7 @@
 #include <GLFW/glfw3.h>
 #include "shader_s.h"
 #include "glhelp.h"
+#include "headless.h"
 #include <iostream>
 
 const unsigned int SCR_WIDTH = 800;
@@ -88,25 +89,37 @@ void processInput(GLFWwindow *window);
 
 
 int main(int argc, const char * argv[]) {
-    // --------------- 初始化 GLFW ---------------
-    glfwInitialize();
-    // --------------- 创建窗口 ---------------
-    GLFWwindow *window = glfwCreateWindow(SCR_WIDTH,
-                                          SCR_HEIGHT,
-                                          "Hello Cube",
-                                          NULL,
-                                          NULL);
-    if (window == NULL) {
-        std::cout << "创建窗口失败" << std::endl;
-        glfwTerminate();
-        return -1;
-    }
-    glfwMakeContextCurrent(window);
-    glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
-    // --------------- 初始化 GLAD ---------------
-    if (!gladInitialize()) {
-        std::cout << "初始化 GLAD 拓展失败" << std::endl;
-        return -1;
+    // --------------- 离屏模式 ---------------
+    // 参数 --headless [宽x高] / --frames N / --dump FILE：不创建窗口，渲染到 FBO 中，渲染满 N 帧后退出
+    Headless &headless = Headless::instance();
+    headless.parseArguments(argc, argv);
+    GLFWwindow *window = NULL;
+    if (headless.enabled()) {
+        if (!headless.initialize()) {
+            std::cout << "创建离屏渲染上下文失败" << std::endl;
+            return -1;
+        }
+    } else {
+        // --------------- 初始化 GLFW ---------------
+        glfwInitialize();
+        // --------------- 创建窗口 ---------------
+        window = glfwCreateWindow(SCR_WIDTH,
+                                  SCR_HEIGHT,
+                                  "Hello Cube",
+                                  NULL,
+                                  NULL);
+        if (window == NULL) {
+            std::cout << "创建窗口失败" << std::endl;
+            glfwTerminate();
+            return -1;
+        }
+        glfwMakeContextCurrent(window);
+        glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+        // --------------- 初始化 GLAD ---------------
+        if (!gladInitialize()) {
+            std::cout << "初始化 GLAD 拓展失败" << std::endl;
+            return -1;
+        }
     }
     // --------------- 构建着色器程序 ---------------
     Shader ourShader("./shader.vs", "./shader.fs");
@@ -201,9 +214,10 @@ int main(int argc, const char * argv[]) {
     // --------------------------------------------------------
     
     // --------------- 渲染循环 ---------------
-    while (!glfwWindowShouldClose(window)) {
+    while (headless.running(window)) {
         // 1. 处理用户输入
-        processInput(window);
+        if (!headless.enabled())
+            processInput(window);
         
         // --------------------------------------------------------
         // 2. 背景渲染颜色
@@ -234,7 +248,7 @@ int main(int argc, const char * argv[]) {
         // 投影矩阵 - 3D 变 2D 变换
         glm::mat4 projection = glm::mat4(1.0f);
         projection = glm::perspective(glm::radians(45.0f),                     // FoV角，越大视野越大
-                                      ((float)SCR_WIDTH / (float)SCR_HEIGHT),  // 屏幕拉伸比例，一般和视图比例相同即可，大了会被左右压扁，小了会被上下压扁
+                                      headless.aspect((float)SCR_WIDTH / (float)SCR_HEIGHT),  // 屏幕拉伸比例，一般和视图比例相同即可，大了会被左右压扁，小了会被上下压扁
                                       0.1f,                                    // 近平面距离
                                       100.0f);                                 // 远平面距离
         // 设置 uniform 属性
@@ -247,7 +261,7 @@ int main(int argc, const char * argv[]) {
             model = glm::translate(model, cubePositions[i]);
             // float angle = 20.0f * i;
             // model = glm::rotate(model, glm::radians(angle), glm::vec3(1.0f, 0.3f, 0.5f));
-            model = glm::rotate(model, (float)glfwGetTime() * glm::radians(50.0f), glm::vec3(0.5f, 1.0f, 0.0f));
+            model = glm::rotate(model, (float)headless.time() * glm::radians(50.0f), glm::vec3(0.5f, 1.0f, 0.0f));
             ourShader.setMat4("model", model);
             
             glDrawArrays(GL_TRIANGLES, 0, 36);
@@ -255,11 +269,16 @@ int main(int argc, const char * argv[]) {
         // --------------------------------------------------------
         
         // 4. 交换缓冲
-        glfwSwapBuffers(window);
-        // 5. 处理事件
-        glfwPollEvents();
+        if (headless.enabled()) {
+            headless.present();
+        } else {
+            glfwSwapBuffers(window);
+            // 5. 处理事件
+            glfwPollEvents();
+        }
     }
     // 释放/删除之前的分配的所有资源
+    headless.release();
     glfwTerminate();
     return 0;
 }
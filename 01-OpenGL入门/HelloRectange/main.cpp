@@ -30,6 +30,7 @@
 #include <GLFW/glfw3.h>
 #include "shaderhelp.h"
 #include "glhelp.h"
+#include "headless.h"
 
 // 窗口的宽高
 const unsigned int SCR_WIDTH = 800;
@@ -78,27 +79,39 @@ void processInput(GLFWwindow *window) {
 }
 
 int main(int argc, const char * argv[]) {
-    // --- 初始化 GLFW ---
-    glfwInitialize();
-    
-    // --- 创建窗口 ---
-    GLFWwindow* window = glfwCreateWindow(SCR_WIDTH,
-                                          SCR_HEIGHT,
-                                          "Hello Rectange",
-                                          NULL,
-                                          NULL);
-    if (window == NULL) {
-        std::cout << "Failed to create GLFW window" << std::endl;
-        glfwTerminate();
-        return -1;
-    }
-    glfwMakeContextCurrent(window);
-    glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
-    
-    // --- 初始化 GLAD ---
-    if (!gladInitialize()) {
-       std::cout << "Failed to initialize GLAD" << std::endl;
-        return -1;
+    // --------------- 离屏模式 ---------------
+    // 参数 --headless [宽x高] / --frames N / --dump FILE：不创建窗口，渲染到 FBO 中，渲染满 N 帧后退出
+    Headless &headless = Headless::instance();
+    headless.parseArguments(argc, argv);
+    GLFWwindow *window = NULL;
+    if (headless.enabled()) {
+        if (!headless.initialize()) {
+            std::cout << "创建离屏渲染上下文失败" << std::endl;
+            return -1;
+        }
+    } else {
+        // --- 初始化 GLFW ---
+        glfwInitialize();
+        
+        // --- 创建窗口 ---
+        window = glfwCreateWindow(SCR_WIDTH,
+                                  SCR_HEIGHT,
+                                  "Hello Rectange",
+                                  NULL,
+                                  NULL);
+        if (window == NULL) {
+            std::cout << "Failed to create GLFW window" << std::endl;
+            glfwTerminate();
+            return -1;
+        }
+        glfwMakeContextCurrent(window);
+        glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+        
+        // --- 初始化 GLAD ---
+        if (!gladInitialize()) {
+           std::cout << "Failed to initialize GLAD" << std::endl;
+            return -1;
+        }
     }
     
     // --- 配置顶点着色器 ---
@@ -175,9 +188,10 @@ int main(int argc, const char * argv[]) {
     // glPolygonMode(GL_FRONT_AND_BACK, GL_FILL)
     
     // 一个简单的渲染循环（每一帧调用一次）
-    while (!glfwWindowShouldClose(window)) {
+    while (headless.running(window)) {
         // 1. 处理用户输入
-        processInput(window);
+        if (!headless.enabled())
+            processInput(window);
         
         // 2. 渲染指令
         // 2-1: 设置清空屏幕所用的颜色
@@ -194,15 +208,20 @@ int main(int argc, const char * argv[]) {
         glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
         
         // 4. 检查并调用事件，交换缓冲
-        glfwSwapBuffers(window);
-        // 5. 检查有没有触发什么事件（比如键盘输入、鼠标移动等）、更新窗口状态，并调用对应的回调函数
-        glfwPollEvents();
+        if (headless.enabled()) {
+            headless.present();
+        } else {
+            glfwSwapBuffers(window);
+            // 5. 检查有没有触发什么事件（比如键盘输入、鼠标移动等）、更新窗口状态，并调用对应的回调函数
+            glfwPollEvents();
+        }
     }
     
     // 释放/删除之前的分配的所有资源
     glDeleteVertexArrays(1, &VAO);
     glDeleteBuffers(1, &VBO);
     glDeleteBuffers(1, &EBO);
+    headless.release();
     glfwTerminate();
     
     return 0;
@@ -5,9 +5,10 @@ layout (location = 1) in vec3 aNormal; // 法向量
 out vec3 FragPos;  // 渲染位置
 out vec3 Normal;   // 法向量
 
+// 以下矩阵由 CPU 端变换阶段（transform_stage.h）每个物体计算一次
 uniform mat4 model;                 // 模型矩阵
-uniform mat4 view;                  // 视图矩阵
-uniform mat4 projection;            // 投影矩阵
+uniform mat3 normalMatrix;          // 法线矩阵
+uniform mat4 mvp;                   // 模型-观察-投影矩阵
 
 void main()
 {
@@ -15,7 +16,7 @@ void main()
     FragPos = vec3(model * vec4(aPos, 1.0));
     // 用模型矩阵左上角的逆矩阵的转置矩阵移除对法向量错误缩放(不等比缩放)的影响
     // http://www.lighthouse3d.com/tutorials/glsl-12-tutorial/the-normal-matrix/
-    Normal = mat3(transpose(inverse(model))) * aNormal;
+    Normal = normalMatrix * aNormal;
     
-    gl_Position = projection * view * vec4(FragPos, 1.0);
+    gl_Position = mvp * vec4(aPos, 1.0);
 }
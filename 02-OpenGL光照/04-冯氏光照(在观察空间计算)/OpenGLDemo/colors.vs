@@ -9,17 +9,19 @@ out vec3 LightPos; // 光源位置
 
 uniform vec3 lightPos; // 光源位置
 
+// model、normalMatrix、mvp 由 CPU 端变换阶段（transform_stage.h）每个物体计算一次
 uniform mat4 model;                 // 模型矩阵
+uniform mat3 normalMatrix;          // 法线矩阵（世界空间）
+uniform mat4 mvp;                   // 模型-观察-投影矩阵
 uniform mat4 view;                  // 视图矩阵
-uniform mat4 projection;            // 投影矩阵
 
 void main()
 {
-     gl_Position = projection * view * model * vec4(aPos, 1.0);
+    gl_Position = mvp * vec4(aPos, 1.0);
     // 观察空间的顶点位置
-    FragPos = vec3(view * model * vec4(aPos, 1.0));
-    // 观察空间的法向量
-    Normal = mat3(transpose(inverse(view * model))) * aNormal;
+    FragPos = vec3(view * (model * vec4(aPos, 1.0)));
+    // 观察空间的法向量（视图矩阵只有旋转和平移，它的法线矩阵就是 mat3(view)）
+    Normal = mat3(view) * (normalMatrix * aNormal);
     // 观察空间中的光源位置
     LightPos = vec3(view * vec4(lightPos, 1.0));
 }
@@ -6,5 +6,5 @@ uniform vec3 objectColor;  // 物体颜色
 
 void main()
 {
-    FragColor = LightingColor * objectColor;;
+    FragColor = vec4(LightingColor * objectColor, 1.0);
 }
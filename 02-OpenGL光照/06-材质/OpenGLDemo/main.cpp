@@ -20,6 +20,8 @@
 
 #include "shader_m.h"
 #include "camera.h"
+#include "transform_stage.h"
+#include "headless.h"
 
 #include <iostream>
 
@@ -47,46 +49,60 @@ float lastFrame = 0.0f;
 glm::vec3 lightPos(0.6f, 0.0f, 5.0f);
 
 int main(int argc, const char * argv[]) {
-    // --------------- 初始化 GLFW ---------------
-    glfwInit();
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
-    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    // --------------- 离屏模式 ---------------
+    // 参数 --headless [宽x高] / --frames N / --dump FILE：不创建窗口，渲染到 FBO 中，渲染满 N 帧后退出
+    Headless &headless = Headless::instance();
+    headless.parseArguments(argc, argv);
+    GLFWwindow *window = NULL;
+    if (headless.enabled()) {
+        if (!headless.initialize()) {
+            std::cout << "创建离屏渲染上下文失败" << std::endl;
+            return -1;
+        }
+        // 脚本相机：从初始位置开始绕原点环绕
+        headless.cameraPath().setOrbit(glm::vec3(0.0f, 0.0f, 0.0f), camera.Position);
+    } else {
+        // --------------- 初始化 GLFW ---------------
+        glfwInit();
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+        glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
 #ifdef __APPLE__
-    glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+        glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
 #endif
-    
-    // --------------- 创建窗口 ---------------
-    GLFWwindow *window = glfwCreateWindow(SCR_WIDTH,
-                                          SCR_HEIGHT,
-                                          "Learn OpenGL",
-                                          NULL,
-                                          NULL);
-    if (window == NULL) {
-        std::cout << "创建窗口失败" << std::endl;
-        glfwTerminate();
-        return -1;
-    }
-    // 配置上下文环境
-    glfwMakeContextCurrent(window);
-    // 配置帧缓存大小变化回调
-    glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
-    // 配置鼠标事件回调
-    glfwSetCursorPosCallback(window, mouse_callback);
-    // 配置滚轮事件回调
-    glfwSetScrollCallback(window, scroll_callback);
-    // 隐藏鼠标光标展示
-    glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
-    
-    // --------------- 初始化 GLAD ---------------
-    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
-        std::cout << "初始化 GLAD 拓展失败" << std::endl;
-        return -1;
+        
+        // --------------- 创建窗口 ---------------
+        window = glfwCreateWindow(SCR_WIDTH,
+                                  SCR_HEIGHT,
+                                  "Learn OpenGL",
+                                  NULL,
+                                  NULL);
+        if (window == NULL) {
+            std::cout << "创建窗口失败" << std::endl;
+            glfwTerminate();
+            return -1;
+        }
+        // 配置上下文环境
+        glfwMakeContextCurrent(window);
+        // 配置帧缓存大小变化回调
+        glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+        // 配置鼠标事件回调
+        glfwSetCursorPosCallback(window, mouse_callback);
+        // 配置滚轮事件回调
+        glfwSetScrollCallback(window, scroll_callback);
+        // 隐藏鼠标光标展示
+        glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+        
+        // --------------- 初始化 GLAD ---------------
+        if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
+            std::cout << "初始化 GLAD 拓展失败" << std::endl;
+            return -1;
+        }
     }
     
     // --------------- 配置 OpenGL 全局状态 ---------------
     // 打开深度测试功能
-    glEnable(GL_DEPTH_TEST);
+    GLState::instance().enable(GL_DEPTH_TEST);
     
     // --------------- 创建着色器程序 ---------------
     // 构建并编译反光物体着色器
@@ -144,12 +160,12 @@ int main(int argc, const char * argv[]) {
     // VBO 配置（保存顶点数据缓冲）
     unsigned int VBO;
     glGenBuffers(1, &VBO);
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    GLState::instance().bindBuffer(GL_ARRAY_BUFFER, VBO);
     glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
     // 反光 VAO 配置（保存顶点属性）
     unsigned int cubeVAO;
     glGenVertexArrays(1, &cubeVAO);
-    glBindVertexArray(cubeVAO);
+    GLState::instance().bindVertexArray(cubeVAO);
     // position attribute
     glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)0);
     glEnableVertexAttribArray(0);
@@ -159,20 +175,27 @@ int main(int argc, const char * argv[]) {
     // 发光 VAO 配置（保存顶点属性）
     unsigned int lightVAO;
     glGenVertexArrays(1, &lightVAO);
-    glBindVertexArray(lightVAO);
-    glBindBuffer(GL_ARRAY_BUFFER, VBO); // 共用VBO
+    GLState::instance().bindVertexArray(lightVAO);
+    GLState::instance().bindBuffer(GL_ARRAY_BUFFER, VBO); // 共用VBO
     glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)0);
     glEnableVertexAttribArray(0);
     
+    // 变换阶段（反光物体的模型矩阵、法线矩阵、MVP 矩阵每帧在 CPU 上只算一次）
+    TransformStage transforms;
+    unsigned int cubeObject = transforms.add();
+    
     // --------------- 渲染循环 ---------------
-    while (!glfwWindowShouldClose(window)) {
+    while (headless.running(window)) {
         // 0: 每一帧的时间逻辑(用于进行性能监控)
-        float currentFrame = glfwGetTime();
+        float currentFrame = headless.time();
         deltaTime = currentFrame - lastFrame;
         lastFrame = currentFrame;
 
         // 1: 处理用户输入
-        processInput(window);
+        if (headless.enabled())
+            headless.cameraPath().apply(camera, currentFrame);
+        else
+            processInput(window);
 
         // 2: 背景色渲染
         glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
@@ -180,8 +203,8 @@ int main(int argc, const char * argv[]) {
         
         // -----------------------------------------------
         // 让光源在场景中来回移动
-        lightPos.x = 1.0f + sin(glfwGetTime()) * 2.0f;
-        lightPos.y = sin(glfwGetTime() / 2.0f) * 1.0f;
+        lightPos.x = 1.0f + sin(headless.time()) * 2.0f;
+        lightPos.y = sin(headless.time() / 2.0f) * 1.0f;
         // -----------------------------------------------
         
         // 3: 配置反光物体着色器
@@ -194,9 +217,9 @@ int main(int argc, const char * argv[]) {
         
         // 光照相关分量
         glm::vec3 lightColor;
-        lightColor.x = sin(glfwGetTime() * 2.0f);
-        lightColor.y = sin(glfwGetTime() * 0.7f);
-        lightColor.z = sin(glfwGetTime() * 1.3f);
+        lightColor.x = sin(headless.time() * 2.0f);
+        lightColor.y = sin(headless.time() * 0.7f);
+        lightColor.z = sin(headless.time() * 1.3f);
         glm::vec3 diffuseColor = lightColor   * glm::vec3(0.5f); // 降低影响
         glm::vec3 ambientColor = diffuseColor * glm::vec3(0.2f); // 很低的影响
         lightingShader.setVec3("light.ambient", ambientColor);
@@ -212,21 +235,22 @@ int main(int argc, const char * argv[]) {
         
         // 3-3: 配置投影矩阵
         glm::mat4 projection = glm::perspective(glm::radians(camera.Zoom),
-                                                (float)SCR_WIDTH / (float)SCR_HEIGHT,
+                                                headless.aspect((float)SCR_WIDTH / (float)SCR_HEIGHT),
                                                 0.1f,
                                                 100.0f);
-        lightingShader.setMat4("projection", projection);
         // 3-4: 配置视图矩阵
         glm::mat4 view = camera.GetViewMatrix();
-        lightingShader.setMat4("view", view);
         // 3-5: 配置模型矩阵
         glm::mat4 model = glm::mat4(1.0f);
         float angle = 0.3;
         model = rotate(model, angle, glm::vec3(1.0f, 1.0f, 1.0f));
-        lightingShader.setMat4("model", model);
+        transforms.setModel(cubeObject, model);
+        // 3-6: 计算法线矩阵、MVP 矩阵并上传
+        transforms.update(view, projection);
+        transforms.apply(lightingShader, cubeObject);
 
         // 4: 渲染反光物体
-        glBindVertexArray(cubeVAO);
+        GLState::instance().bindVertexArray(cubeVAO);
         glDrawArrays(GL_TRIANGLES, 0, 36);
 
         // 5: 配置发光物体
@@ -239,19 +263,24 @@ int main(int argc, const char * argv[]) {
         lampShader.setMat4("model", model);
 
         // 6: 渲染发光物体
-        glBindVertexArray(lightVAO);
+        GLState::instance().bindVertexArray(lightVAO);
         glDrawArrays(GL_TRIANGLES, 0, 36);
         
         // 4. 交换缓冲
-        glfwSwapBuffers(window);
-        // 5. 获取输入事件
-        glfwPollEvents();
+        if (headless.enabled()) {
+            headless.present();
+        } else {
+            glfwSwapBuffers(window);
+            // 5. 获取输入事件
+            glfwPollEvents();
+        }
     }
     
     // --------------- 释放/删除之前的分配的所有资源 ---------------
-    glDeleteVertexArrays(1, &cubeVAO);
-    glDeleteVertexArrays(1, &lightVAO);
-    glDeleteBuffers(1, &VBO);
+    GLState::instance().deleteVertexArrays(1, &cubeVAO);
+    GLState::instance().deleteVertexArrays(1, &lightVAO);
+    GLState::instance().deleteBuffers(1, &VBO);
+    headless.release();
     glfwTerminate();
     
     return 0;
@@ -0,0 +1,406 @@
+//
+//  headless.h
+//  OpenGLDemo
+//
+//  Created by SeacenLiu on 2020/2/23.
+//  Copyright © 2020 SeacenLiu. All rights reserved.
+//
+
+/**
+ * 离屏（无窗口）渲染模式
+ *
+ * 渲染农场上既没有显示器也没有 GPU，GLFW 无法创建窗口。加上 --headless 参数后 demo 不再创建窗口，
+ * 而是通过 EGL 创建一个不带任何 surface 的 OpenGL 3.3 Core 上下文（Mesa 的 surfaceless 平台，
+ * llvmpipe 软件光栅化即可运行），渲染到指定分辨率的 FBO 中，渲染满指定帧数后退出：
+ *
+ *   --headless [宽x高]   开启离屏模式（默认 800x600）
+ *   --frames N          渲染的帧数（默认 HEADLESS_DEFAULT_FRAMES）
+ *   --dump FILE         把最后一帧保存为 PPM 图片；文件名中含 %d 或 %0Nd 时保存每一帧（如 frame_%04d.ppm），
+ *                       帧号占位符最多一个，%% 表示百分号，其他 % 格式不支持（忽略 --dump）
+ *
+ * 离屏模式下时间按固定步长推进（每帧 HEADLESS_FRAME_STEP 秒），相机沿 CameraPath 脚本运动，
+ * 不读取键盘和鼠标，同样的参数每次都渲染出同样的画面。每帧结束时 glFinish，
+ * 退出时输出每帧实际耗时（平均 / p50 / p99 / 最大），可以直接用于自动化性能测试。
+ *
+ * macOS 没有 EGL，退化为一个不可见的 GLFW 窗口，同样渲染到 FBO 中。Linux 下需要额外链接 libEGL。
+ */
+#ifndef headless_h
+#define headless_h
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include <glm/glm.hpp>
+
+#ifndef __APPLE__
+#define HEADLESS_USE_EGL
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#endif
+
+#include <vector>
+#include <string>
+#include <iostream>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cctype>
+#include <cmath>
+#include <chrono>
+#include <algorithm>
+
+#include "frame_histogram.h"
+
+#define HEADLESS_DEFAULT_WIDTH 800
+#define HEADLESS_DEFAULT_HEIGHT 600
+#define HEADLESS_DEFAULT_FRAMES 120
+// 离屏模式下每帧推进的时间（秒）
+#define HEADLESS_FRAME_STEP (1.0 / 60.0)
+// 脚本相机环绕一周的时间（秒）
+#define HEADLESS_ORBIT_PERIOD 8.0f
+
+// 脚本相机路径：在相机初始高度上绕目标点水平环绕，始终看向目标点
+class CameraPath {
+public:
+    CameraPath() : target(0.0f), radius(3.0f), height(0.0f), startAngle(0.0f) {}
+
+    // 以相机的初始位置确定环绕半径、高度和起始角度（时间 0 时相机就在初始位置）
+    void setOrbit(const glm::vec3 &orbitTarget, const glm::vec3 &start) {
+        glm::vec3 offset = start - orbitTarget;
+        target = orbitTarget;
+        radius = std::max(std::sqrt(offset.x * offset.x + offset.z * offset.z), 0.1f);
+        height = offset.y;
+        startAngle = std::atan2(offset.x, offset.z);
+    }
+
+    // 第 time 秒时相机的位置和朝向
+    void sample(float time, glm::vec3 &position, glm::vec3 &front) const {
+        float angle = startAngle + 2.0f * 3.14159265f * time / HEADLESS_ORBIT_PERIOD;
+        position = target + glm::vec3(std::sin(angle) * radius, height, std::cos(angle) * radius);
+        front = glm::normalize(target - position);
+    }
+
+    // 驱动 Camera 类：设置位置和欧拉角，再由 ProcessMouseMovement 重新计算 Front/Right/Up
+    template <typename CameraType>
+    void apply(CameraType &camera, float time) const {
+        glm::vec3 position, front;
+        sample(time, position, front);
+        camera.Position = position;
+        camera.Yaw = glm::degrees(std::atan2(front.z, front.x));
+        camera.Pitch = glm::degrees(std::asin(front.y));
+        camera.ProcessMouseMovement(0.0f, 0.0f);
+    }
+
+private:
+    glm::vec3 target;
+    float radius;
+    float height;
+    float startAngle;
+};
+
+class Headless {
+public:
+    static Headless &instance() {
+        static Headless headless;
+        return headless;
+    }
+
+    // 解析离屏模式的参数（其余参数原样留给 demo 自己处理）
+    void parseArguments(int argc, const char * argv[]) {
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            if (arg == "--headless") {
+                active = true;
+                unsigned int w, h;
+                if (i + 1 < argc && sscanf(argv[i + 1], "%ux%u", &w, &h) == 2 && w > 0 && h > 0) {
+                    outputWidth = w;
+                    outputHeight = h;
+                    ++i;
+                }
+            } else if (arg == "--frames" && i + 1 < argc) {
+                frameCount = (unsigned int)std::max(1, atoi(argv[++i]));
+            } else if (arg == "--dump" && i + 1 < argc) {
+                dumpPath = argv[++i];
+                if (!parseDumpPattern(dumpPath)) {
+                    std::cout << "ERROR::HEADLESS::unsupported --dump pattern " << dumpPath << std::endl;
+                    dumpPath.clear();
+                }
+            }
+        }
+    }
+
+    bool enabled() const {
+        return active;
+    }
+    unsigned int width() const {
+        return outputWidth;
+    }
+    unsigned int height() const {
+        return outputHeight;
+    }
+    // 离屏模式渲染用的 FBO（窗口模式下为默认帧缓冲 0），原本绑定回 0 的地方改为绑定它
+    unsigned int framebuffer() const {
+        return FBO;
+    }
+    // 投影矩阵的宽高比：离屏模式下按输出分辨率，窗口模式下原样返回
+    float aspect(float windowAspect) const {
+        return active ? (float)outputWidth / (float)outputHeight : windowAspect;
+    }
+    CameraPath &cameraPath() {
+        return path;
+    }
+
+    // 创建离屏上下文、加载 GLAD 并绑定 FBO（代替 glfwCreateWindow + gladLoadGLLoader）
+    bool initialize() {
+        if (!createContext())
+            return false;
+        glGenFramebuffers(1, &FBO);
+        glBindFramebuffer(GL_FRAMEBUFFER, FBO);
+        glGenRenderbuffers(1, &colorRBO);
+        glBindRenderbuffer(GL_RENDERBUFFER, colorRBO);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, outputWidth, outputHeight);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, colorRBO);
+        // 深度和模板（多光源 demo 的延迟渲染在光照阶段使用模板）
+        glGenRenderbuffers(1, &depthRBO);
+        glBindRenderbuffer(GL_RENDERBUFFER, depthRBO);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, outputWidth, outputHeight);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, depthRBO);
+        glBindRenderbuffer(GL_RENDERBUFFER, 0);
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+            std::cout << "ERROR::HEADLESS::framebuffer incomplete" << std::endl;
+            return false;
+        }
+        glViewport(0, 0, outputWidth, outputHeight);
+        std::cout << "离屏渲染: " << outputWidth << "x" << outputHeight << ", " << frameCount << " 帧, "
+                  << glGetString(GL_RENDERER) << std::endl;
+        return true;
+    }
+
+    // 修改离屏模式渲染的帧数（例如回放相机轨迹时等于轨迹长度）
+    void setFrameCount(unsigned int count) {
+        frameCount = std::max(1u, count);
+    }
+
+    // 渲染循环条件：窗口模式下直到窗口关闭，离屏模式下渲染满指定帧数
+    bool running(GLFWwindow *window) {
+        if (!active)
+            return !glfwWindowShouldClose(window);
+        if (frame == 0)
+            frameStart = std::chrono::steady_clock::now();
+        return frame < frameCount;
+    }
+
+    // 离屏模式下结束一帧（代替 glfwSwapBuffers + glfwPollEvents）：等待渲染完成、记录耗时、按需保存图片
+    void present() {
+        glFinish();
+        std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+        lastFrameMs = std::chrono::duration<double, std::milli>(now - frameStart).count();
+        frameTimes.add(lastFrameMs);
+        if (!dumpPath.empty() && (dumpDigits >= 0 || frame + 1 == frameCount))
+            dump();
+        ++frame;
+        // 保存图片的耗时不计入下一帧
+        frameStart = std::chrono::steady_clock::now();
+    }
+
+    // 当前时间（秒）：离屏模式下按帧号固定步长推进
+    double time() const {
+        return active ? frame * HEADLESS_FRAME_STEP : glfwGetTime();
+    }
+    // 离屏模式下最近一帧的实际耗时（毫秒）
+    double lastFrameMilliseconds() const {
+        return lastFrameMs;
+    }
+
+    // 输出帧耗时统计并销毁 FBO 和上下文（在 glfwTerminate 之前调用）
+    void release() {
+        if (!active)
+            return;
+        if (frameTimes.count() > 0) {
+            std::cout << "离屏渲染帧耗时: " << frameTimes.count() << " 帧, 平均 " << frameTimes.average() << " ms, p50 "
+                      << frameTimes.percentile(50.0) << " ms, p99 " << frameTimes.percentile(99.0) << " ms, 最大 "
+                      << frameTimes.maximum() << " ms" << std::endl;
+            frameTimes.clear();
+        }
+        if (FBO) {
+            glDeleteFramebuffers(1, &FBO);
+            glDeleteRenderbuffers(1, &colorRBO);
+            glDeleteRenderbuffers(1, &depthRBO);
+            FBO = colorRBO = depthRBO = 0;
+        }
+        destroyContext();
+    }
+
+private:
+    bool active;
+    unsigned int outputWidth, outputHeight;
+    unsigned int frameCount, frame;
+    std::string dumpPath;
+    // 解析后的 --dump 文件名：前缀 + 帧号（补零到 dumpDigits 位，-1 表示没有帧号）+ 后缀
+    std::string dumpPrefix, dumpSuffix;
+    int dumpDigits;
+    unsigned int FBO, colorRBO, depthRBO;
+    CameraPath path;
+    FrameTimeHistogram frameTimes;
+    double lastFrameMs;
+    std::chrono::steady_clock::time_point frameStart;
+#ifdef HEADLESS_USE_EGL
+    EGLDisplay display;
+    EGLContext context;
+#else
+    GLFWwindow *hiddenWindow;
+#endif
+
+    Headless() : active(false), outputWidth(HEADLESS_DEFAULT_WIDTH), outputHeight(HEADLESS_DEFAULT_HEIGHT),
+                 frameCount(HEADLESS_DEFAULT_FRAMES), frame(0), dumpDigits(-1), FBO(0), colorRBO(0), depthRBO(0),
+                 lastFrameMs(0.0),
+#ifdef HEADLESS_USE_EGL
+                 display(EGL_NO_DISPLAY), context(EGL_NO_CONTEXT) {}
+#else
+                 hiddenWindow(NULL) {}
+#endif
+    Headless(const Headless &) = delete;
+    Headless &operator=(const Headless &) = delete;
+
+#ifdef HEADLESS_USE_EGL
+    bool createContext() {
+        // 优先使用 surfaceless 平台（不需要 X11/Wayland），不支持时退回默认显示
+        PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay =
+            (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+        if (getPlatformDisplay)
+            display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL);
+        if (display == EGL_NO_DISPLAY)
+            display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+        EGLint major, minor;
+        if (display == EGL_NO_DISPLAY || !eglInitialize(display, &major, &minor)) {
+            std::cout << "ERROR::HEADLESS::EGL initialize failed" << std::endl;
+            return false;
+        }
+        // EGL_SURFACE_TYPE 默认要求窗口，surfaceless 平台只提供 pbuffer 配置（实际不会创建 surface）
+        const EGLint configAttributes[] = {
+            EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+            EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+            EGL_NONE
+        };
+        EGLConfig config;
+        EGLint configCount = 0;
+        if (!eglBindAPI(EGL_OPENGL_API) ||
+            !eglChooseConfig(display, configAttributes, &config, 1, &configCount) || configCount == 0) {
+            std::cout << "ERROR::HEADLESS::no OpenGL EGL config" << std::endl;
+            return false;
+        }
+        // 与窗口模式相同的 3.3 Core 上下文
+        const EGLint contextAttributes[] = {
+            EGL_CONTEXT_MAJOR_VERSION_KHR, 3,
+            EGL_CONTEXT_MINOR_VERSION_KHR, 3,
+            EGL_CONTEXT_OPENGL_PROFILE_MASK_KHR, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT_KHR,
+            EGL_NONE
+        };
+        context = eglCreateContext(display, config, EGL_NO_CONTEXT, contextAttributes);
+        // 不绑定任何 surface（EGL_KHR_surfaceless_context），所有渲染都进入 FBO
+        if (context == EGL_NO_CONTEXT || !eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context)) {
+            std::cout << "ERROR::HEADLESS::EGL context creation failed" << std::endl;
+            return false;
+        }
+        if (!gladLoadGLLoader((GLADloadproc)eglGetProcAddress)) {
+            std::cout << "初始化 GLAD 拓展失败" << std::endl;
+            return false;
+        }
+        return true;
+    }
+    void destroyContext() {
+        if (display == EGL_NO_DISPLAY)
+            return;
+        eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+        if (context != EGL_NO_CONTEXT)
+            eglDestroyContext(display, context);
+        eglTerminate(display);
+        display = EGL_NO_DISPLAY;
+        context = EGL_NO_CONTEXT;
+    }
+#else
+    bool createContext() {
+        glfwInit();
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+        glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+        glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+        glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+        hiddenWindow = glfwCreateWindow(1, 1, "headless", NULL, NULL);
+        if (hiddenWindow == NULL) {
+            std::cout << "ERROR::HEADLESS::hidden window creation failed" << std::endl;
+            return false;
+        }
+        glfwMakeContextCurrent(hiddenWindow);
+        if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
+            std::cout << "初始化 GLAD 拓展失败" << std::endl;
+            return false;
+        }
+        return true;
+    }
+    void destroyContext() {
+        if (hiddenWindow)
+            glfwDestroyWindow(hiddenWindow);
+        hiddenWindow = NULL;
+    }
+#endif
+
+    // 拆分 --dump 的文件名（不把它当作 printf 格式串）：%d / %0Nd 为帧号，%% 为百分号，其余的 % 都不接受
+    bool parseDumpPattern(const std::string &pattern) {
+        dumpPrefix.clear();
+        dumpSuffix.clear();
+        dumpDigits = -1;
+        std::string *out = &dumpPrefix;
+        for (size_t i = 0; i < pattern.size(); ++i) {
+            if (pattern[i] != '%') {
+                *out += pattern[i];
+                continue;
+            }
+            if (i + 1 < pattern.size() && pattern[i + 1] == '%') {
+                *out += '%';
+                ++i;
+                continue;
+            }
+            size_t j = i + 1;
+            int digits = 0;
+            if (j < pattern.size() && pattern[j] == '0') {
+                while (++j < pattern.size() && isdigit((unsigned char)pattern[j]))
+                    digits = digits * 10 + (pattern[j] - '0');
+                if (digits == 0 || digits > 16)
+                    return false;
+            }
+            if (dumpDigits >= 0 || j >= pattern.size() || pattern[j] != 'd')
+                return false;
+            dumpDigits = digits;
+            out = &dumpSuffix;
+            i = j;
+        }
+        return true;
+    }
+
+    // 读回 FBO 的颜色并写成二进制 PPM（OpenGL 的行序自下而上，写文件时翻转）
+    void dump() {
+        std::string filename = dumpPrefix;
+        if (dumpDigits >= 0) {
+            std::string number = std::to_string(frame);
+            if ((int)number.size() < dumpDigits)
+                number.insert(0, dumpDigits - number.size(), '0');
+            filename += number + dumpSuffix;
+        }
+        std::vector<unsigned char> pixels((size_t)outputWidth * outputHeight * 3);
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, FBO);
+        glPixelStorei(GL_PACK_ALIGNMENT, 1);
+        glReadPixels(0, 0, outputWidth, outputHeight, GL_RGB, GL_UNSIGNED_BYTE, pixels.data());
+        FILE *file = fopen(filename.c_str(), "wb");
+        if (!file) {
+            std::cout << "ERROR::HEADLESS::failed to write " << filename << std::endl;
+            return;
+        }
+        fprintf(file, "P6\n%u %u\n255\n", outputWidth, outputHeight);
+        for (unsigned int row = outputHeight; row-- > 0;)
+            fwrite(&pixels[(size_t)row * outputWidth * 3], 1, (size_t)outputWidth * 3, file);
+        fclose(file);
+    }
+};
+
+#endif /* headless_h */
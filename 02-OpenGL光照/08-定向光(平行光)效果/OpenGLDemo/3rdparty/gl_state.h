@@ -0,0 +1,242 @@
+//
+//  gl_state.h
+//  OpenGLDemo
+//
+//  Created by SeacenLiu on 2020/2/12.
+//  Copyright © 2020 SeacenLiu. All rights reserved.
+//
+
+/**
+ * OpenGL 状态缓存
+ *
+ * 记录当前绑定的着色器程序、VAO、每个纹理单元上的纹理、缓冲对象和开关状态，
+ * 要设置的值与当前值相同时直接跳过，不再调用 OpenGL（驱动开销主要来自这些冗余绑定）。
+ * 所有工具类和渲染循环都通过 GLState::instance() 修改这些状态，
+ * 绕过它直接修改状态之后需要调用 invalidate()，否则缓存会与实际状态不一致。
+ *
+ * 注意：
+ * - GL_ELEMENT_ARRAY_BUFFER 的绑定属于 VAO 状态，不做缓存（每次都调用）
+ * - 删除对象要通过 deleteXXX，已删除的名字可能被重新分配，缓存中对应的绑定需要清零
+ * - frameStats() 返回上次调用以来实际发出和跳过的调用次数，并清零计数
+ */
+#ifndef gl_state_h
+#define gl_state_h
+
+#include <glad/glad.h>
+
+// 缓存的纹理单元数量（更大的单元号直接调用 OpenGL）
+#define GL_STATE_TEXTURE_UNITS 32
+// 未知状态（第一次设置时一定会调用 OpenGL）
+#define GL_STATE_UNKNOWN 0xFFFFFFFFu
+
+// 状态调用统计
+struct GLStateStats {
+    unsigned long callsIssued;  // 实际调用 OpenGL 的次数
+    unsigned long callsElided;  // 因状态未变化而跳过的次数
+};
+
+class GLState {
+public:
+    // 当前上下文的状态缓存（示例中只有一个上下文）
+    static GLState &instance() {
+        static GLState state;
+        return state;
+    }
+    static GLStateStats frameStats() {
+        GLStateStats s = instance().stats;
+        instance().stats = GLStateStats{ 0, 0 };
+        return s;
+    }
+
+    // 着色器程序
+    void useProgram(GLuint program) {
+        if (program == currentProgram) {
+            ++stats.callsElided;
+            return;
+        }
+        currentProgram = program;
+        ++stats.callsIssued;
+        glUseProgram(program);
+    }
+    // 顶点数组对象
+    void bindVertexArray(GLuint vao) {
+        if (vao == currentVertexArray) {
+            ++stats.callsElided;
+            return;
+        }
+        currentVertexArray = vao;
+        ++stats.callsIssued;
+        glBindVertexArray(vao);
+    }
+    // 激活纹理单元（unit 从 0 开始，不是 GL_TEXTURE0 + unit）
+    void activeTexture(GLuint unit) {
+        if (unit == activeUnit) {
+            ++stats.callsElided;
+            return;
+        }
+        activeUnit = unit;
+        ++stats.callsIssued;
+        glActiveTexture(GL_TEXTURE0 + unit);
+    }
+    // 把纹理绑定到指定纹理单元（已经绑定时连 glActiveTexture 也跳过）
+    void bindTexture(GLuint unit, GLenum target, GLuint texture) {
+        int slot = textureSlot(target);
+        if (slot >= 0 && unit < GL_STATE_TEXTURE_UNITS) {
+            if (textures[unit][slot] == texture) {
+                ++stats.callsElided;
+                return;
+            }
+            textures[unit][slot] = texture;
+        }
+        activeTexture(unit);
+        ++stats.callsIssued;
+        glBindTexture(target, texture);
+    }
+    // 把纹理绑定到当前激活的纹理单元（创建、上传纹理时使用）
+    void bindTexture(GLenum target, GLuint texture) {
+        if (activeUnit == GL_STATE_UNKNOWN)
+            activeTexture(0);
+        bindTexture(activeUnit, target, texture);
+    }
+    // 缓冲对象
+    void bindBuffer(GLenum target, GLuint buffer) {
+        int slot = bufferSlot(target);
+        if (slot >= 0) {
+            if (buffers[slot] == buffer) {
+                ++stats.callsElided;
+                return;
+            }
+            buffers[slot] = buffer;
+        }
+        ++stats.callsIssued;
+        glBindBuffer(target, buffer);
+    }
+    // 绑定到索引绑定点（同时会修改 target 的通用绑定）
+    void bindBufferBase(GLenum target, GLuint index, GLuint buffer) {
+        int slot = bufferSlot(target);
+        if (slot >= 0)
+            buffers[slot] = buffer;
+        ++stats.callsIssued;
+        glBindBufferBase(target, index, buffer);
+    }
+    // 开关状态（glEnable / glDisable）
+    void enable(GLenum cap) {
+        setEnabled(cap, true);
+    }
+    void disable(GLenum cap) {
+        setEnabled(cap, false);
+    }
+    void setEnabled(GLenum cap, bool value) {
+        int slot = capabilitySlot(cap);
+        if (slot >= 0) {
+            GLuint state = value ? 1 : 0;
+            if (capabilities[slot] == state) {
+                ++stats.callsElided;
+                return;
+            }
+            capabilities[slot] = state;
+        }
+        ++stats.callsIssued;
+        if (value)
+            glEnable(cap);
+        else
+            glDisable(cap);
+    }
+    // 删除对象（被删除的对象如果正在绑定，绑定会变回 0）
+    void deleteTextures(GLsizei n, const GLuint *ids) {
+        for (GLsizei i = 0; i < n; ++i)
+            for (unsigned int unit = 0; unit < GL_STATE_TEXTURE_UNITS; ++unit)
+                for (int slot = 0; slot < TEXTURE_SLOTS; ++slot)
+                    if (textures[unit][slot] == ids[i])
+                        textures[unit][slot] = 0;
+        glDeleteTextures(n, ids);
+    }
+    void deleteBuffers(GLsizei n, const GLuint *ids) {
+        for (GLsizei i = 0; i < n; ++i)
+            for (int slot = 0; slot < BUFFER_SLOTS; ++slot)
+                if (buffers[slot] == ids[i])
+                    buffers[slot] = 0;
+        glDeleteBuffers(n, ids);
+    }
+    void deleteVertexArrays(GLsizei n, const GLuint *ids) {
+        for (GLsizei i = 0; i < n; ++i)
+            if (currentVertexArray == ids[i])
+                currentVertexArray = 0;
+        glDeleteVertexArrays(n, ids);
+    }
+    void deleteProgram(GLuint program) {
+        // 正在使用的程序删除后仍然是当前程序，但名字释放后可能被重新分配
+        if (currentProgram == program)
+            currentProgram = GL_STATE_UNKNOWN;
+        glDeleteProgram(program);
+    }
+    // 外部直接修改了 OpenGL 状态后调用，下次设置时全部重新调用
+    void invalidate() {
+        currentProgram = currentVertexArray = activeUnit = GL_STATE_UNKNOWN;
+        for (unsigned int unit = 0; unit < GL_STATE_TEXTURE_UNITS; ++unit)
+            for (int slot = 0; slot < TEXTURE_SLOTS; ++slot)
+                textures[unit][slot] = GL_STATE_UNKNOWN;
+        for (int slot = 0; slot < BUFFER_SLOTS; ++slot)
+            buffers[slot] = GL_STATE_UNKNOWN;
+        for (int slot = 0; slot < CAPABILITY_SLOTS; ++slot)
+            capabilities[slot] = GL_STATE_UNKNOWN;
+    }
+
+private:
+    enum { TEXTURE_SLOTS = 5, BUFFER_SLOTS = 6, CAPABILITY_SLOTS = 10 };
+    GLuint currentProgram;
+    GLuint currentVertexArray;
+    GLuint activeUnit;
+    GLuint textures[GL_STATE_TEXTURE_UNITS][TEXTURE_SLOTS];
+    GLuint buffers[BUFFER_SLOTS];
+    GLuint capabilities[CAPABILITY_SLOTS];
+    GLStateStats stats;
+
+    GLState() : stats(GLStateStats{ 0, 0 }) {
+        invalidate();
+    }
+    GLState(const GLState &);
+    GLState &operator=(const GLState &);
+
+    // 缓存的纹理目标（其余目标不缓存）
+    static int textureSlot(GLenum target) {
+        switch (target) {
+            case GL_TEXTURE_2D:       return 0;
+            case GL_TEXTURE_CUBE_MAP: return 1;
+            case GL_TEXTURE_BUFFER:   return 2;
+            case GL_TEXTURE_2D_ARRAY: return 3;
+            case GL_TEXTURE_3D:       return 4;
+            default:                  return -1;
+        }
+    }
+    // 缓存的缓冲目标（GL_ELEMENT_ARRAY_BUFFER 属于 VAO 状态，不缓存）
+    static int bufferSlot(GLenum target) {
+        switch (target) {
+            case GL_ARRAY_BUFFER:        return 0;
+            case GL_UNIFORM_BUFFER:      return 1;
+            case GL_TEXTURE_BUFFER:      return 2;
+            case GL_PIXEL_UNPACK_BUFFER: return 3;
+            case GL_PIXEL_PACK_BUFFER:   return 4;
+            case GL_COPY_WRITE_BUFFER:   return 5;
+            default:                     return -1;
+        }
+    }
+    // 缓存的开关状态
+    static int capabilitySlot(GLenum cap) {
+        switch (cap) {
+            case GL_DEPTH_TEST:          return 0;
+            case GL_STENCIL_TEST:        return 1;
+            case GL_BLEND:               return 2;
+            case GL_CULL_FACE:           return 3;
+            case GL_SCISSOR_TEST:        return 4;
+            case GL_POLYGON_OFFSET_FILL: return 5;
+            case GL_FRAMEBUFFER_SRGB:    return 6;
+            case GL_MULTISAMPLE:         return 7;
+            case GL_PROGRAM_POINT_SIZE:  return 8;
+            case GL_DEPTH_CLAMP:         return 9;
+            default:                     return -1;
+        }
+    }
+};
+
+#endif /* gl_state_h */
@@ -0,0 +1,252 @@
+//
+//  frustum.h
+//  OpenGLDemo
+//
+//  Created by SeacenLiu on 2020/2/16.
+//  Copyright © 2020 SeacenLiu. All rights reserved.
+//
+
+/**
+ * 视锥体剔除
+ *
+ * - AABB：轴对齐包围盒，TransformAABB 把局部包围盒变换到另一个空间（Arvo 方法，不需要变换 8 个顶点）
+ * - Frustum：从矩阵中提取 6 个裁剪平面（Gribb-Hartmann 方法）。
+ *   传入 projection * view 得到世界空间的平面，传入 MVP 得到物体空间的平面
+ *   （这样物体空间的包围盒不需要变换就能直接测试）
+ * - CullingSet：按 SoA（中心、半边长各分量分开存放）保存一组包围盒，
+ *   支持 AVX 时一次测试 8 个，支持 SSE 时一次 4 个，否则逐个测试
+ *
+ * 包围盒中心到平面的距离加上包围盒在平面法向量上的投影半径小于 0 时，包围盒完全在平面外侧，被剔除。
+ * 测试是保守的：视锥体角落附近的包围盒可能被判定为可见，但可见的包围盒一定不会被剔除。
+ */
+#ifndef frustum_h
+#define frustum_h
+
+#include <glm/glm.hpp>
+
+#include <cfloat>
+#include <cmath>
+#include <vector>
+#include <algorithm>
+#if defined(__AVX__)
+#include <immintrin.h>
+#elif defined(__SSE__)
+#include <xmmintrin.h>
+#endif
+
+// 轴对齐包围盒（默认是空包围盒）
+struct AABB {
+    glm::vec3 min, max;
+
+    AABB() : min(glm::vec3(FLT_MAX)), max(glm::vec3(-FLT_MAX)) {}
+    AABB(const glm::vec3 &min, const glm::vec3 &max) : min(min), max(max) {}
+
+    bool empty() const {
+        return min.x > max.x || min.y > max.y || min.z > max.z;
+    }
+    void expand(const glm::vec3 &point) {
+        for (int k = 0; k < 3; ++k) {
+            min[k] = std::min(min[k], point[k]);
+            max[k] = std::max(max[k], point[k]);
+        }
+    }
+    void expand(const AABB &other) {
+        if (other.empty())
+            return;
+        expand(other.min);
+        expand(other.max);
+    }
+    glm::vec3 center() const {
+        return empty() ? glm::vec3(0.0f) : (min + max) * 0.5f;
+    }
+    // 半边长
+    glm::vec3 extent() const {
+        return empty() ? glm::vec3(0.0f) : (max - min) * 0.5f;
+    }
+};
+
+// 变换包围盒：新中心 = M * 中心，新半边长 = |M 的左上角 3x3| * 半边长
+inline AABB TransformAABB(const AABB &box, const glm::mat4 &matrix) {
+    if (box.empty())
+        return box;
+    glm::vec3 c = box.center(), e = box.extent();
+    glm::vec3 center, extent;
+    for (int r = 0; r < 3; ++r) {
+        center[r] = matrix[0][r] * c.x + matrix[1][r] * c.y + matrix[2][r] * c.z + matrix[3][r];
+        extent[r] = std::fabs(matrix[0][r]) * e.x + std::fabs(matrix[1][r]) * e.y + std::fabs(matrix[2][r]) * e.z;
+    }
+    return AABB(center - extent, center + extent);
+}
+
+// 视锥体（6 个平面 ax + by + cz + d >= 0 为内侧）
+class Frustum {
+public:
+    enum { PLANE_LEFT, PLANE_RIGHT, PLANE_BOTTOM, PLANE_TOP, PLANE_NEAR, PLANE_FAR, PLANE_COUNT };
+    glm::vec4 planes[PLANE_COUNT];
+
+    // 默认不剔除任何东西
+    Frustum() {
+        for (int i = 0; i < PLANE_COUNT; ++i)
+            planes[i] = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+    }
+    // 从裁剪矩阵提取（projection * view 得到世界空间平面，MVP 得到物体空间平面）
+    explicit Frustum(const glm::mat4 &clip) {
+        extract(clip);
+    }
+    // 从相机的视图矩阵和投影矩阵提取世界空间平面
+    Frustum(const glm::mat4 &projection, const glm::mat4 &view) {
+        extract(projection * view);
+    }
+    void extract(const glm::mat4 &m) {
+        // 矩阵的第 i 行（glm 按列存储）
+        glm::vec4 row[4];
+        for (int i = 0; i < 4; ++i)
+            row[i] = glm::vec4(m[0][i], m[1][i], m[2][i], m[3][i]);
+        // -w <= x, y, z <= w
+        planes[PLANE_LEFT] = row[3] + row[0];
+        planes[PLANE_RIGHT] = row[3] - row[0];
+        planes[PLANE_BOTTOM] = row[3] + row[1];
+        planes[PLANE_TOP] = row[3] - row[1];
+        planes[PLANE_NEAR] = row[3] + row[2];
+        planes[PLANE_FAR] = row[3] - row[2];
+        for (int i = 0; i < PLANE_COUNT; ++i) {
+            glm::vec4 &p = planes[i];
+            float length = std::sqrt(p.x * p.x + p.y * p.y + p.z * p.z);
+            if (length > 0.0f)
+                p = p / length;
+        }
+    }
+    // 单个包围盒是否（可能）可见
+    bool intersects(const AABB &box) const {
+        if (box.empty())
+            return false;
+        glm::vec3 c = box.center(), e = box.extent();
+        for (int i = 0; i < PLANE_COUNT; ++i) {
+            const glm::vec4 &p = planes[i];
+            float distance = p.x * c.x + p.y * c.y + p.z * c.z + p.w;
+            float radius = std::fabs(p.x) * e.x + std::fabs(p.y) * e.y + std::fabs(p.z) * e.z;
+            if (distance + radius < 0.0f)
+                return false;
+        }
+        return true;
+    }
+};
+
+// 剔除统计
+struct CullStats {
+    unsigned long visible;
+    unsigned long culled;
+};
+
+// 一组包围盒（SoA），批量做视锥体剔除
+class CullingSet {
+public:
+    CullingSet() : count(0) {}
+
+    void clear() {
+        count = 0;
+        for (int k = 0; k < 6; ++k)
+            soa[k].clear();
+    }
+    void reserve(size_t n) {
+        for (int k = 0; k < 6; ++k)
+            soa[k].reserve(padded(n));
+    }
+    size_t size() const {
+        return count;
+    }
+    // 设置第 index 个包围盒（超出当前数量时自动扩充，空包围盒永远不可见）
+    void set(size_t index, const AABB &box) {
+        if (index >= count) {
+            count = index + 1;
+            for (int k = 0; k < 6; ++k)
+                soa[k].resize(padded(count), 0.0f);
+        }
+        glm::vec3 c = box.center(), e = box.extent();
+        if (box.empty())
+            e = glm::vec3(-FLT_MAX * 0.25f);
+        for (int k = 0; k < 3; ++k) {
+            soa[k][index] = c[k];
+            soa[3 + k][index] = e[k];
+        }
+    }
+    void add(const AABB &box) {
+        set(count, box);
+    }
+    // 测试所有包围盒，visible[i] 为 1 表示可见，返回可见数量
+    size_t cull(const Frustum &frustum, std::vector<unsigned char> &visible) const {
+        visible.resize(count);
+        size_t visibleCount = 0;
+        const float *cx = soa[0].data(), *cy = soa[1].data(), *cz = soa[2].data();
+        const float *ex = soa[3].data(), *ey = soa[4].data(), *ez = soa[5].data();
+        size_t i = 0;
+#if defined(__AVX__)
+        for (; i < count; i += 8) {
+            __m256 outside = _mm256_setzero_ps();
+            for (int p = 0; p < Frustum::PLANE_COUNT; ++p) {
+                const glm::vec4 &plane = frustum.planes[p];
+                __m256 d = _mm256_set1_ps(plane.w);
+                d = _mm256_add_ps(d, _mm256_mul_ps(_mm256_set1_ps(plane.x), _mm256_loadu_ps(cx + i)));
+                d = _mm256_add_ps(d, _mm256_mul_ps(_mm256_set1_ps(plane.y), _mm256_loadu_ps(cy + i)));
+                d = _mm256_add_ps(d, _mm256_mul_ps(_mm256_set1_ps(plane.z), _mm256_loadu_ps(cz + i)));
+                d = _mm256_add_ps(d, _mm256_mul_ps(_mm256_set1_ps(std::fabs(plane.x)), _mm256_loadu_ps(ex + i)));
+                d = _mm256_add_ps(d, _mm256_mul_ps(_mm256_set1_ps(std::fabs(plane.y)), _mm256_loadu_ps(ey + i)));
+                d = _mm256_add_ps(d, _mm256_mul_ps(_mm256_set1_ps(std::fabs(plane.z)), _mm256_loadu_ps(ez + i)));
+                outside = _mm256_or_ps(outside, _mm256_cmp_ps(d, _mm256_setzero_ps(), _CMP_LT_OQ));
+            }
+            visibleCount += store(~_mm256_movemask_ps(outside), i, 8, visible);
+        }
+#elif defined(__SSE__)
+        for (; i < count; i += 4) {
+            __m128 outside = _mm_setzero_ps();
+            for (int p = 0; p < Frustum::PLANE_COUNT; ++p) {
+                const glm::vec4 &plane = frustum.planes[p];
+                __m128 d = _mm_set1_ps(plane.w);
+                d = _mm_add_ps(d, _mm_mul_ps(_mm_set1_ps(plane.x), _mm_loadu_ps(cx + i)));
+                d = _mm_add_ps(d, _mm_mul_ps(_mm_set1_ps(plane.y), _mm_loadu_ps(cy + i)));
+                d = _mm_add_ps(d, _mm_mul_ps(_mm_set1_ps(plane.z), _mm_loadu_ps(cz + i)));
+                d = _mm_add_ps(d, _mm_mul_ps(_mm_set1_ps(std::fabs(plane.x)), _mm_loadu_ps(ex + i)));
+                d = _mm_add_ps(d, _mm_mul_ps(_mm_set1_ps(std::fabs(plane.y)), _mm_loadu_ps(ey + i)));
+                d = _mm_add_ps(d, _mm_mul_ps(_mm_set1_ps(std::fabs(plane.z)), _mm_loadu_ps(ez + i)));
+                outside = _mm_or_ps(outside, _mm_cmplt_ps(d, _mm_setzero_ps()));
+            }
+            visibleCount += store(~_mm_movemask_ps(outside), i, 4, visible);
+        }
+#else
+        for (; i < count; ++i) {
+            bool inside = true;
+            for (int p = 0; p < Frustum::PLANE_COUNT && inside; ++p) {
+                const glm::vec4 &plane = frustum.planes[p];
+                float d = plane.x * cx[i] + plane.y * cy[i] + plane.z * cz[i] + plane.w
+                        + std::fabs(plane.x) * ex[i] + std::fabs(plane.y) * ey[i] + std::fabs(plane.z) * ez[i];
+                inside = d >= 0.0f;
+            }
+            visible[i] = inside ? 1 : 0;
+            visibleCount += inside ? 1 : 0;
+        }
+#endif
+        return visibleCount;
+    }
+
+private:
+    // 中心 x、y、z，半边长 x、y、z（长度补齐到 8 的倍数，补齐部分的结果被忽略）
+    std::vector<float> soa[6];
+    size_t count;
+
+    static size_t padded(size_t n) {
+        return (n + 7) & ~(size_t)7;
+    }
+    // 把一组（width 个）测试结果的位掩码写入 visible，返回其中可见的数量
+    size_t store(int mask, size_t first, size_t width, std::vector<unsigned char> &visible) const {
+        size_t n = std::min(width, count - first);
+        size_t visibleCount = 0;
+        for (size_t j = 0; j < n; ++j) {
+            unsigned char bit = (unsigned char)((mask >> j) & 1);
+            visible[first + j] = bit;
+            visibleCount += bit;
+        }
+        return visibleCount;
+    }
+};
+
+#endif /* frustum_h */
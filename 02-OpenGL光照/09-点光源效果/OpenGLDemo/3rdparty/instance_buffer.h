@@ -0,0 +1,209 @@
+//
+//  instance_buffer.h
+//  OpenGLDemo
+//
+//  Created by SeacenLiu on 2020/2/7.
+//  Copyright © 2020 SeacenLiu. All rights reserved.
+//
+
+/**
+ * 实例化（Instancing）
+ * https://learnopengl-cn.github.io/04%20Advanced%20OpenGL/10%20Instancing/
+ *
+ * 每个实例的模型矩阵和法线矩阵放在同一个顶点缓冲中，作为实例化顶点属性（divisor = 1）：
+ * - location 3~6: 模型矩阵（4 个 vec4 列）
+ * - location 7~9: 法线矩阵（4x4 模型矩阵左上角的逆矩阵的转置，3 个 vec3 列）
+ * 所有实例用一次 glDrawArraysInstanced 绘制，法线矩阵只在实例变化时于 CPU 上计算一次
+ * （NormalMatrix，见 transform_stage.h），不需要在顶点着色器里逐顶点求逆。
+ *
+ * 数据只在修改后的下一次绘制时上传；容量不足时按 2 倍扩容，否则孤立（orphan）旧缓冲再整体写入。
+ *
+ * 设置了局部包围盒（setBounds）后可以调用 cull 做视锥体剔除（frustum.h）：
+ * 每个实例的世界空间包围盒在实例修改时计算，剔除后只把可见实例紧凑地写入实例缓冲，
+ * 可见集合没有变化时不重新上传。
+ */
+#ifndef instance_buffer_h
+#define instance_buffer_h
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <vector>
+#include <algorithm>
+
+#include "gl_state.h"
+#include "transform_stage.h"
+#include "frustum.h"
+
+// 实例化属性的起始位置（0~2 为位置、法向量、纹理坐标）
+#define INSTANCE_MODEL_LOCATION  3
+#define INSTANCE_NORMAL_LOCATION 7
+
+// 单个实例的数据（与着色器中的实例化属性一一对应）
+struct InstanceData {
+    glm::mat4 model;        // 模型矩阵
+    glm::mat3 normalMatrix; // 法线矩阵
+};
+
+static_assert(sizeof(InstanceData) == 100, "InstanceData must be tightly packed");
+
+class InstanceBuffer {
+public:
+    // 实例缓冲的 ID
+    unsigned int VBO;
+
+    // 构造函数（需要在 OpenGL 上下文创建之后调用）
+    InstanceBuffer() : capacity(0), dirty(false), culling(false) {
+        glGenBuffers(1, &VBO);
+    }
+    // 释放 OpenGL 资源
+    void release() {
+        GLState::instance().deleteBuffers(1, &VBO);
+    }
+    // 把实例化属性加入 VAO（VAO 中已配置好逐顶点属性）
+    void attach(unsigned int VAO) const {
+        GLState::instance().bindVertexArray(VAO);
+        GLState::instance().bindBuffer(GL_ARRAY_BUFFER, VBO);
+        GLsizei stride = sizeof(InstanceData);
+        for (int i = 0; i < 4; ++i) {
+            GLuint location = INSTANCE_MODEL_LOCATION + i;
+            glVertexAttribPointer(location, 4, GL_FLOAT, GL_FALSE, stride,
+                                  (void*)(offsetof(InstanceData, model) + i * sizeof(glm::vec4)));
+            glEnableVertexAttribArray(location);
+            glVertexAttribDivisor(location, 1);
+        }
+        for (int i = 0; i < 3; ++i) {
+            GLuint location = INSTANCE_NORMAL_LOCATION + i;
+            glVertexAttribPointer(location, 3, GL_FLOAT, GL_FALSE, stride,
+                                  (void*)(offsetof(InstanceData, normalMatrix) + i * sizeof(glm::vec3)));
+            glEnableVertexAttribArray(location);
+            glVertexAttribDivisor(location, 1);
+        }
+        GLState::instance().bindVertexArray(0);
+    }
+    // 设置实例几何体的局部包围盒（之后添加、修改的实例会计算世界空间包围盒）
+    void setBounds(const AABB &bounds) {
+        localBounds = bounds;
+        for (unsigned int i = 0; i < instances.size(); ++i)
+            boxes.set(i, TransformAABB(localBounds, instances[i].model));
+    }
+    // 清空实例
+    void clear() {
+        instances.clear();
+        boxes.clear();
+        visible.clear();
+        dirty = true;
+    }
+    // 预留空间（大量实例时避免反复扩容）
+    void reserve(size_t count) {
+        instances.reserve(count);
+        boxes.reserve(count);
+    }
+    // 添加实例，返回其下标
+    unsigned int add(const glm::mat4 &model) {
+        instances.push_back(InstanceData());
+        set((unsigned int)instances.size() - 1, model);
+        return (unsigned int)instances.size() - 1;
+    }
+    // 修改实例的模型矩阵（同时更新法线矩阵）
+    void set(unsigned int index, const glm::mat4 &model) {
+        instances[index].model = model;
+        instances[index].normalMatrix = NormalMatrix(model);
+        boxes.set(index, localBounds.empty() ? AABB() : TransformAABB(localBounds, model));
+        dirty = true;
+    }
+    // 实例数量
+    GLsizei size() const {
+        return (GLsizei)instances.size();
+    }
+    // 实例的模型矩阵
+    const glm::mat4 &model(unsigned int index) const {
+        return instances[index].model;
+    }
+    // 实例的局部包围盒和世界空间包围盒（例如用于建立 BVH 做拾取）
+    const AABB &bounds() const {
+        return localBounds;
+    }
+    AABB worldBounds(unsigned int index) const {
+        return TransformAABB(localBounds, instances[index].model);
+    }
+    // 视锥体剔除（每帧相机更新后、draw 之前调用），返回可见和被剔除的实例数量；
+    // 没有设置包围盒时所有实例都可见
+    CullStats cull(const Frustum &frustum) {
+        if (localBounds.empty()) {
+            if (culling)
+                dirty = true;
+            culling = false;
+            return CullStats{ instances.size(), 0 };
+        }
+        boxes.cull(frustum, mask);
+        // 可见实例的下标，与上一帧相同并且实例没有修改时不需要重新上传
+        bool changed = dirty || !culling;
+        size_t n = 0;
+        for (unsigned int i = 0; i < mask.size(); ++i) {
+            if (!mask[i])
+                continue;
+            if (n < visible.size()) {
+                if (visible[n] != i) {
+                    visible[n] = i;
+                    changed = true;
+                }
+            } else {
+                visible.push_back(i);
+                changed = true;
+            }
+            ++n;
+        }
+        if (n != visible.size()) {
+            visible.resize(n);
+            changed = true;
+        }
+        culling = true;
+        if (changed) {
+            compacted.clear();
+            for (unsigned int i = 0; i < visible.size(); ++i)
+                compacted.push_back(instances[visible[i]]);
+            dirty = true;
+        }
+        return CullStats{ visible.size(), instances.size() - visible.size() };
+    }
+    // 实际绘制的实例数量（剔除后为可见实例数量）
+    GLsizei drawCount() const {
+        return culling ? (GLsizei)visible.size() : size();
+    }
+    // 上传实例数据（没有修改时什么也不做）
+    void upload() {
+        if (!dirty)
+            return;
+        dirty = false;
+        const std::vector<InstanceData> &data = culling ? compacted : instances;
+        if (data.empty())
+            return;
+        GLState::instance().bindBuffer(GL_ARRAY_BUFFER, VBO);
+        if (data.size() > capacity)
+            capacity = std::max(data.size(), capacity * 2);
+        glBufferData(GL_ARRAY_BUFFER, capacity * sizeof(InstanceData), NULL, GL_DYNAMIC_DRAW);
+        glBufferSubData(GL_ARRAY_BUFFER, 0, data.size() * sizeof(InstanceData), &data[0]);
+    }
+    // 绘制所有（剔除后为可见的）实例（需先绑定 attach 过的 VAO）
+    void draw(GLenum mode, GLint first, GLsizei count) {
+        upload();
+        if (drawCount() > 0)
+            glDrawArraysInstanced(mode, first, count, drawCount());
+    }
+
+private:
+    std::vector<InstanceData> instances;
+    size_t capacity;
+    bool dirty;
+    // 视锥体剔除
+    AABB localBounds;                       // 实例几何体的局部包围盒
+    CullingSet boxes;                       // 每个实例的世界空间包围盒
+    std::vector<unsigned char> mask;        // 剔除结果
+    std::vector<unsigned int> visible;      // 可见实例的下标
+    std::vector<InstanceData> compacted;    // 可见实例的数据（紧凑排列）
+    bool culling;                           // 是否按剔除结果绘制
+};
+
+#endif /* instance_buffer_h */
@@ -0,0 +1,279 @@
+//
+//  texture_cache.h
+//  OpenGLDemo
+//
+//  Created by SeacenLiu on 2020/2/11.
+//  Copyright © 2020 SeacenLiu. All rights reserved.
+//
+
+/**
+ * 进程级纹理缓存
+ *
+ * 同一个纹理文件在整个进程中只解码、上传一次，所有使用者共享同一个纹理对象：
+ * - 以规范路径（realpath）为键查找，哈希表查找代替逐个比较路径
+ * - 路径不同但内容完全相同的文件（FNV-1a 内容哈希）同样共享
+ * - acquire 返回带引用计数的 TextureHandle，句柄拷贝/析构时自动增减引用
+ * - 引用计数归零的纹理不会立即删除，而是按最近使用顺序（LRU）保留，
+ *   总显存（估算值）超过预算时才从最久未使用的开始删除
+ *
+ * 缓存本身不负责解码，acquire 新建纹理时通过 created 告诉调用者需要上传数据，
+ * 调用者上传完成后调用 commit 登记尺寸（用于估算显存）。
+ * 释放句柄只修改引用计数，不调用 OpenGL（句柄可能在上下文销毁后才析构），
+ * 真正删除纹理只发生在 commit / setBudget / trim / clear 中。
+ */
+#ifndef texture_cache_h
+#define texture_cache_h
+
+#include <glad/glad.h>
+
+#include <cstdint>
+#include <climits>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <list>
+#include <fstream>
+#include <utility>
+#include <algorithm>
+#include <iostream>
+#include <unordered_map>
+
+#include "gl_state.h"
+
+// 默认显存预算（字节）
+#define TEXTURE_CACHE_DEFAULT_BUDGET (256u * 1024u * 1024u)
+
+class TextureCache;
+
+// 纹理句柄（引用计数）
+class TextureHandle {
+public:
+    TextureHandle() : textureID(0) {}
+    TextureHandle(const TextureHandle &other);
+    TextureHandle(TextureHandle &&other) : textureID(other.textureID) {
+        other.textureID = 0;
+    }
+    TextureHandle &operator=(TextureHandle other) {
+        std::swap(textureID, other.textureID);
+        return *this;
+    }
+    ~TextureHandle() {
+        reset();
+    }
+    // 纹理对象 ID（空句柄为 0）
+    unsigned int id() const {
+        return textureID;
+    }
+    bool valid() const {
+        return textureID != 0;
+    }
+    // 放弃引用
+    void reset();
+
+private:
+    friend class TextureCache;
+    unsigned int textureID;
+
+    // 由缓存创建（引用计数已经加过）
+    explicit TextureHandle(unsigned int id) : textureID(id) {}
+};
+
+class TextureCache {
+public:
+    // 命中统计
+    struct Stats {
+        unsigned int pathHits;      // 路径命中
+        unsigned int contentHits;   // 路径不同、内容相同
+        unsigned int misses;        // 新建纹理
+        unsigned int evictions;     // 因超出预算删除的纹理
+        size_t peakBytes;           // 显存占用峰值（估算）
+    };
+
+    // 进程内唯一的缓存（不析构，全局对象中的句柄在退出时仍可安全释放）
+    static TextureCache &instance() {
+        static TextureCache *cache = new TextureCache();
+        return *cache;
+    }
+
+    // 获取纹理；缓存中没有时生成新的纹理对象并把 *created 置为 true，
+    // 此时调用者负责上传数据并调用 commit
+    TextureHandle acquire(const std::string &path, bool *created) {
+        *created = false;
+        std::string key = canonicalPath(path);
+        std::unordered_map<std::string, unsigned int>::iterator found = byPath.find(key);
+        if (found != byPath.end()) {
+            ++stats.pathHits;
+            return retain(found->second);
+        }
+        // 内容哈希：不同路径下的同一张图片也只保留一份
+        uint64_t hash = contentHash(key);
+        if (hash != 0) {
+            std::unordered_map<uint64_t, unsigned int>::iterator same = byContent.find(hash);
+            if (same != byContent.end()) {
+                ++stats.contentHits;
+                byPath[key] = same->second;
+                entries[same->second].paths.push_back(key);
+                return retain(same->second);
+            }
+        }
+        ++stats.misses;
+        Entry entry;
+        glGenTextures(1, &entry.id);
+        entry.paths.push_back(key);
+        entry.contentHash = hash;
+        entry.bytes = 0;
+        entry.refs = 0;
+        entry.lru = lru.end();
+        entries[entry.id] = entry;
+        byPath[key] = entry.id;
+        if (hash != 0)
+            byContent[hash] = entry.id;
+        *created = true;
+        return retain(entry.id);
+    }
+    // 登记已上传纹理的尺寸（估算显存，包含 mipmap 链的 1/3），必要时按预算回收
+    void commit(unsigned int id, int width, int height, int nrComponents) {
+        std::unordered_map<unsigned int, Entry>::iterator found = entries.find(id);
+        if (found == entries.end())
+            return;
+        // RGB 纹理在显存中一般按 4 字节每像素存储
+        size_t texel = nrComponents == 3 ? 4 : (size_t)std::max(nrComponents, 0);
+        size_t bytes = (size_t)std::max(width, 0) * (size_t)std::max(height, 0) * texel * 4 / 3;
+        residentBytes += bytes - found->second.bytes;
+        found->second.bytes = bytes;
+        stats.peakBytes = std::max(stats.peakBytes, residentBytes);
+        trim();
+    }
+    // 设置显存预算（字节）
+    void setBudget(size_t bytes) {
+        budgetBytes = bytes;
+        trim();
+    }
+    size_t budget() const {
+        return budgetBytes;
+    }
+    // 当前占用的显存（估算）
+    size_t bytes() const {
+        return residentBytes;
+    }
+    // 缓存中的纹理数量（包括未被引用的）
+    size_t size() const {
+        return entries.size();
+    }
+    const Stats &statistics() const {
+        return stats;
+    }
+    // 超出预算时按 LRU 顺序删除未被引用的纹理
+    void trim() {
+        while (residentBytes > budgetBytes && !lru.empty()) {
+            erase(lru.front());
+            ++stats.evictions;
+        }
+    }
+    // 删除所有未被引用的纹理（例如切换场景之后）
+    void clear() {
+        while (!lru.empty())
+            erase(lru.front());
+    }
+    // 输出命中率和显存占用
+    void printStats() const {
+        std::cout << "纹理缓存: " << entries.size() << " 个纹理 (" << lru.size() << " 个未被引用), "
+                  << "路径命中 " << stats.pathHits << ", 内容命中 " << stats.contentHits
+                  << ", 新建 " << stats.misses << ", 回收 " << stats.evictions << ", 显存 "
+                  << residentBytes / 1024 << " KB / 预算 " << budgetBytes / 1024 << " KB (峰值 "
+                  << stats.peakBytes / 1024 << " KB)" << std::endl;
+    }
+
+private:
+    friend class TextureHandle;
+
+    // 缓存项
+    struct Entry {
+        unsigned int id;
+        std::vector<std::string> paths;         // 指向该纹理的所有规范路径
+        uint64_t contentHash;
+        size_t bytes;                           // 估算的显存占用
+        int refs;                               // 句柄引用计数
+        std::list<unsigned int>::iterator lru;  // 未被引用时在 LRU 链表中的位置
+    };
+    std::unordered_map<unsigned int, Entry> entries;
+    std::unordered_map<std::string, unsigned int> byPath;
+    std::unordered_map<uint64_t, unsigned int> byContent;
+    // 未被引用的纹理，表头为最久未使用
+    std::list<unsigned int> lru;
+    size_t budgetBytes;
+    size_t residentBytes;
+    Stats stats;
+
+    TextureCache() : budgetBytes(TEXTURE_CACHE_DEFAULT_BUDGET), residentBytes(0) {
+        stats.pathHits = stats.contentHits = stats.misses = stats.evictions = 0;
+        stats.peakBytes = 0;
+    }
+    TextureCache(const TextureCache &);
+    TextureCache &operator=(const TextureCache &);
+
+    TextureHandle retain(unsigned int id) {
+        Entry &entry = entries[id];
+        if (entry.refs++ == 0 && entry.lru != lru.end()) {
+            lru.erase(entry.lru);
+            entry.lru = lru.end();
+        }
+        return TextureHandle(id);
+    }
+    // 引用归零时放到 LRU 表尾（不调用 OpenGL）
+    void release(unsigned int id) {
+        std::unordered_map<unsigned int, Entry>::iterator found = entries.find(id);
+        if (found == entries.end() || --found->second.refs > 0)
+            return;
+        found->second.lru = lru.insert(lru.end(), id);
+    }
+    // 删除纹理对象及其所有索引
+    void erase(unsigned int id) {
+        Entry &entry = entries[id];
+        for (unsigned int i = 0; i < entry.paths.size(); ++i)
+            byPath.erase(entry.paths[i]);
+        if (entry.contentHash != 0)
+            byContent.erase(entry.contentHash);
+        if (entry.lru != lru.end())
+            lru.erase(entry.lru);
+        residentBytes -= entry.bytes;
+        GLState::instance().deleteTextures(1, &entry.id);
+        entries.erase(id);
+    }
+    static std::string canonicalPath(const std::string &path) {
+        char resolved[PATH_MAX];
+        if (realpath(path.c_str(), resolved))
+            return std::string(resolved);
+        return path;
+    }
+    // 文件内容的 FNV-1a 64 位哈希（读取失败返回 0）
+    static uint64_t contentHash(const std::string &path) {
+        std::ifstream file(path.c_str(), std::ios::in | std::ios::binary);
+        if (!file)
+            return 0;
+        uint64_t hash = 14695981039346656037ULL;
+        char buffer[64 * 1024];
+        while (file) {
+            file.read(buffer, sizeof(buffer));
+            std::streamsize count = file.gcount();
+            for (std::streamsize i = 0; i < count; ++i) {
+                hash ^= (unsigned char)buffer[i];
+                hash *= 1099511628211ULL;
+            }
+        }
+        return hash == 0 ? 1 : hash;
+    }
+};
+
+inline TextureHandle::TextureHandle(const TextureHandle &other) : textureID(0) {
+    if (other.textureID)
+        *this = TextureCache::instance().retain(other.textureID);
+}
+
+inline void TextureHandle::reset() {
+    if (textureID)
+        TextureCache::instance().release(textureID);
+    textureID = 0;
+}
+
+#endif /* texture_cache_h */
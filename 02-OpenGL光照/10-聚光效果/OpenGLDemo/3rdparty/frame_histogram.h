@@ -0,0 +1,106 @@
+//
+//  frame_histogram.h
+//  OpenGLDemo
+//
+//  Created by SeacenLiu on 2020/2/21.
+//  Copyright © 2020 SeacenLiu. All rights reserved.
+//
+
+/**
+ * 帧时间直方图
+ *
+ * 记录每一帧的耗时（毫秒），按固定区间统计帧数并输出平均值、中位数、p99 和最大值。
+ * 平均帧率看不出偶尔的卡顿，直方图的尾部和 p99 才能看出来：
+ * 超过中位数 FRAME_HITCH_FACTOR 倍的帧记为卡顿（hitch）。
+ */
+#ifndef frame_histogram_h
+#define frame_histogram_h
+
+#include <vector>
+#include <string>
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+
+// 超过中位数多少倍的帧算作卡顿
+#define FRAME_HITCH_FACTOR 2.0
+
+class FrameTimeHistogram {
+public:
+    // 记录一帧的耗时（毫秒）
+    void add(double ms) {
+        samples.push_back(ms);
+    }
+    void clear() {
+        samples.clear();
+    }
+    size_t count() const {
+        return samples.size();
+    }
+    double average() const {
+        double sum = 0.0;
+        for (unsigned int i = 0; i < samples.size(); ++i)
+            sum += samples[i];
+        return samples.empty() ? 0.0 : sum / samples.size();
+    }
+    double minimum() const {
+        return samples.empty() ? 0.0 : *std::min_element(samples.begin(), samples.end());
+    }
+    double maximum() const {
+        return samples.empty() ? 0.0 : *std::max_element(samples.begin(), samples.end());
+    }
+    // 百分位数（p 为 0～100，取最近的排名）
+    double percentile(double p) const {
+        if (samples.empty())
+            return 0.0;
+        std::vector<double> sorted(samples);
+        size_t rank = (size_t)(p / 100.0 * (sorted.size() - 1) + 0.5);
+        std::nth_element(sorted.begin(), sorted.begin() + rank, sorted.end());
+        return sorted[rank];
+    }
+    // 卡顿帧数（超过中位数 factor 倍）
+    size_t hitches(double factor = FRAME_HITCH_FACTOR) const {
+        double threshold = percentile(50.0) * factor;
+        size_t count = 0;
+        for (unsigned int i = 0; i < samples.size(); ++i)
+            count += samples[i] > threshold ? 1 : 0;
+        return count;
+    }
+    // 输出直方图（每个区间一行，条形按帧数最多的区间缩放）
+    void print(const std::string &title) const {
+        static const double bounds[] = { 4.0, 8.0, 12.0, 16.7, 20.0, 25.0, 33.3, 50.0, 100.0, 250.0 };
+        const unsigned int bucketCount = sizeof(bounds) / sizeof(bounds[0]) + 1;
+        size_t buckets[bucketCount] = { 0 };
+        for (unsigned int i = 0; i < samples.size(); ++i) {
+            unsigned int b = 0;
+            while (b + 1 < bucketCount && samples[i] >= bounds[b])
+                ++b;
+            ++buckets[b];
+        }
+        size_t most = std::max<size_t>(1, *std::max_element(buckets, buckets + bucketCount));
+        std::cout << title << ": " << samples.size() << " 帧, 平均 " << average() << " ms, 中位数 " << percentile(50.0)
+                  << " ms, p99 " << percentile(99.0) << " ms, 最大 " << maximum() << " ms, 卡顿（> 中位数 "
+                  << FRAME_HITCH_FACTOR << " 倍）" << hitches() << " 帧" << std::endl;
+        for (unsigned int b = 0; b < bucketCount; ++b) {
+            std::cout << "  " << std::setw(6);
+            if (b + 1 < bucketCount)
+                std::cout << "< " + FormatBound(bounds[b]);
+            else
+                std::cout << ">= " + FormatBound(bounds[b - 1]);
+            std::cout << " ms " << std::setw(6) << buckets[b] << " " << std::string(buckets[b] * 40 / most, '#') << std::endl;
+        }
+    }
+
+private:
+    std::vector<double> samples;
+
+    static std::string FormatBound(double bound) {
+        std::string text = std::to_string(bound);
+        text.erase(text.find_last_not_of('0') + 1);
+        if (text.back() == '.')
+            text.pop_back();
+        return text;
+    }
+};
+
+#endif /* frame_histogram_h */
@@ -0,0 +1,451 @@
+//
+//  bvh.h
+//  OpenGLDemo
+//
+//  Created by SeacenLiu on 2020/2/17.
+//  Copyright © 2020 SeacenLiu. All rights reserved.
+//
+
+/**
+ * 层次包围盒（Bounding Volume Hierarchy）
+ *
+ * 以一组包围盒（网格、实例或三角形）为图元建立二叉树，用于视锥体查询和射线拾取：
+ * - 构建：分箱（binned）SAH，每个轴把图元中心分到 BVH_BINS 个箱子里，
+ *   选表面积启发式代价（左边数量 × 左边表面积 + 右边数量 × 右边表面积）最小的划分
+ * - 深度：超过 BVH_MAX_DEPTH 层的结点不再划分（直接作为图元较多的叶结点），
+ *   保证查询时固定大小的遍历栈（BVH_STACK_SIZE）不会溢出，退化的输入也不会漏掉图元
+ * - 存储：所有结点放在一个数组中，每个结点 32 字节（一个缓存行两个结点），
+ *   两个子结点相邻存放，子结点下标总是大于父结点
+ * - 重新拟合（refit）：图元移动后从数组尾部向前重新计算包围盒，不改变树的结构，
+ *   比重建快得多，但移动幅度大时树的质量会下降，需要重新 build
+ * - 视锥体查询：记录父结点已经完全位于哪些平面内侧，子结点只测试剩下的平面，
+ *   完全在视锥体内的子树不再测试，叶结点中的图元用自己的包围盒逐个测试（结果与逐个测试相同）
+ * - 射线查询：先访问近的子结点，命中后缩短射线，跳过更远的子树；
+ *   图元本身的求交（三角形、有旋转的盒子等）由调用者提供
+ */
+#ifndef bvh_h
+#define bvh_h
+
+#include <glm/glm.hpp>
+
+#include <cfloat>
+#include <cmath>
+#include <cstdint>
+#include <cassert>
+#include <vector>
+#include <algorithm>
+
+#include "frustum.h"
+
+// SAH 分箱数量
+#define BVH_BINS 16
+// 叶结点最多的图元数量
+#define BVH_MAX_LEAF 4
+// 遍历栈的深度
+#define BVH_STACK_SIZE 64
+// 树的最大深度（根结点为第 0 层）：深度为 d 的树遍历时栈中最多有 d + 1 个结点
+#define BVH_MAX_DEPTH (BVH_STACK_SIZE - 1)
+
+// 射线（direction 不要求归一化，t 以 direction 的长度为单位）
+struct Ray {
+    glm::vec3 origin;
+    glm::vec3 direction;
+    glm::vec3 inverse;  // 1 / direction（用于包围盒求交）
+
+    Ray() {}
+    Ray(const glm::vec3 &origin, const glm::vec3 &direction) : origin(origin), direction(direction) {
+        for (int k = 0; k < 3; ++k)
+            inverse[k] = direction[k] != 0.0f ? 1.0f / direction[k] : FLT_MAX;
+    }
+    glm::vec3 at(float t) const {
+        return origin + direction * t;
+    }
+};
+
+// 屏幕坐标（左上角为原点，与 GLFW 光标位置一致）生成射线：clip 为 projection * view 时得到世界空间射线，
+// 为 MVP 时得到物体空间射线；射线从近平面出发，t = 1 时到达远平面
+inline Ray ScreenRay(double x, double y, int width, int height, const glm::mat4 &clip) {
+    float nx = (float)(2.0 * x / width - 1.0);
+    float ny = (float)(1.0 - 2.0 * y / height);
+    glm::mat4 inverse = glm::inverse(clip);
+    glm::vec4 nearPoint = inverse * glm::vec4(nx, ny, -1.0f, 1.0f);
+    glm::vec4 farPoint = inverse * glm::vec4(nx, ny, 1.0f, 1.0f);
+    glm::vec3 origin = glm::vec3(nearPoint.x, nearPoint.y, nearPoint.z) / nearPoint.w;
+    glm::vec3 end = glm::vec3(farPoint.x, farPoint.y, farPoint.z) / farPoint.w;
+    return Ray(origin, end - origin);
+}
+
+// 射线与包围盒求交（slab 方法），命中区间与 [0, tMax] 相交时返回 true，tNear 为进入距离
+inline bool IntersectAABB(const Ray &ray, const glm::vec3 &min, const glm::vec3 &max, float tMax, float &tNear) {
+    float t0 = 0.0f, t1 = tMax;
+    for (int k = 0; k < 3; ++k) {
+        float a = (min[k] - ray.origin[k]) * ray.inverse[k];
+        float b = (max[k] - ray.origin[k]) * ray.inverse[k];
+        if (a > b)
+            std::swap(a, b);
+        t0 = a > t0 ? a : t0;
+        t1 = b < t1 ? b : t1;
+        if (t0 > t1)
+            return false;
+    }
+    tNear = t0;
+    return true;
+}
+
+// 射线与三角形求交（Möller-Trumbore），命中且 t 在 (0, tMax) 内时返回 true
+inline bool IntersectTriangle(const Ray &ray, const glm::vec3 &p0, const glm::vec3 &p1, const glm::vec3 &p2,
+                              float tMax, float &t) {
+    glm::vec3 e1 = p1 - p0, e2 = p2 - p0;
+    const glm::vec3 &d = ray.direction;
+    glm::vec3 p(d.y * e2.z - d.z * e2.y, d.z * e2.x - d.x * e2.z, d.x * e2.y - d.y * e2.x);
+    float det = e1.x * p.x + e1.y * p.y + e1.z * p.z;
+    if (std::fabs(det) < 1e-12f)
+        return false;
+    float invDet = 1.0f / det;
+    glm::vec3 s = ray.origin - p0;
+    float u = (s.x * p.x + s.y * p.y + s.z * p.z) * invDet;
+    if (u < 0.0f || u > 1.0f)
+        return false;
+    glm::vec3 q(s.y * e1.z - s.z * e1.y, s.z * e1.x - s.x * e1.z, s.x * e1.y - s.y * e1.x);
+    float v = (d.x * q.x + d.y * q.y + d.z * q.z) * invDet;
+    if (v < 0.0f || u + v > 1.0f)
+        return false;
+    float hit = (e2.x * q.x + e2.y * q.y + e2.z * q.z) * invDet;
+    if (hit <= 0.0f || hit >= tMax)
+        return false;
+    t = hit;
+    return true;
+}
+
+// 结点（叶结点 count > 0，图元为 primitives[first, first + count)；内部结点的子结点为 left 和 left + 1）
+struct BVHNode {
+    glm::vec3 min;
+    int32_t leftOrFirst;
+    glm::vec3 max;
+    int32_t count;
+
+    bool leaf() const {
+        return count > 0;
+    }
+};
+
+static_assert(sizeof(BVHNode) == 32, "BVHNode must be 32 bytes");
+
+class BVH {
+public:
+    // 结点数组（nodes[0] 为根结点）
+    std::vector<BVHNode> nodes;
+    // 叶结点引用的图元下标
+    std::vector<unsigned int> primitives;
+
+    // 从图元包围盒构建（图元下标即 boxes 的下标）
+    void build(const std::vector<AABB> &boxes) {
+        nodes.clear();
+        maxDepth = 0;
+        primitives.resize(boxes.size());
+        if (boxes.empty())
+            return;
+        // 构建时图元的包围盒跟着下标一起划分，每一层都是顺序读取
+        work.resize(boxes.size());
+        AABB root;
+        for (unsigned int i = 0; i < boxes.size(); ++i) {
+            work[i].min = boxes[i].min;
+            work[i].max = boxes[i].max;
+            work[i].index = i;
+            grow(root, boxes[i].min, boxes[i].max);
+        }
+        nodes.reserve(boxes.size() * 2);
+        nodes.push_back(BVHNode());
+        nodes[0].min = root.min;
+        nodes[0].max = root.max;
+        nodes[0].leftOrFirst = 0;
+        nodes[0].count = (int32_t)boxes.size();
+        // 待划分的结点和它的深度（显式栈，避免深度递归；子结点的包围盒在划分时已经算好）
+        std::vector<std::pair<unsigned int, unsigned int> > pending(1, std::make_pair(0u, 0u));
+        while (!pending.empty()) {
+            unsigned int index = pending.back().first, depth = pending.back().second;
+            pending.pop_back();
+            maxDepth = std::max(maxDepth, depth);
+            unsigned int left;
+            if (depth >= BVH_MAX_DEPTH || !split(index, left))
+                continue;
+            pending.push_back(std::make_pair(left + 1, depth + 1));
+            pending.push_back(std::make_pair(left, depth + 1));
+        }
+        for (unsigned int i = 0; i < work.size(); ++i)
+            primitives[i] = work[i].index;
+        std::vector<BuildPrimitive>().swap(work);
+    }
+    // 图元包围盒变化后重新计算所有结点的包围盒（图元数量和顺序不能变）
+    void refit(const std::vector<AABB> &boxes) {
+        for (size_t i = nodes.size(); i-- > 0;) {
+            BVHNode &node = nodes[i];
+            AABB box;
+            if (node.leaf()) {
+                for (int32_t j = 0; j < node.count; ++j)
+                    box.expand(boxes[primitives[node.leftOrFirst + j]]);
+            } else {
+                box.expand(AABB(nodes[node.leftOrFirst].min, nodes[node.leftOrFirst].max));
+                box.expand(AABB(nodes[node.leftOrFirst + 1].min, nodes[node.leftOrFirst + 1].max));
+            }
+            node.min = box.min;
+            node.max = box.max;
+        }
+    }
+    bool empty() const {
+        return nodes.empty();
+    }
+    // 树的深度（只有根结点时为 0）
+    unsigned int depth() const {
+        return maxDepth;
+    }
+    // 视锥体查询：boxes 为构建（或重新拟合）时的图元包围盒，
+    // 把与视锥体相交的图元下标追加到 out，返回追加的数量
+    size_t query(const Frustum &frustum, const std::vector<AABB> &boxes, std::vector<unsigned int> &out) const {
+        if (nodes.empty())
+            return 0;
+        size_t before = out.size();
+        // 栈中同时记录还需要测试的平面（第 i 位为 1 表示还没确定在平面 i 内侧）
+        unsigned int stack[BVH_STACK_SIZE];
+        unsigned char masks[BVH_STACK_SIZE];
+        int top = 0;
+        stack[top] = 0;
+        masks[top++] = (1u << Frustum::PLANE_COUNT) - 1;
+        while (top > 0) {
+            --top;
+            const BVHNode &node = nodes[stack[top]];
+            unsigned char mask = masks[top];
+            if (!classify(frustum, node.min, node.max, mask))
+                continue;
+            if (!node.leaf()) {
+                // build 限制了深度，栈不会溢出
+                assert(top + 2 <= BVH_STACK_SIZE);
+                stack[top] = node.leftOrFirst + 1;
+                masks[top++] = mask;
+                stack[top] = node.leftOrFirst;
+                masks[top++] = mask;
+                continue;
+            }
+            // 叶结点中的图元逐个测试剩下的平面
+            for (int32_t j = 0; j < node.count; ++j) {
+                unsigned int primitive = primitives[node.leftOrFirst + j];
+                unsigned char primitiveMask = mask;
+                if (!primitiveMask || classify(frustum, boxes[primitive].min, boxes[primitive].max, primitiveMask))
+                    out.push_back(primitive);
+            }
+        }
+        return out.size() - before;
+    }
+    // 射线查询：hit(图元下标, tMax) 负责精确求交，命中时缩短 tMax 并返回 true；
+    // 返回最近的命中图元（没有命中返回 -1），tMax 为命中距离
+    template <typename HitFunction>
+    int intersect(const Ray &ray, float &tMax, HitFunction hit) const {
+        if (nodes.empty())
+            return -1;
+        int nearest = -1;
+        // 栈中同时记录进入距离，出栈时如果已经比当前命中点远就跳过
+        unsigned int stack[BVH_STACK_SIZE];
+        float entry[BVH_STACK_SIZE];
+        int top = 0;
+        float tNear;
+        if (!IntersectAABB(ray, nodes[0].min, nodes[0].max, tMax, tNear))
+            return -1;
+        stack[top] = 0;
+        entry[top++] = tNear;
+        while (top > 0) {
+            --top;
+            if (entry[top] > tMax)
+                continue;
+            const BVHNode &node = nodes[stack[top]];
+            if (node.leaf()) {
+                for (int32_t j = 0; j < node.count; ++j) {
+                    unsigned int primitive = primitives[node.leftOrFirst + j];
+                    if (hit(primitive, tMax))
+                        nearest = (int)primitive;
+                }
+                continue;
+            }
+            // 近的子结点后入栈，先被访问
+            unsigned int a = node.leftOrFirst, b = node.leftOrFirst + 1;
+            float ta = 0.0f, tb = 0.0f;
+            bool hitA = IntersectAABB(ray, nodes[a].min, nodes[a].max, tMax, ta);
+            bool hitB = IntersectAABB(ray, nodes[b].min, nodes[b].max, tMax, tb);
+            if (hitA && hitB && ta < tb) {
+                std::swap(a, b);
+                std::swap(ta, tb);
+            }
+            assert(top + 2 <= BVH_STACK_SIZE);
+            if (hitA) {
+                stack[top] = a;
+                entry[top++] = ta;
+            }
+            if (hitB) {
+                stack[top] = b;
+                entry[top++] = tb;
+            }
+        }
+        return nearest;
+    }
+    // 树的 SAH 代价（内部结点代价 1、图元代价 1，相对根结点表面积），用于比较构建和重新拟合后的质量
+    float cost() const {
+        if (nodes.empty())
+            return 0.0f;
+        float rootArea = area(nodes[0].min, nodes[0].max);
+        if (rootArea <= 0.0f)
+            return 0.0f;
+        float sum = 0.0f;
+        for (size_t i = 0; i < nodes.size(); ++i) {
+            float a = area(nodes[i].min, nodes[i].max) / rootArea;
+            sum += nodes[i].leaf() ? a * nodes[i].count : a;
+        }
+        return sum;
+    }
+
+private:
+    // 构建时的图元（包围盒 + 下标，32 字节）
+    struct BuildPrimitive {
+        glm::vec3 min;
+        unsigned int index;
+        glm::vec3 max;
+        float padding;
+
+        // 中心的 2 倍（只用于分箱，省掉乘法）
+        float center2(int axis) const {
+            return min[axis] + max[axis];
+        }
+    };
+    std::vector<BuildPrimitive> work;
+    // 构建得到的树深度
+    unsigned int maxDepth = 0;
+
+    static float area(const glm::vec3 &min, const glm::vec3 &max) {
+        glm::vec3 d = max - min;
+        if (d.x < 0.0f || d.y < 0.0f || d.z < 0.0f)
+            return 0.0f;
+        return 2.0f * (d.x * d.y + d.y * d.z + d.z * d.x);
+    }
+    // 测试 mask 中的平面：完全在外侧返回 false；完全在内侧的平面从 mask 中去掉
+    static bool classify(const Frustum &frustum, const glm::vec3 &min, const glm::vec3 &max, unsigned char &mask) {
+        glm::vec3 c = (min + max) * 0.5f, e = (max - min) * 0.5f;
+        for (int p = 0; p < Frustum::PLANE_COUNT; ++p) {
+            if (!(mask & (1u << p)))
+                continue;
+            const glm::vec4 &plane = frustum.planes[p];
+            float distance = plane.x * c.x + plane.y * c.y + plane.z * c.z + plane.w;
+            float radius = std::fabs(plane.x) * e.x + std::fabs(plane.y) * e.y + std::fabs(plane.z) * e.z;
+            if (distance + radius < 0.0f)
+                return false;
+            if (distance - radius >= 0.0f)
+                mask &= ~(1u << p);
+        }
+        return true;
+    }
+    // 合并包围盒（不检查空包围盒，构建时的热点）
+    static void grow(AABB &box, const glm::vec3 &min, const glm::vec3 &max) {
+        box.min.x = min.x < box.min.x ? min.x : box.min.x;
+        box.min.y = min.y < box.min.y ? min.y : box.min.y;
+        box.min.z = min.z < box.min.z ? min.z : box.min.z;
+        box.max.x = max.x > box.max.x ? max.x : box.max.x;
+        box.max.y = max.y > box.max.y ? max.y : box.max.y;
+        box.max.z = max.z > box.max.z ? max.z : box.max.z;
+    }
+    // 按 SAH 划分叶结点，划分后 left 为左子结点下标；不值得划分时返回 false
+    bool split(unsigned int index, unsigned int &left) {
+        int32_t first = nodes[index].leftOrFirst, count = nodes[index].count;
+        if (count <= 1)
+            return false;
+        AABB centerBounds;
+        for (int32_t j = first; j < first + count; ++j) {
+            glm::vec3 c(work[j].center2(0), work[j].center2(1), work[j].center2(2));
+            grow(centerBounds, c, c);
+        }
+        // 三个轴同时分箱（每个图元只读一次），再扫描每个轴的所有划分位置
+        AABB bins[3][BVH_BINS];
+        int binCount[3][BVH_BINS] = { { 0 } };
+        float lo[3], scale[3];
+        for (int axis = 0; axis < 3; ++axis) {
+            lo[axis] = centerBounds.min[axis];
+            float size = centerBounds.max[axis] - lo[axis];
+            scale[axis] = size > 0.0f ? BVH_BINS / size : 0.0f;
+        }
+        for (int32_t j = first; j < first + count; ++j) {
+            const BuildPrimitive &p = work[j];
+            for (int axis = 0; axis < 3; ++axis) {
+                int b = std::min(BVH_BINS - 1, (int)((p.center2(axis) - lo[axis]) * scale[axis]));
+                grow(bins[axis][b], p.min, p.max);
+                ++binCount[axis][b];
+            }
+        }
+        int bestAxis = -1, bestSplit = 0;
+        float bestCost = FLT_MAX;
+        for (int axis = 0; axis < 3; ++axis) {
+            if (scale[axis] == 0.0f)
+                continue;
+            // 从右向左累计右边的面积和数量
+            float rightArea[BVH_BINS];
+            int rightCount[BVH_BINS];
+            AABB acc;
+            int n = 0;
+            for (int b = BVH_BINS - 1; b > 0; --b) {
+                acc.expand(bins[axis][b]);
+                n += binCount[axis][b];
+                rightArea[b] = area(acc.min, acc.max);
+                rightCount[b] = n;
+            }
+            acc = AABB();
+            n = 0;
+            for (int b = 0; b < BVH_BINS - 1; ++b) {
+                acc.expand(bins[axis][b]);
+                n += binCount[axis][b];
+                if (n == 0 || rightCount[b + 1] == 0)
+                    continue;
+                float c = n * area(acc.min, acc.max) + rightCount[b + 1] * rightArea[b + 1];
+                if (c < bestCost) {
+                    bestCost = c;
+                    bestAxis = axis;
+                    bestSplit = b + 1;
+                }
+            }
+        }
+        // 不划分的代价：所有图元都要求交（相对父结点表面积，与上面同单位）
+        const BVHNode &node = nodes[index];
+        float leafCost = count * area(node.min, node.max);
+        int32_t mid;
+        AABB leftBox, rightBox;
+        if (bestAxis >= 0 && (bestCost + area(node.min, node.max) < leafCost || count > BVH_MAX_LEAF)) {
+            BuildPrimitive *begin = &work[first];
+            BuildPrimitive *middle = std::partition(begin, begin + count, [&](const BuildPrimitive &p) {
+                return std::min(BVH_BINS - 1, (int)((p.center2(bestAxis) - lo[bestAxis]) * scale[bestAxis])) < bestSplit;
+            });
+            mid = (int32_t)(middle - begin);
+            // 按箱子划分，子结点的包围盒就是两边箱子的并集
+            for (int b = 0; b < BVH_BINS; ++b)
+                (b < bestSplit ? leftBox : rightBox).expand(bins[bestAxis][b]);
+        } else if (count > BVH_MAX_LEAF) {
+            // 图元中心全部重合：按顺序对半分
+            mid = count / 2;
+            for (int32_t j = 0; j < count; ++j)
+                grow(j < mid ? leftBox : rightBox, work[first + j].min, work[first + j].max);
+        } else {
+            return false;
+        }
+        left = (unsigned int)nodes.size();
+        BVHNode child;
+        child.min = leftBox.min;
+        child.max = leftBox.max;
+        child.leftOrFirst = first;
+        child.count = mid;
+        nodes.push_back(child);
+        child.min = rightBox.min;
+        child.max = rightBox.max;
+        child.leftOrFirst = first + mid;
+        child.count = count - mid;
+        nodes.push_back(child);
+        // push_back 可能使引用失效，重新取父结点
+        nodes[index].leftOrFirst = (int32_t)left;
+        nodes[index].count = 0;
+        return true;
+    }
+};
+
+#endif /* bvh_h */
@@ -0,0 +1,306 @@
+//
+//  deferred_renderer.h
+//  OpenGLDemo
+//
+//  Created by SeacenLiu on 2020/2/6.
+//  Copyright © 2020 SeacenLiu. All rights reserved.
+//
+
+/**
+ * 延迟渲染（Deferred Shading）
+ * https://learnopengl-cn.github.io/05%20Advanced%20Lighting/08%20Deferred%20Shading/
+ *
+ * 1. 几何 pass：把位置、法向量、漫反射颜色/镜面光强度写入 G-buffer（多渲染目标）
+ * 2. 光照 pass：全屏计算定向光和聚光，结果写入光照缓冲
+ * 3. 点光源 pass：每个点光源绘制一个包围球（光体积），先用模板测试标记出
+ *    球内真正有几何体的像素（深度失败时背面 +1、正面 -1），再只对这些像素着色并叠加，
+ *    每个点光源的开销只与它在屏幕上覆盖的像素有关，与场景复杂度无关
+ * 4. present：把光照缓冲拷贝（blit）到默认帧缓冲
+ *
+ * 光体积的着色 pass 会把模板值清零，所以整帧只需要清一次模板缓冲。
+ */
+#ifndef deferred_renderer_h
+#define deferred_renderer_h
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <cmath>
+#include <vector>
+#include <string>
+#include <iostream>
+
+#include "shader_m.h"
+#include "light_block.h"
+#include "light_cluster.h"
+#include "headless.h"
+
+// G-buffer 纹理使用的纹理单元（光照 pass 中不会再用到材质贴图）
+#define GBUFFER_POSITION_UNIT 0
+#define GBUFFER_NORMAL_UNIT   1
+#define GBUFFER_ALBEDO_UNIT   2
+
+// 光体积球体的经纬划分
+#define LIGHT_VOLUME_SLICES 16
+#define LIGHT_VOLUME_STACKS 12
+
+class DeferredRenderer {
+public:
+    // 几何 pass 着色器（与 colors.vs 配合，输出到 G-buffer）
+    Shader geometryShader;
+    // 统计信息（最近一帧）
+    unsigned int lightsDrawn;   // 实际绘制光体积的点光源数量
+
+    // 构造函数（需要在 OpenGL 上下文创建之后调用）
+    DeferredRenderer(float zNear) : geometryShader("colors.vs", "gbuffer.fs"),
+                                    lightsDrawn(0),
+                                    lightingShader("deferred_light.vs", "deferred_light.fs"),
+                                    pointShader("lamp.vs", "deferred_point.fs"),
+                                    stencilShader("lamp.vs", "lamp.fs"),
+                                    zNear(zNear), width(0), height(0), FBO(0), depthStencil(0) {
+        Shader *gShaders[] = { &lightingShader, &pointShader };
+        for (Shader *shader : gShaders) {
+            shader->use();
+            shader->setInt("gPosition", GBUFFER_POSITION_UNIT);
+            shader->setInt("gNormal", GBUFFER_NORMAL_UNIT);
+            shader->setInt("gAlbedoSpec", GBUFFER_ALBEDO_UNIT);
+        }
+        for (int i = 0; i < 4; ++i)
+            pointLightLoc[i] = pointShader.getUniform("pointLight[" + std::to_string(i) + "]");
+        pointModelLoc = pointShader.getUniform("model");
+        stencilModelLoc = stencilShader.getUniform("model");
+        for (int i = 0; i < 4; ++i)
+            gBuffer[i] = 0;
+        setupQuad();
+        setupSphere();
+    }
+    // 释放 OpenGL 资源
+    void release() {
+        releaseTargets();
+        GLState::instance().deleteVertexArrays(1, &quadVAO);
+        GLState::instance().deleteBuffers(1, &quadVBO);
+        GLState::instance().deleteVertexArrays(1, &sphereVAO);
+        GLState::instance().deleteBuffers(1, &sphereVBO);
+        GLState::instance().deleteBuffers(1, &sphereEBO);
+    }
+    // 使用 LightBlock 的着色器（定向光和聚光）
+    Shader &lightBlockShader() {
+        return lightingShader;
+    }
+    // 按帧缓冲大小（重新）创建 G-buffer，大小不变时什么也不做
+    void resize(int w, int h) {
+        if (w == width && h == height)
+            return;
+        releaseTargets();
+        width = w;
+        height = h;
+        glGenFramebuffers(1, &FBO);
+        glBindFramebuffer(GL_FRAMEBUFFER, FBO);
+        // 0: 位置 1: 法向量 2: 漫反射颜色 + 镜面光强度 3: 光照结果
+        GLenum internalFormats[4] = { GL_RGBA32F, GL_RGBA16F, GL_RGBA8, GL_RGBA16F };
+        GLenum types[4] = { GL_FLOAT, GL_HALF_FLOAT, GL_UNSIGNED_BYTE, GL_HALF_FLOAT };
+        glGenTextures(4, gBuffer);
+        for (int i = 0; i < 4; ++i) {
+            GLState::instance().bindTexture(GL_TEXTURE_2D, gBuffer[i]);
+            glTexImage2D(GL_TEXTURE_2D, 0, internalFormats[i], width, height, 0, GL_RGBA, types[i], NULL);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+            glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + i, GL_TEXTURE_2D, gBuffer[i], 0);
+        }
+        GLState::instance().bindTexture(GL_TEXTURE_2D, 0);
+        // 深度 + 模板（模板用于光体积）
+        glGenRenderbuffers(1, &depthStencil);
+        glBindRenderbuffer(GL_RENDERBUFFER, depthStencil);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, depthStencil);
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+            std::cout << "ERROR::FRAMEBUFFER:: G-buffer is not complete!" << std::endl;
+        glBindFramebuffer(GL_FRAMEBUFFER, Headless::instance().framebuffer());
+    }
+    // 几何 pass：绑定 G-buffer 并清空，之后用 geometryShader 绘制场景
+    void beginGeometryPass(const glm::vec4 &clearColor) {
+        glBindFramebuffer(GL_FRAMEBUFFER, FBO);
+        // 光照缓冲清为背景色，其余清零（position.w == 0 表示没有几何体）
+        GLenum buffers[4] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1, GL_COLOR_ATTACHMENT2, GL_COLOR_ATTACHMENT3 };
+        glDrawBuffers(4, buffers);
+        const float zero[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+        for (int i = 0; i < 3; ++i)
+            glClearBufferfv(GL_COLOR, i, zero);
+        glClearBufferfv(GL_COLOR, 3, &clearColor[0]);
+        glClearBufferfi(GL_DEPTH_STENCIL, 0, 1.0f, 0);
+        glDrawBuffers(3, buffers);
+    }
+    // 光照 pass：定向光、聚光（LightBlock）和点光源光体积，完成后光照缓冲仍是绘制目标，
+    // 可以继续前向绘制不参与光照的物体（使用 G-buffer 的深度）
+    void lightingPass(const std::vector<PointLightStd140> &pointLights,
+                      const glm::mat4 &view,
+                      const glm::mat4 &projection,
+                      const glm::vec3 &viewPos,
+                      float shininess) {
+        glm::vec2 screenSize((float)width, (float)height);
+        glDrawBuffer(GL_COLOR_ATTACHMENT3);
+        for (int i = 0; i < 3; ++i)
+            GLState::instance().bindTexture(GBUFFER_POSITION_UNIT + i, GL_TEXTURE_2D, gBuffer[i]);
+
+        // 1. 全屏 pass：定向光 + 聚光
+        GLState::instance().disable(GL_DEPTH_TEST);
+        lightingShader.use();
+        lightingShader.setVec2("screenSize", screenSize);
+        lightingShader.setVec3("viewPos", viewPos);
+        lightingShader.setFloat("shininess", shininess);
+        GLState::instance().bindVertexArray(quadVAO);
+        glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+
+        // 2. 点光源光体积
+        pointShader.use();
+        pointShader.setMat4("view", view);
+        pointShader.setMat4("projection", projection);
+        pointShader.setVec2("screenSize", screenSize);
+        pointShader.setVec3("viewPos", viewPos);
+        pointShader.setFloat("shininess", shininess);
+        stencilShader.use();
+        stencilShader.setMat4("view", view);
+        stencilShader.setMat4("projection", projection);
+        GLState::instance().bindVertexArray(sphereVAO);
+        GLState::instance().enable(GL_STENCIL_TEST);
+        // 光照结果相加（模板 pass 不写颜色，不受混合影响）
+        GLState::instance().enable(GL_BLEND);
+        glBlendFunc(GL_ONE, GL_ONE);
+        glDepthMask(GL_FALSE);
+        lightsDrawn = 0;
+        for (unsigned int i = 0; i < pointLights.size(); ++i) {
+            const PointLightStd140 &light = pointLights[i];
+            // 球体多边形在包围球内部，稍微放大保证完全覆盖
+            float radius = (light.radius > 0.0f ? light.radius : PointLightRadius(light)) * 1.05f;
+            // 整个包围球都在相机后面（或近平面之前）时跳过
+            glm::vec3 center = glm::vec3(view * glm::vec4(light.position, 1.0f));
+            if (center.z - radius > -zNear)
+                continue;
+            glm::mat4 model = glm::translate(glm::mat4(1.0f), light.position);
+            model = glm::scale(model, glm::vec3(radius));
+
+            // 2-1: 模板 pass：只测试深度，不写颜色
+            // 深度失败时背面 +1、正面 -1，最终非 0 的像素就是被光体积包住的几何体
+            stencilShader.use();
+            stencilShader.setMat4(stencilModelLoc, model);
+            glDrawBuffer(GL_NONE);
+            GLState::instance().enable(GL_DEPTH_TEST);
+            GLState::instance().disable(GL_CULL_FACE);
+            glStencilFunc(GL_ALWAYS, 0, 0);
+            glStencilOpSeparate(GL_BACK, GL_KEEP, GL_INCR_WRAP, GL_KEEP);
+            glStencilOpSeparate(GL_FRONT, GL_KEEP, GL_DECR_WRAP, GL_KEEP);
+            glDrawElements(GL_TRIANGLES, sphereIndexCount, GL_UNSIGNED_SHORT, 0);
+
+            // 2-2: 着色 pass：只绘制背面（相机在球内也能覆盖），模板非 0 的像素才着色，
+            // 着色后把模板值清零，下一个光源不需要再清模板缓冲
+            pointShader.use();
+            pointShader.setMat4(pointModelLoc, model);
+            pointShader.setVec4(pointLightLoc[0], glm::vec4(light.position, light.constant));
+            pointShader.setVec4(pointLightLoc[1], glm::vec4(light.ambient, light.linear));
+            pointShader.setVec4(pointLightLoc[2], glm::vec4(light.diffuse, light.quadratic));
+            pointShader.setVec4(pointLightLoc[3], glm::vec4(light.specular, light.radius));
+            glDrawBuffer(GL_COLOR_ATTACHMENT3);
+            GLState::instance().disable(GL_DEPTH_TEST);
+            GLState::instance().enable(GL_CULL_FACE);
+            glCullFace(GL_FRONT);
+            glStencilFunc(GL_NOTEQUAL, 0, 0xFF);
+            glStencilOp(GL_KEEP, GL_KEEP, GL_ZERO);
+            glDrawElements(GL_TRIANGLES, sphereIndexCount, GL_UNSIGNED_SHORT, 0);
+            ++lightsDrawn;
+        }
+        // 恢复默认状态
+        GLState::instance().disable(GL_BLEND);
+        glCullFace(GL_BACK);
+        GLState::instance().disable(GL_CULL_FACE);
+        GLState::instance().disable(GL_STENCIL_TEST);
+        glDepthMask(GL_TRUE);
+        GLState::instance().enable(GL_DEPTH_TEST);
+    }
+    // 把光照结果拷贝到默认帧缓冲（离屏模式下是 Headless 的 FBO）
+    void present() {
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, FBO);
+        glReadBuffer(GL_COLOR_ATTACHMENT3);
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, Headless::instance().framebuffer());
+        glBlitFramebuffer(0, 0, width, height, 0, 0, width, height, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+        glBindFramebuffer(GL_FRAMEBUFFER, Headless::instance().framebuffer());
+    }
+
+private:
+    Shader lightingShader;
+    Shader pointShader;
+    Shader stencilShader;
+    UniformHandle pointLightLoc[4], pointModelLoc, stencilModelLoc;
+    float zNear;
+    int width, height;
+    unsigned int FBO;
+    unsigned int gBuffer[4];
+    unsigned int depthStencil;
+    unsigned int quadVAO, quadVBO;
+    unsigned int sphereVAO, sphereVBO, sphereEBO;
+    GLsizei sphereIndexCount;
+
+    void releaseTargets() {
+        if (FBO == 0)
+            return;
+        glDeleteFramebuffers(1, &FBO);
+        GLState::instance().deleteTextures(4, gBuffer);
+        glDeleteRenderbuffers(1, &depthStencil);
+        FBO = 0;
+    }
+    // 全屏四边形
+    void setupQuad() {
+        float quadVertices[] = {
+            -1.0f,  1.0f,
+            -1.0f, -1.0f,
+             1.0f,  1.0f,
+             1.0f, -1.0f
+        };
+        glGenVertexArrays(1, &quadVAO);
+        glGenBuffers(1, &quadVBO);
+        GLState::instance().bindVertexArray(quadVAO);
+        GLState::instance().bindBuffer(GL_ARRAY_BUFFER, quadVBO);
+        glBufferData(GL_ARRAY_BUFFER, sizeof(quadVertices), quadVertices, GL_STATIC_DRAW);
+        glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)0);
+        glEnableVertexAttribArray(0);
+        GLState::instance().bindVertexArray(0);
+    }
+    // 单位经纬球（光体积）
+    void setupSphere() {
+        std::vector<float> vertices;
+        std::vector<unsigned short> indices;
+        const float PI = 3.14159265359f;
+        for (int y = 0; y <= LIGHT_VOLUME_STACKS; ++y) {
+            float phi = PI * y / LIGHT_VOLUME_STACKS;
+            for (int x = 0; x <= LIGHT_VOLUME_SLICES; ++x) {
+                float theta = 2.0f * PI * x / LIGHT_VOLUME_SLICES;
+                vertices.push_back(std::cos(theta) * std::sin(phi));
+                vertices.push_back(std::cos(phi));
+                vertices.push_back(std::sin(theta) * std::sin(phi));
+            }
+        }
+        // 外侧为正面（逆时针）
+        for (int y = 0; y < LIGHT_VOLUME_STACKS; ++y) {
+            for (int x = 0; x < LIGHT_VOLUME_SLICES; ++x) {
+                unsigned short i0 = y * (LIGHT_VOLUME_SLICES + 1) + x;
+                unsigned short i1 = i0 + LIGHT_VOLUME_SLICES + 1;
+                indices.push_back(i0); indices.push_back(i0 + 1); indices.push_back(i1);
+                indices.push_back(i1); indices.push_back(i0 + 1); indices.push_back(i1 + 1);
+            }
+        }
+        sphereIndexCount = (GLsizei)indices.size();
+        glGenVertexArrays(1, &sphereVAO);
+        glGenBuffers(1, &sphereVBO);
+        glGenBuffers(1, &sphereEBO);
+        GLState::instance().bindVertexArray(sphereVAO);
+        GLState::instance().bindBuffer(GL_ARRAY_BUFFER, sphereVBO);
+        glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), &vertices[0], GL_STATIC_DRAW);
+        GLState::instance().bindBuffer(GL_ELEMENT_ARRAY_BUFFER, sphereEBO);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned short), &indices[0], GL_STATIC_DRAW);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
+        glEnableVertexAttribArray(0);
+        GLState::instance().bindVertexArray(0);
+    }
+};
+
+#endif /* deferred_renderer_h */
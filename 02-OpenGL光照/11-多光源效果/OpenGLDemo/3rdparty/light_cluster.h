@@ -0,0 +1,308 @@
+//
+//  light_cluster.h
+//  OpenGLDemo
+//
+//  Created by SeacenLiu on 2020/2/5.
+//  Copyright © 2020 SeacenLiu. All rights reserved.
+//
+
+/**
+ * 分簇前向渲染（Clustered Forward Shading）的光源分簇
+ *
+ * 把视锥体划分为 CLUSTER_X * CLUSTER_Y * CLUSTER_Z 个簇（屏幕分块 + 深度按指数划分），
+ * 每帧在 CPU 上把点光源的包围球分配到与之相交的簇中，结果通过纹理缓冲（TBO）传给片元着色器：
+ * - 光源数据：每个光源 4 个 RGBA32F 纹素（布局与 PointLightStd140 相同）
+ * - 簇网格：每个簇一个 RG32UI 纹素（光源索引列表中的起始位置、数量）
+ * - 光源索引列表：R32UI
+ * 片元着色器只遍历自己所在簇中的光源，开销从 O(片元 * 光源) 降到 O(片元 * 簇内光源)。
+ *
+ * 分簇按深度切片分给多个线程（每个簇只属于一个线程，无需加锁），
+ * 包围球与簇 AABB 的相交测试在支持 SSE2 的平台上一次处理 4 个簇。
+ */
+#ifndef light_cluster_h
+#define light_cluster_h
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <cmath>
+#include <vector>
+#include <thread>
+#include <algorithm>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "shader_m.h"
+#include "light_block.h"
+
+// 簇网格划分
+#define CLUSTER_X 16
+#define CLUSTER_Y 9
+#define CLUSTER_Z 24
+#define CLUSTER_COUNT (CLUSTER_X * CLUSTER_Y * CLUSTER_Z)
+
+// 分簇使用的纹理单元（0、1 留给材质贴图）
+#define CLUSTER_LIGHT_UNIT 2
+#define CLUSTER_GRID_UNIT  3
+#define CLUSTER_INDEX_UNIT 4
+
+// 少于该数量的光源时不启用多线程（线程创建开销比分簇本身还大）
+#define CLUSTER_PARALLEL_LIGHTS 64
+
+static_assert(CLUSTER_X % 4 == 0, "CLUSTER_X must be a multiple of 4 for the SIMD path");
+
+// 根据衰减参数计算点光源的影响半径（亮度衰减到 5/256 以下视为没有贡献）
+inline float PointLightRadius(const PointLightStd140 &light) {
+    float maxBrightness = std::max(std::max(light.diffuse.x, light.diffuse.y), light.diffuse.z);
+    maxBrightness = std::max(maxBrightness, std::max(std::max(light.specular.x, light.specular.y), light.specular.z));
+    float c = light.constant - maxBrightness * (256.0f / 5.0f);
+    if (light.quadratic <= 0.0f)
+        return light.linear > 0.0f ? -c / light.linear : 1e30f;
+    return (-light.linear + std::sqrt(light.linear * light.linear - 4.0f * light.quadratic * c))
+           / (2.0f * light.quadratic);
+}
+
+class LightCluster {
+public:
+    // 统计信息（最近一次 update）
+    unsigned int visibleLights;  // 与视锥体相交的光源数量
+    unsigned int indexCount;     // 光源索引总数（所有簇的光源数量之和）
+    unsigned int threadCount;    // 分簇使用的线程数
+
+    // 构造函数（需要在 OpenGL 上下文创建之后调用）
+    LightCluster(float zNear, float zFar) : visibleLights(0), indexCount(0), threadCount(1),
+                                            zNear(zNear), zFar(zFar), cachedProjection(0.0f) {
+        glGenBuffers(3, buffers);
+        glGenTextures(3, textures);
+        GLenum formats[3] = { GL_RGBA32F, GL_RG32UI, GL_R32UI };
+        for (int i = 0; i < 3; ++i) {
+            GLState::instance().bindBuffer(GL_TEXTURE_BUFFER, buffers[i]);
+            glBufferData(GL_TEXTURE_BUFFER, 16, NULL, GL_STREAM_DRAW);
+            GLState::instance().bindTexture(GL_TEXTURE_BUFFER, textures[i]);
+            glTexBuffer(GL_TEXTURE_BUFFER, formats[i], buffers[i]);
+        }
+        GLState::instance().bindTexture(GL_TEXTURE_BUFFER, 0);
+        GLState::instance().bindBuffer(GL_TEXTURE_BUFFER, 0);
+        clusterLights.resize(CLUSTER_COUNT);
+        grid.resize(CLUSTER_COUNT * 2);
+    }
+    // 释放 OpenGL 资源
+    void release() {
+        GLState::instance().deleteTextures(3, textures);
+        GLState::instance().deleteBuffers(3, buffers);
+    }
+    // 分簇：把光源分配到簇中并上传到 TBO
+    // lights: 世界空间点光源（radius 字段为 0 时根据衰减自动计算）
+    void update(const std::vector<PointLightStd140> &lights,
+                const glm::mat4 &view,
+                const glm::mat4 &projection) {
+        if (projection != cachedProjection) {
+            buildClusterBounds(projection);
+            cachedProjection = projection;
+        }
+        // 1. 计算每个光源在观察空间中的包围球，以及覆盖的深度切片和屏幕分块范围
+        spheres.clear();
+        for (unsigned int i = 0; i < lights.size(); ++i) {
+            LightSphere s;
+            if (cullLight(lights[i], view, projection, s)) {
+                s.index = i;
+                spheres.push_back(s);
+            }
+        }
+        visibleLights = (unsigned int)spheres.size();
+        // 2. 按深度切片分配到各个线程进行相交测试
+        threadCount = 1;
+        if (spheres.size() >= CLUSTER_PARALLEL_LIGHTS) {
+            unsigned int hw = std::thread::hardware_concurrency();
+            threadCount = std::max(1u, std::min(hw, (unsigned int)CLUSTER_Z));
+        }
+        if (threadCount == 1) {
+            assignSlices(0, 1);
+        } else {
+            std::vector<std::thread> workers;
+            for (unsigned int t = 1; t < threadCount; ++t)
+                workers.push_back(std::thread(&LightCluster::assignSlices, this, t, threadCount));
+            assignSlices(0, threadCount);
+            for (unsigned int t = 0; t < workers.size(); ++t)
+                workers[t].join();
+        }
+        // 3. 压缩为 (offset, count) 网格 + 连续索引列表
+        indices.clear();
+        for (unsigned int c = 0; c < CLUSTER_COUNT; ++c) {
+            grid[c * 2 + 0] = (unsigned int)indices.size();
+            grid[c * 2 + 1] = (unsigned int)clusterLights[c].size();
+            indices.insert(indices.end(), clusterLights[c].begin(), clusterLights[c].end());
+        }
+        indexCount = (unsigned int)indices.size();
+        // 4. 上传（重新分配缓冲区，避免等待上一帧仍在使用的数据）
+        upload(buffers[0], lights.size() * sizeof(PointLightStd140), lights.empty() ? NULL : &lights[0]);
+        upload(buffers[1], grid.size() * sizeof(unsigned int), &grid[0]);
+        upload(buffers[2], indices.size() * sizeof(unsigned int), indices.empty() ? NULL : &indices[0]);
+    }
+    // 配置着色器中的分簇参数（需先激活着色器程序）
+    void apply(const Shader &shader) const {
+        GLint viewport[4];
+        glGetIntegerv(GL_VIEWPORT, viewport);
+        shader.setInt("clusterLights", CLUSTER_LIGHT_UNIT);
+        shader.setInt("clusterGrid", CLUSTER_GRID_UNIT);
+        shader.setInt("clusterIndices", CLUSTER_INDEX_UNIT);
+        shader.setVec2("clusterTileSize", glm::vec2((float)viewport[2] / CLUSTER_X,
+                                                    (float)viewport[3] / CLUSTER_Y));
+        shader.setVec2("clusterViewportOrigin", glm::vec2((float)viewport[0], (float)viewport[1]));
+        // slice = log(depth / near) * scale
+        shader.setFloat("clusterNear", zNear);
+        shader.setFloat("clusterFar", zFar);
+        shader.setFloat("clusterSliceScale", CLUSTER_Z / std::log(zFar / zNear));
+    }
+    // 绑定 TBO 纹理
+    void bindTextures() const {
+        GLState::instance().bindTexture(CLUSTER_LIGHT_UNIT, GL_TEXTURE_BUFFER, textures[0]);
+        GLState::instance().bindTexture(CLUSTER_GRID_UNIT, GL_TEXTURE_BUFFER, textures[1]);
+        GLState::instance().bindTexture(CLUSTER_INDEX_UNIT, GL_TEXTURE_BUFFER, textures[2]);
+    }
+
+private:
+    // 观察空间中的光源包围球及其覆盖范围
+    struct LightSphere {
+        glm::vec3 center;
+        float radius;
+        int sliceMin, sliceMax;
+        int tileMinX, tileMaxX, tileMinY, tileMaxY;
+        unsigned int index;
+    };
+    float zNear, zFar;
+    glm::mat4 cachedProjection;
+    // 簇的观察空间 AABB（SoA 布局，x 方向连续存放便于 SIMD 处理）
+    std::vector<float> minX, maxX, minY, maxY, minZ, maxZ;
+    std::vector<LightSphere> spheres;
+    std::vector<std::vector<unsigned int> > clusterLights;
+    std::vector<unsigned int> grid;
+    std::vector<unsigned int> indices;
+    unsigned int buffers[3];
+    unsigned int textures[3];
+
+    // 第 k 个深度切片的近处深度（指数划分：near * (far/near)^(k/Z)）
+    float sliceDepth(int k) const {
+        return zNear * std::pow(zFar / zNear, (float)k / CLUSTER_Z);
+    }
+    int sliceOf(float depth) const {
+        int k = (int)std::floor(std::log(depth / zNear) / std::log(zFar / zNear) * CLUSTER_Z);
+        return std::min(std::max(k, 0), CLUSTER_Z - 1);
+    }
+    // 投影矩阵变化时重新计算所有簇的 AABB
+    void buildClusterBounds(const glm::mat4 &projection) {
+        minX.resize(CLUSTER_COUNT); maxX.resize(CLUSTER_COUNT);
+        minY.resize(CLUSTER_COUNT); maxY.resize(CLUSTER_COUNT);
+        minZ.resize(CLUSTER_COUNT); maxZ.resize(CLUSTER_COUNT);
+        for (int k = 0; k < CLUSTER_Z; ++k) {
+            float d0 = sliceDepth(k), d1 = sliceDepth(k + 1);
+            for (int y = 0; y < CLUSTER_Y; ++y) {
+                float ny0 = -1.0f + 2.0f * y / CLUSTER_Y, ny1 = -1.0f + 2.0f * (y + 1) / CLUSTER_Y;
+                for (int x = 0; x < CLUSTER_X; ++x) {
+                    float nx0 = -1.0f + 2.0f * x / CLUSTER_X, nx1 = -1.0f + 2.0f * (x + 1) / CLUSTER_X;
+                    // NDC 到观察空间：x_view = ndc_x * depth / P[0][0]
+                    float xs[4] = { nx0 * d0, nx1 * d0, nx0 * d1, nx1 * d1 };
+                    float ys[4] = { ny0 * d0, ny1 * d0, ny0 * d1, ny1 * d1 };
+                    int c = clusterIndex(x, y, k);
+                    minX[c] = *std::min_element(xs, xs + 4) / projection[0][0];
+                    maxX[c] = *std::max_element(xs, xs + 4) / projection[0][0];
+                    minY[c] = *std::min_element(ys, ys + 4) / projection[1][1];
+                    maxY[c] = *std::max_element(ys, ys + 4) / projection[1][1];
+                    minZ[c] = -d1;
+                    maxZ[c] = -d0;
+                }
+            }
+        }
+    }
+    static int clusterIndex(int x, int y, int z) {
+        return x + CLUSTER_X * (y + CLUSTER_Y * z);
+    }
+    // 视锥体剔除并计算光源覆盖的切片、分块范围（返回 false 表示光源不可见）
+    bool cullLight(const PointLightStd140 &light, const glm::mat4 &view,
+                   const glm::mat4 &projection, LightSphere &s) const {
+        s.center = glm::vec3(view * glm::vec4(light.position, 1.0f));
+        s.radius = light.radius > 0.0f ? light.radius : PointLightRadius(light);
+        float depthMin = -s.center.z - s.radius, depthMax = -s.center.z + s.radius;
+        if (depthMax < zNear || depthMin > zFar)
+            return false;
+        s.sliceMin = sliceOf(std::max(depthMin, zNear));
+        s.sliceMax = sliceOf(std::min(depthMax, zFar));
+        // 投影包围球的 AABB 得到屏幕分块范围（AABB 跨过近平面时保守地覆盖整个屏幕）
+        s.tileMinX = 0; s.tileMaxX = CLUSTER_X - 1;
+        s.tileMinY = 0; s.tileMaxY = CLUSTER_Y - 1;
+        if (depthMin > zNear) {
+            float ndcMinX = 1.0f, ndcMaxX = -1.0f, ndcMinY = 1.0f, ndcMaxY = -1.0f;
+            for (int i = 0; i < 8; ++i) {
+                glm::vec3 corner = s.center + s.radius * glm::vec3(i & 1 ? 1.0f : -1.0f,
+                                                                   i & 2 ? 1.0f : -1.0f,
+                                                                   i & 4 ? 1.0f : -1.0f);
+                glm::vec4 clip = projection * glm::vec4(corner, 1.0f);
+                ndcMinX = std::min(ndcMinX, clip.x / clip.w); ndcMaxX = std::max(ndcMaxX, clip.x / clip.w);
+                ndcMinY = std::min(ndcMinY, clip.y / clip.w); ndcMaxY = std::max(ndcMaxY, clip.y / clip.w);
+            }
+            if (ndcMaxX < -1.0f || ndcMinX > 1.0f || ndcMaxY < -1.0f || ndcMinY > 1.0f)
+                return false;
+            s.tileMinX = std::max(0, (int)std::floor((ndcMinX * 0.5f + 0.5f) * CLUSTER_X));
+            s.tileMaxX = std::min(CLUSTER_X - 1, (int)std::floor((ndcMaxX * 0.5f + 0.5f) * CLUSTER_X));
+            s.tileMinY = std::max(0, (int)std::floor((ndcMinY * 0.5f + 0.5f) * CLUSTER_Y));
+            s.tileMaxY = std::min(CLUSTER_Y - 1, (int)std::floor((ndcMaxY * 0.5f + 0.5f) * CLUSTER_Y));
+        }
+        return true;
+    }
+    // 线程入口：处理 slice % stride == first 的深度切片
+    void assignSlices(unsigned int first, unsigned int stride) {
+        for (int k = (int)first; k < CLUSTER_Z; k += (int)stride) {
+            for (int c = clusterIndex(0, 0, k); c < clusterIndex(0, 0, k + 1); ++c)
+                clusterLights[c].clear();
+            for (unsigned int i = 0; i < spheres.size(); ++i) {
+                const LightSphere &s = spheres[i];
+                if (k < s.sliceMin || k > s.sliceMax)
+                    continue;
+                for (int y = s.tileMinY; y <= s.tileMaxY; ++y)
+                    testRow(s, y, k);
+            }
+        }
+    }
+    // 包围球与一行簇 AABB 的相交测试（点到 AABB 的最近距离 <= 半径）
+    void testRow(const LightSphere &s, int y, int k) {
+        int row = clusterIndex(0, y, k);
+        float r2 = s.radius * s.radius;
+#if defined(__SSE2__)
+        __m128 cx = _mm_set1_ps(s.center.x), cy = _mm_set1_ps(s.center.y), cz = _mm_set1_ps(s.center.z);
+        __m128 zero = _mm_setzero_ps(), radius2 = _mm_set1_ps(r2);
+        for (int x = s.tileMinX & ~3; x <= s.tileMaxX; x += 4) {
+            int c = row + x;
+            __m128 dx = _mm_add_ps(_mm_max_ps(_mm_sub_ps(_mm_loadu_ps(&minX[c]), cx), zero),
+                                   _mm_max_ps(_mm_sub_ps(cx, _mm_loadu_ps(&maxX[c])), zero));
+            __m128 dy = _mm_add_ps(_mm_max_ps(_mm_sub_ps(_mm_loadu_ps(&minY[c]), cy), zero),
+                                   _mm_max_ps(_mm_sub_ps(cy, _mm_loadu_ps(&maxY[c])), zero));
+            __m128 dz = _mm_add_ps(_mm_max_ps(_mm_sub_ps(_mm_loadu_ps(&minZ[c]), cz), zero),
+                                   _mm_max_ps(_mm_sub_ps(cz, _mm_loadu_ps(&maxZ[c])), zero));
+            __m128 d2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+            int mask = _mm_movemask_ps(_mm_cmple_ps(d2, radius2));
+            for (int lane = 0; lane < 4; ++lane) {
+                if ((mask & (1 << lane)) && x + lane >= s.tileMinX && x + lane <= s.tileMaxX)
+                    clusterLights[c + lane].push_back(s.index);
+            }
+        }
+#else
+        for (int x = s.tileMinX; x <= s.tileMaxX; ++x) {
+            int c = row + x;
+            float dx = std::max(minX[c] - s.center.x, 0.0f) + std::max(s.center.x - maxX[c], 0.0f);
+            float dy = std::max(minY[c] - s.center.y, 0.0f) + std::max(s.center.y - maxY[c], 0.0f);
+            float dz = std::max(minZ[c] - s.center.z, 0.0f) + std::max(s.center.z - maxZ[c], 0.0f);
+            if (dx * dx + dy * dy + dz * dz <= r2)
+                clusterLights[c].push_back(s.index);
+        }
+#endif
+    }
+    void upload(unsigned int buffer, size_t bytes, const void *data) {
+        GLState::instance().bindBuffer(GL_TEXTURE_BUFFER, buffer);
+        glBufferData(GL_TEXTURE_BUFFER, std::max(bytes, (size_t)16), NULL, GL_STREAM_DRAW);
+        if (bytes > 0)
+            glBufferSubData(GL_TEXTURE_BUFFER, 0, bytes, data);
+    }
+};
+
+#endif /* light_cluster_h */
@@ -6,52 +6,47 @@ out vec4 FragColor;       // 输出颜色
 
 uniform vec3 viewPos;     // 观察者位置（相机位置）
 
+// 光源结构体（std140 布局：标量填入 vec3 后的空隙，需与 light_block.h 保持一致）
 // 定向光光源结构体
 struct DirLight {
-    vec3 direction;
+    vec3 direction; float padding0;
 
-    vec3 ambient;
-    vec3 diffuse;
-    vec3 specular;
+    vec3 ambient;   float padding1;
+    vec3 diffuse;   float padding2;
+    vec3 specular;  float padding3;
 };
-uniform DirLight dirLight;
 vec3 CalcDirLight(DirLight light, vec3 normal, vec3 viewDir);
 
 // 点光源结构体
 struct PointLight {
-    vec3 position;
+    vec3 position;  float constant;
 
-    float constant;
-    float linear;
-    float quadratic;
-
-    vec3 ambient;
-    vec3 diffuse;
-    vec3 specular;
+    vec3 ambient;   float linear;
+    vec3 diffuse;   float quadratic;
+    vec3 specular;  float radius;
 };
-#define NR_POINT_LIGHTS 4
-uniform PointLight pointLights[NR_POINT_LIGHTS];
 vec3 CalcPointLight(PointLight light, vec3 normal, vec3 fragPos, vec3 viewDir);
 
 // 聚光光源结构体
 struct SpotLight {
-    vec3 position;
-    vec3  direction;
-    float cutOff;
+    vec3 position;  float cutOff;
+    vec3 direction; float outerCutOff;
 
-    vec3 ambient;
-    vec3 diffuse;
-    vec3 specular;
-    
-    float constant;
-    float linear;
-    float quadratic;
-    
-    float outerCutOff;
+    vec3 ambient;   float constant;
+    vec3 diffuse;   float linear;
+    vec3 specular;  float quadratic;
 };
-uniform SpotLight spotLight;
 vec3 CalcSpotLight(SpotLight spotLight, vec3 normal, vec3 fragPos, vec3 viewDir);
 
+// 光源 Uniform 块（所有光照着色器共享同一个绑定点）
+#define MAX_POINT_LIGHTS 128
+layout (std140) uniform LightBlock {
+    DirLight   dirLight;
+    SpotLight  spotLight;
+    int        pointLightCount;
+    PointLight pointLights[MAX_POINT_LIGHTS];
+};
+
 // 材质结构体
 struct Material {
     sampler2D  diffuse;   // 漫反射光照分量（环境光分量几乎所有情况下都等于漫反射颜色）
@@ -72,7 +67,7 @@ void main()
     // 第一阶段：定向光照
     vec3 result = CalcDirLight(dirLight, norm, viewDir);
     // 第二阶段：点光源
-    for(int i = 0; i < NR_POINT_LIGHTS; i++)
+    for(int i = 0; i < pointLightCount; i++)
         result += CalcPointLight(pointLights[i], norm, FragPos, viewDir);
     // 第三阶段：聚光
     result += CalcSpotLight(spotLight, norm, FragPos, viewDir);
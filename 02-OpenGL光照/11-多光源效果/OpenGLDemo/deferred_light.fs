@@ -0,0 +1,101 @@
+#version 330 core
+// 延迟渲染光照 pass：全屏计算定向光和聚光（点光源由光体积 pass 叠加）
+out vec4 FragColor;
+
+uniform sampler2D gPosition;
+uniform sampler2D gNormal;
+uniform sampler2D gAlbedoSpec;
+uniform vec2  screenSize;  // G-buffer 尺寸
+uniform vec3  viewPos;     // 观察者位置（相机位置）
+uniform float shininess;   // 反光度
+
+// 光源结构体（std140 布局：标量填入 vec3 后的空隙，需与 light_block.h 保持一致）
+// 定向光光源结构体
+struct DirLight {
+    vec3 direction; float padding0;
+
+    vec3 ambient;   float padding1;
+    vec3 diffuse;   float padding2;
+    vec3 specular;  float padding3;
+};
+vec3 CalcDirLight(DirLight light, vec3 normal, vec3 viewDir, vec3 albedo, float specularity);
+
+// 点光源结构体
+struct PointLight {
+    vec3 position;  float constant;
+
+    vec3 ambient;   float linear;
+    vec3 diffuse;   float quadratic;
+    vec3 specular;  float radius;
+};
+
+// 聚光光源结构体
+struct SpotLight {
+    vec3 position;  float cutOff;
+    vec3 direction; float outerCutOff;
+
+    vec3 ambient;   float constant;
+    vec3 diffuse;   float linear;
+    vec3 specular;  float quadratic;
+};
+vec3 CalcSpotLight(SpotLight light, vec3 normal, vec3 fragPos, vec3 viewDir, vec3 albedo, float specularity);
+
+// 光源 Uniform 块（所有光照着色器共享同一个绑定点，延迟渲染的全屏 pass 只使用其中的定向光和聚光）
+#define MAX_POINT_LIGHTS 128
+layout (std140) uniform LightBlock {
+    DirLight   dirLight;
+    SpotLight  spotLight;
+    int        pointLightCount;
+    PointLight pointLights[MAX_POINT_LIGHTS];
+};
+
+void main()
+{
+    vec2 uv = gl_FragCoord.xy / screenSize;
+    vec4 position = texture(gPosition, uv);
+    // 没有写入几何体的像素保持背景色
+    if (position.w == 0.0)
+        discard;
+    vec3 fragPos = position.xyz;
+    vec3 norm = texture(gNormal, uv).xyz;
+    vec4 albedoSpec = texture(gAlbedoSpec, uv);
+    vec3 viewDir = normalize(viewPos - fragPos);
+
+    vec3 result = CalcDirLight(dirLight, norm, viewDir, albedoSpec.rgb, albedoSpec.a);
+    result += CalcSpotLight(spotLight, norm, fragPos, viewDir, albedoSpec.rgb, albedoSpec.a);
+    FragColor = vec4(result, 1.0);
+}
+
+// 定向光光照计算（与 colors.fs 相同，材质颜色从 G-buffer 读取）
+vec3 CalcDirLight(DirLight light, vec3 normal, vec3 viewDir, vec3 albedo, float specularity)
+{
+    vec3 lightDir = normalize(-light.direction);
+    float diff = max(dot(normal, lightDir), 0.0);
+    vec3 reflectDir = reflect(-lightDir, normal);
+    float spec = pow(max(dot(viewDir, reflectDir), 0.0), shininess);
+    vec3 ambient  = light.ambient  * albedo;
+    vec3 diffuse  = light.diffuse  * diff * albedo;
+    vec3 specular = light.specular * spec * specularity;
+    return (ambient + diffuse + specular);
+}
+
+// 聚光光照计算（与 colors.fs 相同，材质颜色从 G-buffer 读取）
+vec3 CalcSpotLight(SpotLight light, vec3 normal, vec3 fragPos, vec3 viewDir, vec3 albedo, float specularity)
+{
+    vec3 lightDir = normalize(light.position - fragPos);
+    float theta = dot(lightDir, normalize(-light.direction));
+    float epsilon = light.cutOff - light.outerCutOff;
+    float intensity = clamp((theta - light.outerCutOff) / epsilon, 0.0, 1.0);
+    vec3 ambient = light.ambient * albedo;
+    float diff = max(dot(normal, lightDir), 0.0);
+    vec3 diffuse = light.diffuse * diff * albedo;
+    vec3 reflectDir = reflect(-lightDir, normal);
+    float spec = pow(max(dot(viewDir, reflectDir), 0.0), shininess);
+    vec3 specular = light.specular * spec * specularity;
+    float distance    = length(light.position - fragPos);
+    float attenuation = 1.0 / (light.constant + light.linear * distance +
+                               light.quadratic * (distance * distance));
+    diffuse  *= attenuation * intensity;
+    specular *= attenuation * intensity;
+    return (ambient + diffuse + specular);
+}
@@ -0,0 +1,36 @@
+#version 330 core
+// 延迟渲染点光源 pass：光体积（球体）覆盖的像素才会执行，结果叠加到光照缓冲
+out vec4 FragColor;
+
+uniform sampler2D gPosition;
+uniform sampler2D gNormal;
+uniform sampler2D gAlbedoSpec;
+uniform vec2  screenSize;  // G-buffer 尺寸
+uniform vec3  viewPos;     // 观察者位置（相机位置）
+uniform float shininess;   // 反光度
+
+// 当前点光源（4 个 vec4，布局与 PointLightStd140 相同）
+// [0]: position, constant  [1]: ambient, linear  [2]: diffuse, quadratic  [3]: specular, radius
+uniform vec4 pointLight[4];
+
+void main()
+{
+    vec2 uv = gl_FragCoord.xy / screenSize;
+    vec3 fragPos = texture(gPosition, uv).xyz;
+    vec3 norm = texture(gNormal, uv).xyz;
+    vec4 albedoSpec = texture(gAlbedoSpec, uv);
+    vec3 viewDir = normalize(viewPos - fragPos);
+
+    vec3 lightPos = pointLight[0].xyz;
+    vec3 lightDir = normalize(lightPos - fragPos);
+    float diff = max(dot(norm, lightDir), 0.0);
+    vec3 reflectDir = reflect(-lightDir, norm);
+    float spec = pow(max(dot(viewDir, reflectDir), 0.0), shininess);
+    float distance    = length(lightPos - fragPos);
+    float attenuation = 1.0 / (pointLight[0].w + pointLight[1].w * distance +
+                               pointLight[2].w * (distance * distance));
+    vec3 ambient  = pointLight[1].xyz * albedoSpec.rgb;
+    vec3 diffuse  = pointLight[2].xyz * diff * albedoSpec.rgb;
+    vec3 specular = pointLight[3].xyz * spec * albedoSpec.a;
+    FragColor = vec4((ambient + diffuse + specular) * attenuation, 1.0);
+}
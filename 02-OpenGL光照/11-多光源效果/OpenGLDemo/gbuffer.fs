@@ -0,0 +1,25 @@
+#version 330 core
+// G-buffer 的三个颜色附件
+layout (location = 0) out vec4 gPosition;   // 世界空间位置
+layout (location = 1) out vec4 gNormal;     // 世界空间法向量
+layout (location = 2) out vec4 gAlbedoSpec; // rgb: 漫反射颜色, a: 镜面光强度
+
+in vec3 FragPos;
+in vec3 Normal;
+in vec2 TexCoords;
+
+// 材质结构体（与 colors.fs 相同）
+struct Material {
+    sampler2D  diffuse;
+    sampler2D  specular;
+    float      shininess;
+};
+uniform Material material;
+
+void main()
+{
+    gPosition = vec4(FragPos, 1.0);
+    gNormal = vec4(normalize(Normal), 0.0);
+    gAlbedoSpec.rgb = texture(material.diffuse, TexCoords).rgb;
+    gAlbedoSpec.a = texture(material.specular, TexCoords).r;
+}
@@ -20,17 +20,35 @@
 
 #include "shader_m.h"
 #include "camera.h"
+#include "light_block.h"
+#include "light_cluster.h"
+#include "deferred_renderer.h"
+#include "instance_buffer.h"
+#include "bvh.h"
 
 #include <iostream>
+#include <string>
+#include <vector>
+#include <random>
+#include <cstdlib>
+#include <chrono>
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb_image.h"
+#include "texture_cache.h"
+#include "headless.h"
+#include "bench_report.h"
 
 // 回调函数定义
 void framebuffer_size_callback(GLFWwindow* window, int width, int height);
 void mouse_callback(GLFWwindow* window, double xpos, double ypos);
 void scroll_callback(GLFWwindow* window, double xoffset, double yoffset);
+void mouse_button_callback(GLFWwindow* window, int button, int action, int mods);
 void processInput(GLFWwindow *window);
-unsigned int loadTexture(const char *path);
+TextureHandle loadTexture(const char *path);
+void generatePointLights(std::vector<PointLightStd140> &lights, int count);
+void generateCubes(InstanceBuffer &instances, int count);
+int pickCube(const InstanceBuffer &instances, const BVH &tree, const Ray &ray, float &distance);
+void benchmarkBVH(size_t triangleCount);
 
 // 配置
 const unsigned int SCR_WIDTH = 800;
@@ -42,6 +60,10 @@ float lastX = SCR_WIDTH / 2.0f;
 float lastY = SCR_HEIGHT / 2.0f;
 bool firstMouse = true;
 
+// 拾取（点击鼠标左键时在渲染中用光标位置发出射线）
+bool pickRequested = false;
+double pickX = 0.0, pickY = 0.0;
+
 // 光照位置
 //glm::vec3 lightPos(1.2f, 1.0f, 2.0f);
 
@@ -63,61 +85,123 @@ glm::vec3 cubePositions[] = {
     glm::vec3(-1.3f,  1.0f, -1.5f)
 };
 
-// 光源位置
-glm::vec3 pointLightPositions[] = {
+// 光源位置（前 4 个为场景自带的光源，基准测试时由 generatePointLights 追加）
+std::vector<glm::vec3> pointLightPositions = {
     glm::vec3( 0.7f,  0.2f,  2.0f),
     glm::vec3( 2.3f, -3.3f, -4.0f),
     glm::vec3(-4.0f,  2.0f, -12.0f),
     glm::vec3( 0.0f,  0.0f, -3.0f)
 };
 
+// 渲染路径（按 1、2、3 键切换）
+enum RenderPath {
+    FORWARD_PATH,   // 前向渲染：每个片段遍历全部点光源（最多 MAX_POINT_LIGHTS 个）
+    CLUSTERED_PATH, // 分簇前向渲染：每个片段只遍历所在簇的点光源
+    DEFERRED_PATH   // 延迟渲染：G-buffer + 模板测试的点光源光体积
+};
+RenderPath renderPath = FORWARD_PATH;
+
 int main(int argc, const char * argv[]) {
-    // --------------- 初始化 GLFW ---------------
-    glfwInit();
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
-    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
-#ifdef __APPLE__
-    glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
-#endif
-    
-    // --------------- 创建窗口 ---------------
-    GLFWwindow *window = glfwCreateWindow(SCR_WIDTH,
-                                          SCR_HEIGHT,
-                                          "Learn OpenGL",
-                                          NULL,
-                                          NULL);
-    if (window == NULL) {
-        std::cout << "创建窗口失败" << std::endl;
-        glfwTerminate();
-        return -1;
+    // 参数 --bench：按盒子数量 × 光源数量扫描，输出各渲染路径每帧耗时的百分位数和帧率后退出（格式见 bench_report.h）
+    // （在没有 GPU 的机器上可用 LIBGL_ALWAYS_SOFTWARE=1 GALLIUM_DRIVER=llvmpipe 运行）
+    // 参数 --bench-cubes N,N...：基准测试的盒子数量（默认为 --cubes 的值）
+    // 参数 --bench-lights N,N...：基准测试的光源数量（默认 4 到 1024）
+    // 参数 --bench-frames N：每个组合测量的帧数（默认 30，之前另有 5 帧预热）
+    // 参数 --bench-out FILE：基准测试结果同时追加到 CSV 文件
+    // 参数 --cubes N：盒子数量（默认 10 个，多出的盒子随机分布，用于测试实例化渲染）
+    // 参数 --bench-bvh [N]：在 N 个三角形（默认 100 万）的场景上测试 BVH 构建、重新拟合和查询的耗时后退出
+    bool benchmark = false;
+    int cubeCount = 10;
+    std::vector<int> benchCubes, benchLights = { 4, 16, 64, 128, 256, 512, 1024 };
+    int benchFrames = 30;
+    BenchReport::instance().parseArguments(argc, argv);
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--bench")
+            benchmark = true;
+        else if (arg == "--bench-cubes" && i + 1 < argc)
+            benchCubes = BenchReport::ParseList(argv[++i]);
+        else if (arg == "--bench-lights" && i + 1 < argc)
+            benchLights = BenchReport::ParseList(argv[++i]);
+        else if (arg == "--bench-frames" && i + 1 < argc)
+            benchFrames = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--cubes" && i + 1 < argc)
+            cubeCount = std::max(10, std::atoi(argv[++i]));
+        else if (arg == "--bench-bvh") {
+            size_t triangles = 1000000;
+            if (i + 1 < argc && argv[i + 1][0] != '-')
+                triangles = (size_t)std::atol(argv[++i]);
+            benchmarkBVH(triangles);
+            return 0;
+        }
     }
-    // 配置上下文环境
-    glfwMakeContextCurrent(window);
-    // 配置帧缓存大小变化回调
-    glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
-    // 配置鼠标事件回调
-    glfwSetCursorPosCallback(window, mouse_callback);
-    // 配置滚轮事件回调
-    glfwSetScrollCallback(window, scroll_callback);
-    // 隐藏鼠标光标展示
-    glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
     
-    // --------------- 初始化 GLAD ---------------
-    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
-        std::cout << "初始化 GLAD 拓展失败" << std::endl;
-        return -1;
+    // --------------- 离屏模式 ---------------
+    // 参数 --headless [宽x高] / --frames N / --dump FILE：不创建窗口，渲染到 FBO 中，渲染满 N 帧后退出
+    Headless &headless = Headless::instance();
+    headless.parseArguments(argc, argv);
+    GLFWwindow *window = NULL;
+    if (headless.enabled()) {
+        if (!headless.initialize()) {
+            std::cout << "创建离屏渲染上下文失败" << std::endl;
+            return -1;
+        }
+        // 脚本相机：从初始位置开始绕原点环绕
+        headless.cameraPath().setOrbit(glm::vec3(0.0f, 0.0f, 0.0f), camera.Position);
+    } else {
+        // --------------- 初始化 GLFW ---------------
+        glfwInit();
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+        glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+#ifdef __APPLE__
+        glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+#endif
+        
+        // --------------- 创建窗口 ---------------
+        window = glfwCreateWindow(SCR_WIDTH,
+                                  SCR_HEIGHT,
+                                  "Learn OpenGL",
+                                  NULL,
+                                  NULL);
+        if (window == NULL) {
+            std::cout << "创建窗口失败" << std::endl;
+            glfwTerminate();
+            return -1;
+        }
+        // 配置上下文环境
+        glfwMakeContextCurrent(window);
+        // 配置帧缓存大小变化回调
+        glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+        // 配置鼠标事件回调
+        glfwSetCursorPosCallback(window, mouse_callback);
+        // 配置滚轮事件回调
+        glfwSetScrollCallback(window, scroll_callback);
+        // 配置鼠标按键回调（拾取）
+        glfwSetMouseButtonCallback(window, mouse_button_callback);
+        // 隐藏鼠标光标展示
+        glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+        
+        // --------------- 初始化 GLAD ---------------
+        if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
+            std::cout << "初始化 GLAD 拓展失败" << std::endl;
+            return -1;
+        }
     }
     
     // --------------- 配置 OpenGL 全局状态 ---------------
     // 打开深度测试功能
-    glEnable(GL_DEPTH_TEST);
+    GLState::instance().enable(GL_DEPTH_TEST);
     
     // --------------- 创建着色器程序 ---------------
     // 构建并编译反光物体着色器
     Shader lightingShader("colors.vs", "colors.fs");
+    // 构建并编译分簇前向渲染着色器
+    Shader clusteredShader("colors.vs", "colors_clustered.fs");
     // 构建并编译发光物体着色器
     Shader lampShader("lamp.vs", "lamp.fs");
+    // 延迟渲染（G-buffer 在第一次渲染时按帧缓冲大小创建）
+    DeferredRenderer deferredRenderer(0.1f);
     
     // --------------- 配置顶点数据和顶点属性 ---------------
     // 六个面的顶点数据
@@ -169,12 +253,12 @@ int main(int argc, const char * argv[]) {
     // VBO 配置（保存顶点数据缓冲）
     unsigned int VBO;
     glGenBuffers(1, &VBO);
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    GLState::instance().bindBuffer(GL_ARRAY_BUFFER, VBO);
     glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
     // 反光 VAO 配置（保存顶点属性）
     unsigned int cubeVAO;
     glGenVertexArrays(1, &cubeVAO);
-    glBindVertexArray(cubeVAO);
+    GLState::instance().bindVertexArray(cubeVAO);
     // 顶点位置
     glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
     glEnableVertexAttribArray(0);
@@ -187,151 +271,279 @@ int main(int argc, const char * argv[]) {
     // 发光 VAO 配置（保存顶点属性）
     unsigned int lightVAO;
     glGenVertexArrays(1, &lightVAO);
-    glBindVertexArray(lightVAO);
-    glBindBuffer(GL_ARRAY_BUFFER, VBO); // 共用VBO
+    GLState::instance().bindVertexArray(lightVAO);
+    GLState::instance().bindBuffer(GL_ARRAY_BUFFER, VBO); // 共用VBO
     glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
     glEnableVertexAttribArray(0);
+    // 实例缓冲配置（每个盒子的模型矩阵和法线矩阵，盒子不会移动，只需设置一次）
+    InstanceBuffer cubeInstances;
+    cubeInstances.attach(cubeVAO);
+    cubeInstances.setBounds(AABB(glm::vec3(-0.5f), glm::vec3(0.5f)));  // 盒子顶点的范围（用于视锥体剔除）
+    generateCubes(cubeInstances, cubeCount);
+    // 盒子的 BVH（用于鼠标拾取，盒子不会移动，只需构建一次）
+    std::vector<AABB> cubeBoxes(cubeInstances.size());
+    for (unsigned int i = 0; i < cubeBoxes.size(); ++i)
+        cubeBoxes[i] = cubeInstances.worldBounds(i);
+    BVH cubeTree;
+    cubeTree.build(cubeBoxes);
     
     // 纹理设置
-    unsigned int diffuseMap = loadTexture("./container2.png");
-    unsigned int specularMap = loadTexture("./container2_specular.png");
+    TextureHandle diffuseMap = loadTexture("./container2.png");
+    TextureHandle specularMap = loadTexture("./container2_specular.png");
     // 带颜色的镜面光贴图
-    lightingShader.use();
-    lightingShader.setInt("material.diffuse", 0);
-    lightingShader.setInt("material.specular", 1);
+    Shader *litShaders[] = { &lightingShader, &clusteredShader, &deferredRenderer.geometryShader };
+    for (Shader *shader : litShaders) {
+        shader->use();
+        shader->setInt("material.diffuse", 0);
+        shader->setInt("material.specular", 1);
+        shader->setFloat("material.shininess", 32.0f);
+    }
     
-    // --------------- 渲染循环 ---------------
-    while (!glfwWindowShouldClose(window)) {
-        // 0: 每一帧的时间逻辑(用于进行性能监控)
-        float currentFrame = glfwGetTime();
-        deltaTime = currentFrame - lastFrame;
-        lastFrame = currentFrame;
-
-        // 1: 处理用户输入
-        processInput(window);
-
-        // 2: 背景色渲染
-        glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    // 光源 UBO 配置（固定参数只需设置一次，每帧只更新会变化的部分）
+    LightBlock lightBlock;
+    lightBlock.bind(lightingShader);
+    lightBlock.bind(clusteredShader);
+    lightBlock.bind(deferredRenderer.lightBlockShader());
+    // 定向光光源
+    lightBlock.data.dirLight.direction = glm::vec3(-2.0f, -3.0f, -5.0f);
+    lightBlock.data.dirLight.ambient   = glm::vec3(0.05f, 0.05f, 0.05f);
+    lightBlock.data.dirLight.diffuse   = glm::vec3(0.4f, 0.4f, 0.4f);
+    lightBlock.data.dirLight.specular  = glm::vec3(0.5f, 0.5f, 0.5f);
+    // 点光源（前向路径使用 LightBlock 中的前 MAX_POINT_LIGHTS 个，分簇路径使用全部）
+    std::vector<PointLightStd140> pointLights;
+    LightCluster lightCluster(0.1f, 100.0f);
+    auto setupPointLights = [&](int count) {
+        generatePointLights(pointLights, count);
+        lightBlock.clearPointLights();
+        for (unsigned int i = 0; i < pointLights.size(); ++i)
+            lightBlock.addPointLight(pointLights[i]);
+    };
+    setupPointLights((int)pointLightPositions.size());
+    // 聚光（跟随相机）
+    lightBlock.data.spotLight.ambient     = glm::vec3(0.0f, 0.0f, 0.0f);
+    lightBlock.data.spotLight.diffuse     = glm::vec3(1.0f, 1.0f, 1.0f);
+    lightBlock.data.spotLight.specular    = glm::vec3(1.0f, 1.0f, 1.0f);
+    lightBlock.data.spotLight.constant    = 1.0f;
+    lightBlock.data.spotLight.linear      = 0.09f;
+    lightBlock.data.spotLight.quadratic   = 0.032f;
+    lightBlock.data.spotLight.cutOff      = glm::cos(glm::radians(12.5f));
+    lightBlock.data.spotLight.outerCutOff = glm::cos(glm::radians(15.0f));
+    
+    // 每个物体都要设置的 uniform 提前获取句柄
+    UniformHandle lampModelLoc = lampShader.getUniform("model");
+    
+    // uniform 统计（每秒输出一次平均每帧的数据）
+    float statsTime = 0.0f;
+    unsigned int statsFrames = 0;
+    UniformStats statsSum = { 0, 0, 0, 0 };
+    GLStateStats stateSum = { 0, 0 };
+    CullStats cubeCull = { 0, 0 }, cullSum = { 0, 0 };
+    
+    // --------------- 场景渲染 ---------------
+    auto renderScene = [&]() {
+        // 2: 背景色渲染（延迟路径渲染到 G-buffer）
+        if (renderPath == DEFERRED_PATH) {
+            int width = (int)headless.width(), height = (int)headless.height();
+            if (!headless.enabled())
+                glfwGetFramebufferSize(window, &width, &height);
+            deferredRenderer.resize(width, height);
+            deferredRenderer.beginGeometryPass(glm::vec4(0.1f, 0.1f, 0.1f, 1.0f));
+        } else {
+            glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        }
         
         // 3: 配置反光物体着色器
         // 3-1: 激活着色器程序
-        lightingShader.use();
+        Shader &litShader = renderPath == CLUSTERED_PATH ? clusteredShader
+                          : renderPath == DEFERRED_PATH ? deferredRenderer.geometryShader
+                          : lightingShader;
+        litShader.use();
         
         // 3-2: 设置着色器的 uniform
-        lightingShader.setVec3("viewPos", camera.Position);
-        
-        // 光照相关分量
-        // 定向光光源
-//        lightingShader.setVec3("dirLight.direction", -0.2f, -1.0f, -0.3f);
-        lightingShader.setVec3("dirLight.direction", -2.0f, -3.0f, -5.0f);
-        lightingShader.setVec3("dirLight.ambient", 0.05f, 0.05f, 0.05f);
-        lightingShader.setVec3("dirLight.diffuse", 0.4f, 0.4f, 0.4f);
-        lightingShader.setVec3("dirLight.specular", 0.5f, 0.5f, 0.5f);
-        // 点光源
-        // 点光源0
-        lightingShader.setVec3("pointLights[0].position", pointLightPositions[0]);
-        lightingShader.setVec3("pointLights[0].ambient", 0.05f, 0.05f, 0.05f);
-        lightingShader.setVec3("pointLights[0].diffuse", 0.8f, 0.8f, 0.8f);
-        lightingShader.setVec3("pointLights[0].specular", 1.0f, 1.0f, 1.0f);
-        lightingShader.setFloat("pointLights[0].constant", 1.0f);
-        lightingShader.setFloat("pointLights[0].linear", 0.09);
-        lightingShader.setFloat("pointLights[0].quadratic", 0.032);
-        // 点光源1
-        lightingShader.setVec3("pointLights[1].position", pointLightPositions[1]);
-        lightingShader.setVec3("pointLights[1].ambient", 0.05f, 0.05f, 0.05f);
-        lightingShader.setVec3("pointLights[1].diffuse", 0.8f, 0.8f, 0.8f);
-        lightingShader.setVec3("pointLights[1].specular", 1.0f, 1.0f, 1.0f);
-        lightingShader.setFloat("pointLights[1].constant", 1.0f);
-        lightingShader.setFloat("pointLights[1].linear", 0.09);
-        lightingShader.setFloat("pointLights[1].quadratic", 0.032);
-        // 点光源2
-        lightingShader.setVec3("pointLights[2].position", pointLightPositions[2]);
-        lightingShader.setVec3("pointLights[2].ambient", 0.05f, 0.05f, 0.05f);
-        lightingShader.setVec3("pointLights[2].diffuse", 0.8f, 0.8f, 0.8f);
-        lightingShader.setVec3("pointLights[2].specular", 1.0f, 1.0f, 1.0f);
-        lightingShader.setFloat("pointLights[2].constant", 1.0f);
-        lightingShader.setFloat("pointLights[2].linear", 0.09);
-        lightingShader.setFloat("pointLights[2].quadratic", 0.032);
-        // 点光源3
-        lightingShader.setVec3("pointLights[3].position", pointLightPositions[3]);
-        lightingShader.setVec3("pointLights[3].ambient", 0.05f, 0.05f, 0.05f);
-        lightingShader.setVec3("pointLights[3].diffuse", 0.8f, 0.8f, 0.8f);
-        lightingShader.setVec3("pointLights[3].specular", 1.0f, 1.0f, 1.0f);
-        lightingShader.setFloat("pointLights[3].constant", 1.0f);
-        lightingShader.setFloat("pointLights[3].linear", 0.09);
-        lightingShader.setFloat("pointLights[3].quadratic", 0.032);
-        // 点光源4
-        lightingShader.setVec3("spotLight.position", camera.Position);
-        lightingShader.setVec3("spotLight.direction", camera.Front);
-        lightingShader.setVec3("spotLight.ambient", 0.0f, 0.0f, 0.0f);
-        lightingShader.setVec3("spotLight.diffuse", 1.0f, 1.0f, 1.0f);
-        lightingShader.setVec3("spotLight.specular", 1.0f, 1.0f, 1.0f);
-        lightingShader.setFloat("spotLight.constant", 1.0f);
-        lightingShader.setFloat("spotLight.linear", 0.09);
-        lightingShader.setFloat("spotLight.quadratic", 0.032);
-        lightingShader.setFloat("spotLight.cutOff", glm::cos(glm::radians(12.5f)));
-        lightingShader.setFloat("spotLight.outerCutOff", glm::cos(glm::radians(15.0f)));
-        
-        // 材质相关分量
-        lightingShader.setFloat("material.shininess", 32.0f);
+        if (renderPath != DEFERRED_PATH)
+            litShader.setVec3("viewPos", camera.Position);
         
         // 3-3: 配置投影矩阵
         glm::mat4 projection = glm::perspective(glm::radians(camera.Zoom),
-                                                (float)SCR_WIDTH / (float)SCR_HEIGHT,
+                                                headless.aspect((float)SCR_WIDTH / (float)SCR_HEIGHT),
                                                 0.1f,
                                                 100.0f);
-        lightingShader.setMat4("projection", projection);
+        litShader.setMat4("projection", projection);
         // 3-4: 配置视图矩阵
         glm::mat4 view = camera.GetViewMatrix();
-        lightingShader.setMat4("view", view);
+        litShader.setMat4("view", view);
         
-        glm::mat4 model = glm::mat4(1.0f);
-        lightingShader.setMat4("model", model);
+        // 光照相关分量（整个 LightBlock 一次上传）
+        lightBlock.data.spotLight.position  = camera.Position;
+        lightBlock.data.spotLight.direction = camera.Front;
+        lightBlock.upload();
+        // 分簇路径：把点光源分配到视锥体的簇中
+        if (renderPath == CLUSTERED_PATH) {
+            lightCluster.update(pointLights, view, projection);
+            lightCluster.apply(clusteredShader);
+            lightCluster.bindTextures();
+        }
 
         // 绑定纹理
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, diffuseMap);
-        glActiveTexture(GL_TEXTURE1);
-        glBindTexture(GL_TEXTURE_2D, specularMap);
+        GLState::instance().bindTexture(0, GL_TEXTURE_2D, diffuseMap.id());
+        GLState::instance().bindTexture(1, GL_TEXTURE_2D, specularMap.id());
         
         // 4: 渲染反光物体
-        glBindVertexArray(cubeVAO);
-        for (int i = 0; i < 10; ++i) {
-            // 3-5: 配置模型矩阵
-            glm::mat4 model;
-            model = glm::translate(model, cubePositions[i]);
-            float angle = 20.0f * i;
-            model = glm::rotate(model, glm::radians(angle), glm::vec3(1.0f, 0.3f, 0.5f));
-            lightingShader.setMat4("model", model);
-            
-            glDrawArrays(GL_TRIANGLES, 0, 36);
+        // 模型矩阵在实例缓冲中，剔除视锥体外的盒子后一次绘制全部可见的盒子
+        cubeCull = cubeInstances.cull(Frustum(projection, view));
+        GLState::instance().bindVertexArray(cubeVAO);
+        cubeInstances.draw(GL_TRIANGLES, 0, 36);
+        // 拾取：世界空间射线在盒子 BVH 中查找最近的盒子
+        if (pickRequested) {
+            pickRequested = false;
+            float distance;
+            // 光标位置是窗口坐标，按当前的窗口大小换算（离屏时为渲染大小）
+            int width = (int)headless.width(), height = (int)headless.height();
+            if (!headless.enabled())
+                glfwGetWindowSize(window, &width, &height);
+            int picked = pickCube(cubeInstances, cubeTree, ScreenRay(pickX, pickY, width, height, projection * view), distance);
+            if (picked >= 0)
+                std::cout << "拾取: 盒子 " << picked << ", 射线参数 " << distance << std::endl;
+            else
+                std::cout << "拾取: 没有命中" << std::endl;
         }
+        // 延迟路径：根据 G-buffer 计算光照（之后的发光物体仍然画到光照缓冲中）
+        if (renderPath == DEFERRED_PATH)
+            deferredRenderer.lightingPass(pointLights, view, projection, camera.Position, 32.0f);
         
         // 4. 渲染点光源
         lampShader.use();
         lampShader.setMat4("projection", projection);
         lampShader.setMat4("view", view);
-        glBindVertexArray(lightVAO);
-        for (unsigned int i = 0; i < 4; i++)
+        GLState::instance().bindVertexArray(lightVAO);
+        for (unsigned int i = 0; i < pointLightPositions.size(); i++)
         {
-            model = glm::mat4(1.0f);
+            glm::mat4 model = glm::mat4(1.0f);
             model = glm::translate(model, pointLightPositions[i]);
             model = glm::scale(model, glm::vec3(0.2f)); // Make it a smaller cube
-            lampShader.setMat4("model", model);
+            lampShader.setMat4(lampModelLoc, model);
             glDrawArrays(GL_TRIANGLES, 0, 36);
         }
+        if (renderPath == DEFERRED_PATH)
+            deferredRenderer.present();
+    };
+    
+    // --------------- 基准测试 ---------------
+    // 每个组合（盒子数量 × 光源数量 × 渲染路径）一行结果，每帧之后 glFinish，样本为单帧的完整耗时
+    if (benchmark) {
+        if (!headless.enabled())
+            glfwSwapInterval(0);
+        std::cout << "renderer: " << glGetString(GL_RENDERER) << std::endl;
+        if (benchCubes.empty())
+            benchCubes.push_back(cubeCount);
+        const int warmupFrames = 5;
+        const char *pathNames[] = { "lighting.forward", "lighting.clustered", "lighting.deferred" };
+        std::string size = std::to_string(headless.enabled() ? headless.width() : SCR_WIDTH) + "x"
+                         + std::to_string(headless.enabled() ? headless.height() : SCR_HEIGHT);
+        std::vector<double> samples;
+        for (int cubes : benchCubes) {
+            generateCubes(cubeInstances, std::max(10, cubes));
+            for (int count : benchLights) {
+                setupPointLights(count);
+                RenderPath paths[] = { FORWARD_PATH, CLUSTERED_PATH, DEFERRED_PATH };
+                for (RenderPath path : paths) {
+                    // 前向路径受 UBO 大小限制
+                    if (path == FORWARD_PATH && count > MAX_POINT_LIGHTS)
+                        continue;
+                    renderPath = path;
+                    for (int i = 0; i < warmupFrames; ++i) {
+                        renderScene();
+                        if (!headless.enabled())
+                            glfwSwapBuffers(window);
+                    }
+                    glFinish();
+                    // 离屏模式下 headless.time() 是按帧推进的虚拟时间，这里用实际时间
+                    samples.clear();
+                    for (int i = 0; i < benchFrames; ++i) {
+                        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+                        renderScene();
+                        if (!headless.enabled()) {
+                            glfwSwapBuffers(window);
+                            glfwPollEvents();
+                        }
+                        glFinish();
+                        samples.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+                    }
+                    BenchReport::instance().add(pathNames[path], "cubes=" + std::to_string(std::max(10, cubes))
+                                                + ";lights=" + std::to_string(count) + ";size=" + size,
+                                                samples, 1.0, "frames/s");
+                }
+            }
+        }
+    }
+    
+    // --------------- 渲染循环 ---------------
+    // 基准测试结束后直接释放资源退出
+    while (!benchmark && headless.running(window)) {
+        // 0: 每一帧的时间逻辑(用于进行性能监控)
+        float currentFrame = headless.time();
+        deltaTime = currentFrame - lastFrame;
+        lastFrame = currentFrame;
+
+        // 1: 处理用户输入
+        if (headless.enabled())
+            headless.cameraPath().apply(camera, currentFrame);
+        else
+            processInput(window);
+
+        // 2~4: 渲染场景
+        renderScene();
         
-        // 5. 交换缓冲
-        glfwSwapBuffers(window);
-        // 6. 获取输入事件
-        glfwPollEvents();
+        // 5. 统计 uniform 调用和状态切换
+        UniformStats frame = Shader::frameStats();
+        statsSum.lookupsSaved += frame.lookupsSaved;
+        statsSum.uploadsSkipped += frame.uploadsSkipped;
+        statsSum.uploadsIssued += frame.uploadsIssued;
+        statsSum.lookupFallbacks += frame.lookupFallbacks;
+        GLStateStats state = GLState::frameStats();
+        stateSum.callsIssued += state.callsIssued;
+        stateSum.callsElided += state.callsElided;
+        cullSum.visible += cubeCull.visible;
+        cullSum.culled += cubeCull.culled;
+        ++statsFrames;
+        statsTime += deltaTime;
+        if (statsTime >= 1.0f) {
+            std::cout << "uniform 每帧: 上传 " << statsSum.uploadsIssued / statsFrames
+                      << " 次, 节省 GL 调用 " << statsSum.callsSaved() / statsFrames
+                      << " 次 (查找 " << statsSum.lookupsSaved / statsFrames
+                      << ", 冗余上传 " << statsSum.uploadsSkipped / statsFrames
+                      << "), 回退到 glGetUniformLocation " << statsSum.lookupFallbacks / statsFrames << " 次" << std::endl;
+            std::cout << "状态切换每帧: 调用 " << stateSum.callsIssued / statsFrames
+                      << " 次, 跳过冗余调用 " << stateSum.callsElided / statsFrames << " 次" << std::endl;
+            std::cout << "视锥体剔除每帧: 可见 " << cullSum.visible / statsFrames << " 个盒子, 剔除 "
+                      << cullSum.culled / statsFrames << " 个" << std::endl;
+            statsSum = UniformStats{ 0, 0, 0, 0 };
+            stateSum = GLStateStats{ 0, 0 };
+            cullSum = CullStats{ 0, 0 };
+            statsFrames = 0;
+            statsTime = 0.0f;
+        }
+        
+        // 6. 交换缓冲
+        if (headless.enabled()) {
+            headless.present();
+        } else {
+            glfwSwapBuffers(window);
+            // 7. 获取输入事件
+            glfwPollEvents();
+        }
     }
     
     // --------------- 释放/删除之前的分配的所有资源 ---------------
-    glDeleteVertexArrays(1, &cubeVAO);
-    glDeleteVertexArrays(1, &lightVAO);
-    glDeleteBuffers(1, &VBO);
+    GLState::instance().deleteVertexArrays(1, &cubeVAO);
+    GLState::instance().deleteVertexArrays(1, &lightVAO);
+    GLState::instance().deleteBuffers(1, &VBO);
+    GLState::instance().deleteBuffers(1, &lightBlock.UBO);
+    lightCluster.release();
+    deferredRenderer.release();
+    cubeInstances.release();
+    headless.release();
     glfwTerminate();
     
     return 0;
@@ -350,6 +562,14 @@ void processInput(GLFWwindow *window) {
         camera.ProcessKeyboard(LEFT, deltaTime);
     if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS)
         camera.ProcessKeyboard(RIGHT, deltaTime);
+    
+    // 切换渲染路径
+    if (glfwGetKey(window, GLFW_KEY_1) == GLFW_PRESS)
+        renderPath = FORWARD_PATH;
+    if (glfwGetKey(window, GLFW_KEY_2) == GLFW_PRESS)
+        renderPath = CLUSTERED_PATH;
+    if (glfwGetKey(window, GLFW_KEY_3) == GLFW_PRESS)
+        renderPath = DEFERRED_PATH;
 }
 
 // 处理窗口变化事件（系统或用户所为）
@@ -374,17 +594,36 @@ void mouse_callback(GLFWwindow* window, double xpos, double ypos) {
     camera.ProcessMouseMovement(xoffset, yoffset);
 }
 
+// 处理鼠标按键事件：左键拾取。光标被隐藏时相机跟随鼠标转动，拾取屏幕中心（准星），
+// 否则拾取 mouse_callback 记录的光标位置
+void mouse_button_callback(GLFWwindow* window, int button, int action, int mods) {
+    if (button != GLFW_MOUSE_BUTTON_LEFT || action != GLFW_PRESS)
+        return;
+    if (glfwGetInputMode(window, GLFW_CURSOR) == GLFW_CURSOR_DISABLED) {
+        int width, height;
+        glfwGetWindowSize(window, &width, &height);
+        pickX = width / 2.0;
+        pickY = height / 2.0;
+    } else {
+        pickX = lastX;
+        pickY = lastY;
+    }
+    pickRequested = true;
+}
+
 // 处理鼠标滚轮事件
 void scroll_callback(GLFWwindow* window, double xoffset, double yoffset) {
     camera.ProcessMouseScroll(yoffset);
 }
 
-// 纹理加载函数
-unsigned int loadTexture(char const * path) {
-    unsigned int textureID;
-    glGenTextures(1, &textureID);
+// 纹理加载函数（通过进程级纹理缓存，同一文件只解码上传一次）
+TextureHandle loadTexture(char const * path) {
+    bool created = false;
+    TextureHandle texture = TextureCache::instance().acquire(path, &created);
+    if (!created)
+        return texture;
     
-    int width, height, nrComponents;
+    int width = 0, height = 0, nrComponents = 0;
     unsigned char *data = stbi_load(path, &width, &height, &nrComponents, 0);
     if (data) {
         GLenum format;
@@ -395,7 +634,7 @@ unsigned int loadTexture(char const * path) {
         else if (nrComponents == 4)
             format = GL_RGBA;
 
-        glBindTexture(GL_TEXTURE_2D, textureID);
+        GLState::instance().bindTexture(GL_TEXTURE_2D, texture.id());
         glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
         glGenerateMipmap(GL_TEXTURE_2D);
 
@@ -409,6 +648,215 @@ unsigned int loadTexture(char const * path) {
         std::cout << "Texture failed to load at path: " << path << std::endl;
         stbi_image_free(data);
     }
+    // 登记尺寸（估算显存占用）
+    TextureCache::instance().commit(texture.id(), width, height, nrComponents);
+    
+    return texture;
+}
+
+// 生成点光源（基准测试场景）
+// 前 4 个为场景自带的光源，其余光源以固定种子随机分布在盒子所在的区域，
+// 使用较短的衰减距离，保证每次运行生成的场景完全相同
+void generatePointLights(std::vector<PointLightStd140> &lights, int count) {
+    pointLightPositions.resize(4);
+    lights.clear();
+    std::mt19937 rng(2020);
+    std::uniform_real_distribution<float> x(-5.0f, 5.0f), y(-4.0f, 6.0f), z(-16.0f, 3.0f), c(0.2f, 1.0f);
+    for (int i = 0; i < count; ++i) {
+        PointLightStd140 light;
+        light.ambient  = glm::vec3(0.05f, 0.05f, 0.05f);
+        light.constant = 1.0f;
+        light.radius   = 0.0f;
+        if (i < 4) {
+            light.position  = pointLightPositions[i];
+            light.diffuse   = glm::vec3(0.8f, 0.8f, 0.8f);
+            light.specular  = glm::vec3(1.0f, 1.0f, 1.0f);
+            light.linear    = 0.09f;
+            light.quadratic = 0.032f;
+        } else {
+            light.position  = glm::vec3(x(rng), y(rng), z(rng));
+            light.ambient   = glm::vec3(0.0f, 0.0f, 0.0f);
+            light.diffuse   = glm::vec3(c(rng), c(rng), c(rng)) * 0.5f;
+            light.specular  = light.diffuse;
+            light.linear    = 0.7f;
+            light.quadratic = 1.8f;
+            pointLightPositions.push_back(light.position);
+        }
+        light.radius = PointLightRadius(light);
+        lights.push_back(light);
+    }
+}
+
+// 生成盒子实例
+// 前 10 个为场景自带的盒子，其余以固定种子随机分布在场景周围（盒子越多分布范围越大）
+void generateCubes(InstanceBuffer &instances, int count) {
+    instances.clear();
+    instances.reserve(count);
+    std::mt19937 rng(2020);
+    float extent = 8.0f * std::cbrt(count / 10.0f);
+    std::uniform_real_distribution<float> x(-extent, extent), y(-extent, extent), z(-2.0f * extent, 0.0f);
+    std::uniform_real_distribution<float> angle(0.0f, 360.0f);
+    for (int i = 0; i < count; ++i) {
+        glm::mat4 model;
+        if (i < 10) {
+            model = glm::translate(model, cubePositions[i]);
+            model = glm::rotate(model, glm::radians(20.0f * i), glm::vec3(1.0f, 0.3f, 0.5f));
+        } else {
+            model = glm::translate(model, glm::vec3(x(rng), y(rng), z(rng)));
+            model = glm::rotate(model, glm::radians(angle(rng)), glm::vec3(1.0f, 0.3f, 0.5f));
+        }
+        instances.add(model);
+    }
+}
+
+// 射线拾取盒子：BVH 用世界空间包围盒找到候选，再把射线变换到盒子的局部空间精确求交
+// （仿射变换不改变射线参数 t，不同盒子的命中距离可以直接比较）
+int pickCube(const InstanceBuffer &instances, const BVH &tree, const Ray &ray, float &distance) {
+    distance = 1.0f;
+    const AABB &local = instances.bounds();
+    return tree.intersect(ray, distance, [&](unsigned int index, float &tMax) {
+        glm::mat4 inverse = glm::inverse(instances.model(index));
+        glm::vec4 origin = inverse * glm::vec4(ray.origin, 1.0f);
+        glm::vec4 direction = inverse * glm::vec4(ray.direction, 0.0f);
+        Ray localRay(glm::vec3(origin.x, origin.y, origin.z), glm::vec3(direction.x, direction.y, direction.z));
+        float t;
+        if (!IntersectAABB(localRay, local.min, local.max, tMax, t) || t >= tMax)
+            return false;
+        tMax = t;
+        return true;
+    });
+}
+
+// BVH 基准测试：随机分布的球体组成 triangleCount 个三角形的场景，输出
+// 构建、重新拟合（一半球体移动后）耗时，SAH 代价，视锥体查询（与逐个测试对比）和射线查询的吞吐量
+void benchmarkBVH(size_t triangleCount) {
+    typedef std::chrono::steady_clock Clock;
+    auto elapsedMs = [](Clock::time_point start) {
+        return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    };
+    // 每个球 16 层 × 32 段 = 1024 个三角形
+    const int stacks = 16, slices = 32;
+    const float pi = 3.14159265f;
+    const size_t sphereTriangles = 2 * stacks * slices;
+    size_t sphereCount = std::max<size_t>(1, triangleCount / sphereTriangles);
+    std::mt19937 rng(2020);
+    float extent = 10.0f * std::cbrt((float)sphereCount);
+    std::uniform_real_distribution<float> position(-extent, extent), radius(0.5f, 2.0f), unit(-1.0f, 1.0f);
+    std::vector<glm::vec3> sphere;
+    for (int i = 0; i < stacks; ++i) {
+        for (int j = 0; j < slices; ++j) {
+            glm::vec3 p[4];
+            for (int k = 0; k < 4; ++k) {
+                float theta = pi * (i + (k >> 1)) / stacks;
+                float phi = 2.0f * pi * (j + (k & 1)) / slices;
+                p[k] = glm::vec3(std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi));
+            }
+            sphere.push_back(p[0]); sphere.push_back(p[2]); sphere.push_back(p[1]);
+            sphere.push_back(p[1]); sphere.push_back(p[2]); sphere.push_back(p[3]);
+        }
+    }
+    std::vector<glm::vec3> triangles;
+    triangles.reserve(sphereCount * sphere.size());
+    for (size_t s = 0; s < sphereCount; ++s) {
+        glm::vec3 center(position(rng), position(rng), position(rng));
+        float r = radius(rng);
+        for (unsigned int i = 0; i < sphere.size(); ++i)
+            triangles.push_back(center + sphere[i] * r);
+    }
+    size_t count = triangles.size() / 3;
+    std::vector<AABB> boxes(count);
+    auto updateBoxes = [&]() {
+        for (size_t i = 0; i < count; ++i) {
+            AABB box;
+            box.expand(triangles[3 * i]);
+            box.expand(triangles[3 * i + 1]);
+            box.expand(triangles[3 * i + 2]);
+            boxes[i] = box;
+        }
+    };
+    updateBoxes();
+    
+    // 构建
+    BVH bvh;
+    Clock::time_point start = Clock::now();
+    bvh.build(boxes);
+    double buildMs = elapsedMs(start);
+    float buildCost = bvh.cost();
+    
+    // 重新拟合：一半的球体平移
+    for (size_t s = 0; s < sphereCount; s += 2) {
+        glm::vec3 offset(unit(rng), unit(rng), unit(rng));
+        for (size_t i = s * sphere.size(); i < (s + 1) * sphere.size(); ++i)
+            triangles[i] = triangles[i] + offset;
+    }
+    updateBoxes();
+    start = Clock::now();
+    bvh.refit(boxes);
+    double refitMs = elapsedMs(start);
+    float refitCost = bvh.cost();
+    
+    // 视锥体查询：场景中心附近的相机看向随机方向（前几个查询同时逐个测试，检查结果一致）
+    glm::mat4 projection = glm::perspective(glm::radians(45.0f), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 100.0f);
+    auto randomView = [&]() {
+        glm::vec3 eye(unit(rng) * extent * 0.5f, unit(rng) * extent * 0.5f, unit(rng) * extent * 0.5f);
+        glm::vec3 front(unit(rng), unit(rng), unit(rng));
+        if (glm::length(front) < 0.01f)
+            front = glm::vec3(0.0f, 0.0f, -1.0f);
+        return std::make_pair(eye, glm::normalize(front));
+    };
+    const int frustumQueries = 200, bruteForceQueries = 10;
+    std::vector<Frustum> frustums;
+    for (int i = 0; i < frustumQueries; ++i) {
+        std::pair<glm::vec3, glm::vec3> v = randomView();
+        frustums.push_back(Frustum(projection, glm::lookAt(v.first, v.first + v.second, glm::vec3(0.0f, 1.0f, 0.0f))));
+    }
+    std::vector<unsigned int> visible;
+    visible.reserve(count);
+    size_t visibleSum = 0, checkedVisible = 0;
+    start = Clock::now();
+    for (int i = 0; i < frustumQueries; ++i) {
+        visible.clear();
+        size_t n = bvh.query(frustums[i], boxes, visible);
+        visibleSum += n;
+        if (i < bruteForceQueries)
+            checkedVisible += n;
+    }
+    double frustumMs = elapsedMs(start) / frustumQueries;
+    size_t bruteVisible = 0;
+    start = Clock::now();
+    for (int i = 0; i < bruteForceQueries; ++i)
+        for (size_t j = 0; j < count; ++j)
+            bruteVisible += frustums[i].intersects(boxes[j]) ? 1 : 0;
+    double bruteMs = elapsedMs(start) / bruteForceQueries;
+    
+    // 射线查询：随机相机位置和方向，三角形精确求交
+    const int rayQueries = 100000;
+    std::vector<Ray> rays;
+    rays.reserve(rayQueries);
+    for (int i = 0; i < rayQueries; ++i) {
+        std::pair<glm::vec3, glm::vec3> v = randomView();
+        rays.push_back(Ray(v.first, v.second));
+    }
+    size_t hits = 0;
+    start = Clock::now();
+    for (int i = 0; i < rayQueries; ++i) {
+        const Ray &ray = rays[i];
+        float distance = FLT_MAX;
+        int hit = bvh.intersect(ray, distance, [&](unsigned int index, float &tMax) {
+            float t;
+            if (!IntersectTriangle(ray, triangles[3 * index], triangles[3 * index + 1], triangles[3 * index + 2], tMax, t))
+                return false;
+            tMax = t;
+            return true;
+        });
+        hits += hit >= 0 ? 1 : 0;
+    }
+    double rayMs = elapsedMs(start);
     
-    return textureID;
+    std::cout << "triangles,nodes,build_ms,refit_ms,sah_cost,refit_sah_cost,"
+                 "frustum_query_ms,brute_force_ms,brute_force_match,avg_visible,rays_per_s,ray_hit_rate" << std::endl;
+    std::cout << count << "," << bvh.nodes.size() << "," << buildMs << "," << refitMs << ","
+              << buildCost << "," << refitCost << "," << frustumMs << "," << bruteMs << "," << (bruteVisible == checkedVisible) << ","
+              << visibleSum / frustumQueries << "," << rayQueries / (rayMs / 1000.0) << ","
+              << (double)hits / rayQueries << std::endl;
 }
@@ -12,6 +12,14 @@
  */
 
 #include <iostream>
+#include <string>
+#include <cstdlib>
+#include <cmath>
+#include <chrono>
+#include <memory>
+#include <vector>
+#include <random>
+#include <sys/resource.h>
 
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
@@ -24,12 +32,27 @@
 #include "seacenliu/camera.h"
 
 #include "model.h"
+#include "light_block.h"
+#include "transform_stage.h"
+#include "texture_compressor.h"
+#include "frame_histogram.h"
+#include "profiler.h"
+#include "headless.h"
+#include "camera_track.h"
+#include "frame_metrics.h"
+#include "bench_report.h"
+#define ALLOCATION_COUNTER_IMPLEMENTATION
+#include "allocation_counter.h"
 
 // 回调函数定义
 void framebuffer_size_callback(GLFWwindow* window, int width, int height);
 void mouse_callback(GLFWwindow* window, double xpos, double ypos);
 void scroll_callback(GLFWwindow* window, double xoffset, double yoffset);
+void mouse_button_callback(GLFWwindow* window, int button, int action, int mods);
 void processInput(GLFWwindow *window);
+size_t peakRSS();
+void benchmarkTransform(const std::vector<int> &counts);
+void benchmarkTextures(const std::string &directory, unsigned int repeat);
 
 // 配置
 const unsigned int SCR_WIDTH = 800;
@@ -41,97 +64,574 @@ float lastX = SCR_WIDTH / 2.0f;
 float lastY = SCR_HEIGHT / 2.0f;
 bool firstMouse = true;
 
+// 拾取（点击鼠标左键时在渲染循环中用光标位置发出射线）
+bool pickRequested = false;
+double pickX = 0.0, pickY = 0.0;
+
 // 计时
 float deltaTime = 0.0f;
 float lastFrame = 0.0f;
 
 int main(int argc, const char * argv[]) {
-    // --------------- 初始化 GLFW ---------------
-    glfwInit();
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
-    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
-#ifdef __APPLE__
-    glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
-#endif
+    // 参数 --texture-budget MB：纹理缓存的显存预算
+    // 参数 --bench-load [path]：冷加载（删除网格缓存）、热加载模型（默认 nanosuit）各 --bench-repeat 次，
+    //                         输出加载耗时的百分位数和进程内存峰值后退出
+    // 参数 --bench-texture [dir]：用 TextureFromFile 逐个解码、上传目录（默认模型所在目录）下的图片 --bench-repeat 次后退出
+    // 参数 --bench-transform [N,N...]：CPU 变换阶段（TransformStage）处理 N 个物体的耗时（默认 1000,10000,100000）后退出
+    // 参数 --bench-repeat N：加载、纹理基准测试的重复次数（默认 3）
+    // 参数 --bench-out FILE：基准测试结果同时追加到 CSV 文件（格式见 bench_report.h）
+    // 参数 --keep-cpu：上传后保留 CPU 端的顶点和索引数据（用于对比内存占用；鼠标拾取精确到三角形）
+    // 参数 --vertex-format full|compact：显存中的顶点格式（默认 compact）
+    // 参数 --occlusion：开启遮挡剔除（包围盒遮挡查询 + 条件渲染，只用于第一个模型）
+    // 参数 --crowd N：按网格排列绘制 N 个模型（每个模型分别选择 LOD）
+    // 参数 --lod-error PX：LOD 选择的屏幕空间误差阈值（像素，0 表示始终使用原始网格）
+    // 参数 --convert-textures [dir]：把目录（默认模型所在目录）下的图片离线压缩为 KTX，输出显存和加载耗时对比后退出
+    // 参数 --no-ktx：不使用压缩纹理，总是用 stb_image 解码（用于对比）
+    // 参数 --stream：纹理通过 PBO 上传环在之后的帧中逐步上传（先上传最小的 mipmap），不在加载时一次性上传
+    // 参数 --stream-budget KB：流式加载每帧的上传预算
+    // 参数 --load-after SECONDS：渲染循环开始若干秒后再加载模型，输出加载期间的帧时间直方图
+    // 参数 --profile：分区计时（CPU + GPU 计时查询），每秒输出各区域的 min / avg / p99
+    // 参数 --trace FILE：分区计时并记录每次进入区域的事件，退出时导出 Chrome trace JSON
+    // 参数 --record FILE：录制每帧的相机状态，退出时写入相机轨迹
+    // 参数 --replay FILE：回放相机轨迹（固定步长，不处理输入），轨迹结束时退出
+    // 参数 --csv FILE：记录每帧的 CPU / GPU 耗时、绘制调用和三角形数量，退出时写入 CSV
+    // 参数 --baseline FILE：与之前保存的 CSV 比较，有回退时返回值为 1
+    // 参数 --regression PCT：回退阈值（百分比，默认 10）
+    std::string modelPath = "resources/objects/nanosuit/nanosuit.obj";
+    std::string convertDirectory, tracePath;
+    std::string recordPath, replayPath, csvPath, baselinePath;
+    double regressionThreshold = FRAME_METRICS_REGRESSION;
+    bool benchTexture = false;
+    std::string benchTextureDirectory;
+    std::vector<int> benchTransformCounts;
+    unsigned int benchRepeat = 3;
+    BenchReport::instance().parseArguments(argc, argv);
+    bool benchLoad = false, keepCPUData = false, occlusionCulling = false, convertTextures = false;
+    bool streamTextures = false, profiling = false;
+    size_t streamBudget = TEXTURE_STREAM_FRAME_BUDGET;
+    float loadAfter = 0.0f;
+    unsigned int crowdSize = 1;
+    float lodPixelError = MODEL_LOD_PIXEL_ERROR;
+    VertexFormat vertexFormat = VERTEX_FORMAT_COMPACT;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--texture-budget" && i + 1 < argc)
+            TextureCache::instance().setBudget((size_t)atoi(argv[++i]) * 1024 * 1024);
+        else if (arg == "--bench-load") {
+            benchLoad = true;
+            if (i + 1 < argc && argv[i + 1][0] != '-')
+                modelPath = argv[++i];
+        } else if (arg == "--bench-texture") {
+            benchTexture = true;
+            if (i + 1 < argc && argv[i + 1][0] != '-')
+                benchTextureDirectory = argv[++i];
+        } else if (arg == "--bench-transform") {
+            benchTransformCounts = { 1000, 10000, 100000 };
+            if (i + 1 < argc && argv[i + 1][0] != '-')
+                benchTransformCounts = BenchReport::ParseList(argv[++i]);
+        } else if (arg == "--bench-repeat" && i + 1 < argc)
+            benchRepeat = (unsigned int)std::max(1, atoi(argv[++i]));
+        else if (arg == "--keep-cpu")
+            keepCPUData = true;
+        else if (arg == "--vertex-format" && i + 1 < argc)
+            vertexFormat = std::string(argv[++i]) == "full" ? VERTEX_FORMAT_FULL : VERTEX_FORMAT_COMPACT;
+        else if (arg == "--occlusion")
+            occlusionCulling = true;
+        else if (arg == "--crowd" && i + 1 < argc)
+            crowdSize = (unsigned int)std::max(1, atoi(argv[++i]));
+        else if (arg == "--lod-error" && i + 1 < argc)
+            lodPixelError = (float)atof(argv[++i]);
+        else if (arg == "--convert-textures") {
+            convertTextures = true;
+            if (i + 1 < argc && argv[i + 1][0] != '-')
+                convertDirectory = argv[++i];
+        } else if (arg == "--no-ktx")
+            TextureLoader::useCompressed() = false;
+        else if (arg == "--stream")
+            streamTextures = true;
+        else if (arg == "--stream-budget" && i + 1 < argc)
+            streamBudget = (size_t)std::max(1, atoi(argv[++i])) * 1024;
+        else if (arg == "--load-after" && i + 1 < argc)
+            loadAfter = (float)atof(argv[++i]);
+        else if (arg == "--profile")
+            profiling = true;
+        else if (arg == "--trace" && i + 1 < argc) {
+            profiling = true;
+            tracePath = argv[++i];
+        } else if (arg == "--record" && i + 1 < argc)
+            recordPath = argv[++i];
+        else if (arg == "--replay" && i + 1 < argc)
+            replayPath = argv[++i];
+        else if (arg == "--csv" && i + 1 < argc)
+            csvPath = argv[++i];
+        else if (arg == "--baseline" && i + 1 < argc)
+            baselinePath = argv[++i];
+        else if (arg == "--regression" && i + 1 < argc)
+            regressionThreshold = atof(argv[++i]) / 100.0;
+    }
     
-    // --------------- 创建窗口 ---------------
-    GLFWwindow *window = glfwCreateWindow(SCR_WIDTH,
-                                          SCR_HEIGHT,
-                                          "Learn OpenGL",
-                                          NULL,
-                                          NULL);
-    if (window == NULL) {
-        std::cout << "创建窗口失败" << std::endl;
-        glfwTerminate();
-        return -1;
+    // CPU 变换基准测试（不需要 OpenGL 上下文）
+    if (!benchTransformCounts.empty()) {
+        benchmarkTransform(benchTransformCounts);
+        if (!benchLoad && !benchTexture)
+            return 0;
     }
-    // 配置上下文环境
-    glfwMakeContextCurrent(window);
-    // 配置帧缓存大小变化回调
-    glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
-    // 配置鼠标事件回调
-    glfwSetCursorPosCallback(window, mouse_callback);
-    // 配置滚轮事件回调
-    glfwSetScrollCallback(window, scroll_callback);
-    // 隐藏鼠标光标展示
-    glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
-    
-    // --------------- 初始化 GLAD ---------------
-    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
-        std::cout << "初始化 GLAD 拓展失败" << std::endl;
+    
+    // 相机轨迹：回放时离屏模式渲染的帧数等于轨迹长度
+    CameraTrack track;
+    bool replaying = !replayPath.empty();
+    if (replaying && !track.load(replayPath)) {
+        std::cout << "读取相机轨迹失败: " << replayPath << std::endl;
         return -1;
     }
     
+    // --------------- 离屏模式 ---------------
+    // 参数 --headless [宽x高] / --frames N / --dump FILE：不创建窗口，渲染到 FBO 中，渲染满 N 帧后退出
+    Headless &headless = Headless::instance();
+    headless.parseArguments(argc, argv);
+    if (replaying)
+        headless.setFrameCount((unsigned int)track.frameCount());
+    GLFWwindow *window = NULL;
+    if (headless.enabled()) {
+        if (!headless.initialize()) {
+            std::cout << "创建离屏渲染上下文失败" << std::endl;
+            return -1;
+        }
+        // 脚本相机：从初始位置开始绕原点环绕
+        headless.cameraPath().setOrbit(glm::vec3(0.0f, 0.0f, 0.0f), camera.Position);
+    } else {
+        // --------------- 初始化 GLFW ---------------
+        glfwInit();
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+        glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+#ifdef __APPLE__
+        glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+#endif
+        
+        // --------------- 创建窗口 ---------------
+        window = glfwCreateWindow(SCR_WIDTH,
+                                  SCR_HEIGHT,
+                                  "Learn OpenGL",
+                                  NULL,
+                                  NULL);
+        if (window == NULL) {
+            std::cout << "创建窗口失败" << std::endl;
+            glfwTerminate();
+            return -1;
+        }
+        // 配置上下文环境
+        glfwMakeContextCurrent(window);
+        // 配置帧缓存大小变化回调
+        glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+        // 配置鼠标事件回调
+        glfwSetCursorPosCallback(window, mouse_callback);
+        // 配置滚轮事件回调
+        glfwSetScrollCallback(window, scroll_callback);
+        // 配置鼠标按键回调（拾取）
+        glfwSetMouseButtonCallback(window, mouse_button_callback);
+        // 隐藏鼠标光标展示
+        glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+        
+        // --------------- 初始化 GLAD ---------------
+        if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
+            std::cout << "初始化 GLAD 拓展失败" << std::endl;
+            return -1;
+        }
+    }
+    
     // --------------- 配置 OpenGL 全局状态 ---------------
     // 打开深度测试功能
-    glEnable(GL_DEPTH_TEST);
+    GLState::instance().enable(GL_DEPTH_TEST);
+    
+    // --------------- 离线压缩纹理 ---------------
+    if (convertTextures) {
+        if (convertDirectory.empty())
+            convertDirectory = modelPath.substr(0, modelPath.find_last_of('/'));
+        ConvertTextureDirectory(convertDirectory);
+        headless.release();
+        glfwTerminate();
+        return 0;
+    }
+    
+    // --------------- 纹理基准测试 ---------------
+    if (benchTexture) {
+        if (benchTextureDirectory.empty())
+            benchTextureDirectory = modelPath.substr(0, modelPath.find_last_of('/'));
+        benchmarkTextures(benchTextureDirectory, benchRepeat);
+        if (!benchLoad) {
+            headless.release();
+            glfwTerminate();
+            return 0;
+        }
+    }
     
     // --------------- 加载着色器程序 ---------------
     Shader ourShader("model_loading.vs", "model_loading.fs");
+    ourShader.use();
+    ourShader.setFloat("material.shininess", 32.0f);
+    
+    // --------------- 配置光源 ---------------
+    // 与光照场景共用同一套 LightBlock 布局
+    LightBlock lightBlock;
+    lightBlock.bind(ourShader);
+    lightBlock.data.dirLight.direction = glm::vec3(-0.2f, -1.0f, -0.3f);
+    lightBlock.data.dirLight.ambient   = glm::vec3(0.2f, 0.2f, 0.2f);
+    lightBlock.data.dirLight.diffuse   = glm::vec3(0.5f, 0.5f, 0.5f);
+    lightBlock.data.dirLight.specular  = glm::vec3(0.5f, 0.5f, 0.5f);
+    glm::vec3 pointLightPositions[] = {
+        glm::vec3( 1.5f,  0.5f,  1.5f),
+        glm::vec3(-1.5f,  0.5f,  1.5f)
+    };
+    for (unsigned int i = 0; i < 2; ++i) {
+        PointLightStd140 light;
+        light.position  = pointLightPositions[i];
+        light.ambient   = glm::vec3(0.05f, 0.05f, 0.05f);
+        light.diffuse   = glm::vec3(0.8f, 0.8f, 0.8f);
+        light.specular  = glm::vec3(1.0f, 1.0f, 1.0f);
+        light.constant  = 1.0f;
+        light.linear    = 0.09f;
+        light.quadratic = 0.032f;
+        lightBlock.addPointLight(light);
+    }
+    lightBlock.data.spotLight.diffuse     = glm::vec3(1.0f, 1.0f, 1.0f);
+    lightBlock.data.spotLight.specular    = glm::vec3(1.0f, 1.0f, 1.0f);
+    lightBlock.data.spotLight.constant    = 1.0f;
+    lightBlock.data.spotLight.linear      = 0.09f;
+    lightBlock.data.spotLight.quadratic   = 0.032f;
+    lightBlock.data.spotLight.cutOff      = glm::cos(glm::radians(12.5f));
+    lightBlock.data.spotLight.outerCutOff = glm::cos(glm::radians(15.0f));
+    
+    // --------------- 纹理流式加载 ---------------
+    // 加载基准测试只统计模型本身，不使用流式加载
+    std::unique_ptr<TextureStreamer> streamer;
+    if (streamTextures && !benchLoad)
+        streamer.reset(new TextureStreamer(streamBudget));
     
     // --------------- 加载模型文件 ---------------
-    Model ourModel((char*)"resources/objects/nanosuit/nanosuit.obj");
-//    Model ourModel((char*)"resources/objects/Model/Model.obj");
+    // 指定 --load-after 时在渲染循环中加载（加载期间照常渲染，记录帧时间）
+    std::unique_ptr<Model> ourModel;
+    size_t baselineRSS = peakRSS();
+    double loadMs = 0.0;
+    auto loadModel = [&]() {
+        std::chrono::steady_clock::time_point loadStart = std::chrono::steady_clock::now();
+        ourModel.reset(new Model(modelPath.c_str(), keepCPUData, vertexFormat, streamer.get()));
+//        ourModel.reset(new Model("resources/objects/Model/Model.obj"));
+        loadMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - loadStart).count();
+        // 输出网格优化效果（ACMR/ATVR）、LOD 链和纹理解码、上传耗时（流式加载的纹理在完成后输出）
+        if (!ourModel->loadedFromCache)
+            ourModel->optimizeStats.print();
+        ourModel->lodChainStats().print();
+        if (!streamer) {
+            ourModel->textureLoader.printStats();
+            TextureCache::instance().printStats();
+        }
+        std::cout << "模型加载: " << loadMs << " ms" << std::endl;
+        // 网格共用一个 VAO，材质相同的网格合并绘制（合并前每个网格各一次绘制调用和 VAO 绑定）
+        std::cout << "绘制调用: " << ourModel->meshCount() << " 个网格合并为每帧 " << ourModel->drawCallCount()
+                  << " 次绘制调用、1 次 VAO 绑定（合并前各 " << ourModel->meshCount() << " 次）" << std::endl;
+        // 顶点格式：显存数据量（即每次绘制读取的顶点/索引带宽）和量化误差
+        ourModel->vertexReport().print();
+    };
+    if (!benchLoad && loadAfter <= 0.0f)
+        loadModel();
+    
+    // --------------- 加载基准测试 ---------------
+    // 冷加载先删除网格缓存（Assimp 导入、网格优化、生成 LOD，并重新写入缓存），紧接着的热加载直接读取缓存；
+    // 每次加载前释放上一个模型并清空纹理缓存，纹理每次都重新解码上传（系统的文件缓存不清除）
+    if (benchLoad) {
+        std::vector<double> coldMs, warmMs;
+        for (unsigned int run = 0; run < 2 * benchRepeat; ++run) {
+            if (ourModel) {
+                ourModel->release();
+                ourModel.reset();
+                TextureCache::instance().clear();
+            }
+            bool cold = run % 2 == 0;
+            if (cold)
+                std::remove((modelPath + ".meshbin").c_str());
+            loadModel();
+            (cold ? coldMs : warmMs).push_back(loadMs);
+        }
+        std::string params = "model=" + modelPath + ";meshes=" + std::to_string(ourModel->meshCount());
+        BenchReport::instance().add("model.load_cold", params, coldMs, 1.0, "loads/s");
+        BenchReport::instance().add("model.load_warm", params, warmMs, 1.0, "loads/s");
+        std::cout << "model,from_cache,meshes,load_ms,baseline_rss_kb,peak_rss_kb,cpu_mesh_kb,gpu_mesh_kb" << std::endl;
+        std::cout << modelPath << "," << ourModel->loadedFromCache << "," << ourModel->meshCount() << ","
+                  << loadMs << "," << baselineRSS / 1024 << "," << peakRSS() / 1024 << ","
+                  << ourModel->cpuBytes() / 1024 << "," << ourModel->vertexReport().bytes() / 1024 << std::endl;
+        headless.release();
+        glfwTerminate();
+        return 0;
+    }
+    
+    // 变换阶段（模型矩阵、法线矩阵、MVP 矩阵在 CPU 上计算）
+    // 多个模型时按正方形网格向 -z 方向排列（第一排在原来的位置，左右居中）
+    TransformStage transforms;
+    std::vector<unsigned int> modelObjects;
+    unsigned int crowdColumns = (unsigned int)std::ceil(std::sqrt((double)crowdSize));
+    for (unsigned int i = 0; i < crowdSize; ++i) {
+        float column = (float)(i % crowdColumns) - (float)((crowdColumns - 1) / 2);
+        float row = (float)(i / crowdColumns);
+        glm::mat4 model = glm::mat4(1.0f);
+        model = glm::translate(model, glm::vec3(column * 3.0f, -1.75f, -row * 3.0f));
+        model = glm::scale(model, glm::vec3(0.2f, 0.2f, 0.2f));
+        modelObjects.push_back(transforms.add(model));
+    }
+    
+    // 状态切换统计（每秒输出一次每帧平均值）
+    float statsTime = 0.0f;
+    unsigned int statsFrames = 0;
+    GLStateStats stateSum = { 0, 0 };
+    unsigned long drawAllocations = 0;
+    CullStats cullSum = { 0, 0 };
+    OcclusionStats occlusionSum = { 0, 0 };
+    LodDrawStats lodSum;
+    
+    // 遮挡剔除（需要 OpenGL 上下文，只在开启时创建）
+    std::unique_ptr<OcclusionCuller> occlusion;
+    if (occlusionCulling)
+        occlusion.reset(new OcclusionCuller());
+    
+    // 帧时间直方图（全程，以及从开始加载到纹理全部上传完成）
+    FrameTimeHistogram frameTimes, loadFrameTimes;
+    bool loading = streamer && ourModel;
+    unsigned long frameIndex = 0;
+    
+    // 分区计时：每帧的各个阶段，绘制阶段同时测量 GPU 耗时（Model::Draw 内部另有 CPU 区域）
+    Profiler &profiler = Profiler::instance();
+    const unsigned int zoneStream   = profiler.zone("纹理流式上传");
+    const unsigned int zoneInput    = profiler.zone("输入");
+    const unsigned int zoneClear    = profiler.zone("清屏");
+    const unsigned int zoneUniforms = profiler.zone("uniform 上传");
+    const unsigned int zoneObject   = profiler.zone("物体绘制");
+    const unsigned int zonePick     = profiler.zone("拾取");
+    profiler.setEnabled(profiling);
+    if (!tracePath.empty())
+        profiler.startTrace();
+    
+    // LOD 按输出图像的高度计算屏幕空间误差
+    const float viewportHeight = headless.enabled() ? (float)headless.height() : (float)SCR_HEIGHT;
+    
+    // 逐帧基准数据（指定 --csv 或 --baseline 时记录）
+    FrameMetricsLog metrics;
+    bool measuring = !csvPath.empty() || !baselinePath.empty();
+    size_t trackFrame = 0;
     
     // --------------- 渲染循环 ---------------
-    while (!glfwWindowShouldClose(window)) {
-        // 时间逻辑
-        float currentFrame = glfwGetTime();
+    while (headless.running(window) && (!replaying || trackFrame < track.frameCount())) {
+        // 时间逻辑（回放时按轨迹的固定步长推进）
+        float currentFrame = replaying ? track.time(trackFrame) : headless.time();
         deltaTime = currentFrame - lastFrame;
         lastFrame = currentFrame;
+        profiler.beginFrame();
+        if (measuring)
+            metrics.beginFrame();
+        unsigned long frameDrawCalls = 0, frameTriangles = 0;
+        
+        // 帧时间（第一帧包含初始化，不记录）；加载帧的耗时体现在下一帧的 deltaTime 中
+        // 离屏模式下 deltaTime 是固定步长，改用上一帧的实际耗时
+        double frameMs = headless.enabled() ? headless.lastFrameMilliseconds() : deltaTime * 1000.0;
+        if (frameIndex++ > 0) {
+            frameTimes.add(frameMs);
+            if (loading)
+                loadFrameTimes.add(frameMs);
+        }
+        if (loading && loadFrameTimes.count() > 0 && (!streamer || streamer->idle())) {
+            loading = false;
+            if (streamer) {
+                streamer->printStats();
+                TextureCache::instance().printStats();
+            }
+            loadFrameTimes.print("加载期间帧时间");
+        }
+        // 延迟加载模型
+        if (!ourModel && currentFrame >= loadAfter) {
+            loadModel();
+            loading = true;
+        }
+        // 流式加载：在预算内上传纹理数据
+        if (streamer) {
+            ProfileScope scope(zoneStream, true);
+            streamer->update();
+        }
 
         // 处理窗口输入
-        processInput(window);
+        {
+            ProfileScope scope(zoneInput);
+            if (replaying)
+                track.apply(camera, trackFrame++);
+            else if (headless.enabled())
+                headless.cameraPath().apply(camera, currentFrame);
+            else
+                processInput(window);
+            if (!recordPath.empty())
+                track.record(camera);
+        }
 
         // 渲染
-        glClearColor(0.05f, 0.05f, 0.05f, 1.0f);
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
-        // 配置着色器程序属性
-        ourShader.use();
-        glm::mat4 projection = glm::perspective(glm::radians(camera.Zoom),
-                                                (float)SCR_WIDTH / (float)SCR_HEIGHT,
-                                                0.1f,
-                                                100.0f);
-        glm::mat4 view = camera.GetViewMatrix();
-        ourShader.setMat4("projection", projection);
-        ourShader.setMat4("view", view);
-        glm::mat4 model = glm::mat4(1.0f);
-        model = glm::translate(model, glm::vec3(0.0f, -1.75f, 0.0f));
-        model = glm::scale(model, glm::vec3(0.2f, 0.2f, 0.2f));
-        ourShader.setMat4("model", model);
+        {
+            ProfileScope scope(zoneClear, true);
+            glClearColor(0.05f, 0.05f, 0.05f, 1.0f);
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        }
+
+        {
+            ProfileScope scope(zoneUniforms, true);
+            // 配置着色器程序属性
+            ourShader.use();
+            glm::mat4 projection = glm::perspective(glm::radians(camera.Zoom),
+                                                    headless.aspect((float)SCR_WIDTH / (float)SCR_HEIGHT),
+                                                    0.1f,
+                                                    100.0f);
+            glm::mat4 view = camera.GetViewMatrix();
+            // 模型矩阵不变，法线矩阵只算一次，MVP 每帧计算一次
+            transforms.update(view, projection);
+            ourShader.setVec3("viewPos", camera.Position);
+            
+            // 更新光源（聚光跟随相机）
+            lightBlock.data.spotLight.position  = camera.Position;
+            lightBlock.data.spotLight.direction = camera.Front;
+            lightBlock.upload();
+        }
+        
+        // 模型渲染：按相机距离选择每个网格的 LOD，用 MVP 得到物体空间的视锥体，剔除看不到的网格
+        // （统计绘制过程中的堆内存分配次数）
+        unsigned long allocationsBefore = AllocationCount();
+        for (unsigned int i = 0; ourModel && i < modelObjects.size(); ++i) {
+            ProfileScope scope(zoneObject, true);
+            unsigned int object = modelObjects[i];
+            transforms.apply(ourShader, object);
+            ourModel->selectLod(transforms.model(object), camera.Position, camera.Zoom, viewportHeight, lodPixelError);
+            if (occlusion && i == 0) {
+                ourModel->Draw(ourShader, transforms.mvp(object), *occlusion);
+                OcclusionStats occlusionFrame = occlusion->frameStats();
+                occlusionSum.queries += occlusionFrame.queries;
+                occlusionSum.occluded += occlusionFrame.occluded;
+            } else {
+                ourModel->Draw(ourShader, Frustum(transforms.mvp(object)));
+            }
+            CullStats cull = ourModel->lastCullStats();
+            cullSum.visible += cull.visible;
+            cullSum.culled += cull.culled;
+            lodSum.add(ourModel->lastLodStats());
+            frameDrawCalls += ourModel->lastDrawCalls();
+            frameTriangles += ourModel->lastLodStats().triangles;
+        }
+        drawAllocations += AllocationCount() - allocationsBefore;
+        
+        // 拾取：用每个模型的 MVP 生成物体空间射线，在网格 BVH 中查找最近的命中网格
+        // （射线参数对应同一条屏幕射线上的位置，可以直接在模型之间比较）
+        if (pickRequested && ourModel) {
+            ProfileScope scope(zonePick);
+            pickRequested = false;
+            std::chrono::steady_clock::time_point pickStart = std::chrono::steady_clock::now();
+            float nearest = FLT_MAX;
+            int picked = -1, pickedObject = -1;
+            // 光标位置是窗口坐标，按当前的窗口大小换算（离屏时为渲染大小）
+            int width = (int)headless.width(), height = (int)headless.height();
+            if (!headless.enabled())
+                glfwGetWindowSize(window, &width, &height);
+            for (unsigned int i = 0; i < modelObjects.size(); ++i) {
+                float distance;
+                Ray ray = ScreenRay(pickX, pickY, width, height, transforms.mvp(modelObjects[i]));
+                int mesh = ourModel->pick(ray, distance);
+                if (mesh >= 0 && distance < nearest) {
+                    nearest = distance;
+                    picked = mesh;
+                    pickedObject = (int)i;
+                }
+            }
+            double pickMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - pickStart).count();
+            if (picked >= 0)
+                std::cout << "拾取: 模型 " << pickedObject << " 的网格 " << picked << ", 射线参数 " << nearest
+                          << " (" << pickMs << " ms)" << std::endl;
+            else
+                std::cout << "拾取: 没有命中 (" << pickMs << " ms)" << std::endl;
+        }
         
-        // 模型渲染
-        ourModel.Draw(ourShader);
+        // 统计状态切换
+        GLStateStats state = GLState::frameStats();
+        stateSum.callsIssued += state.callsIssued;
+        stateSum.callsElided += state.callsElided;
+        ++statsFrames;
+        statsTime += deltaTime;
+        if (statsTime >= 1.0f) {
+            std::cout << "状态切换每帧: 调用 " << stateSum.callsIssued / statsFrames
+                      << " 次, 跳过冗余调用 " << stateSum.callsElided / statsFrames << " 次, 绘制中堆内存分配 "
+                      << drawAllocations << " 次" << std::endl;
+            std::cout << "视锥体剔除每帧: 可见 " << cullSum.visible / statsFrames << " 个网格, 剔除 "
+                      << cullSum.culled / statsFrames << " 个" << std::endl;
+            if (occlusion)
+                std::cout << "遮挡剔除每帧: 包围盒查询 " << occlusionSum.queries / statsFrames << " 次, 被遮挡 "
+                          << occlusionSum.occluded / statsFrames << " 个网格（条件渲染）" << std::endl;
+            std::cout << "LOD 每帧: 三角形 " << lodSum.triangles / statsFrames << " 个（全部使用原始网格 "
+                      << lodSum.fullTriangles / statsFrames << " 个），各级网格数";
+            for (int level = 0; level < MESH_MAX_LODS; ++level)
+                std::cout << (level ? " / " : " ") << lodSum.meshes[level] / statsFrames;
+            std::cout << std::endl;
+            if (profiling)
+                profiler.printSummary();
+            stateSum = GLStateStats{ 0, 0 };
+            lodSum = LodDrawStats();
+            cullSum = CullStats{ 0, 0 };
+            occlusionSum = OcclusionStats{ 0, 0 };
+            drawAllocations = 0;
+            statsFrames = 0;
+            statsTime = 0.0f;
+        }
+        profiler.endFrame();
+        if (measuring)
+            metrics.endFrame(frameDrawCalls, frameTriangles);
 
         // 交换缓冲
-        glfwSwapBuffers(window);
-        // 获取输入事件
-        glfwPollEvents();
+        if (headless.enabled()) {
+            headless.present();
+        } else {
+            glfwSwapBuffers(window);
+            // 获取输入事件
+            glfwPollEvents();
+        }
+    }
+    
+    // --------------- 释放资源 ---------------
+    if (ourModel)
+        ourModel->release();
+    if (streamer)
+        streamer->release();
+    frameTimes.print("帧时间");
+    if (!tracePath.empty()) {
+        if (profiler.writeTrace(tracePath))
+            std::cout << "分区计时: " << profiler.traceEventCount() << " 个事件写入 " << tracePath << std::endl;
+        else
+            std::cout << "WARNING::PROFILER::failed to write " << tracePath << std::endl;
+    }
+    profiler.release();
+    if (!recordPath.empty()) {
+        if (track.save(recordPath))
+            std::cout << "相机轨迹: " << track.frameCount() << " 帧写入 " << recordPath << std::endl;
+        else
+            std::cout << "WARNING::CAMERA_TRACK::failed to write " << recordPath << std::endl;
     }
+    bool regressed = false;
+    if (measuring) {
+        metrics.finish();
+        if (!csvPath.empty()) {
+            if (metrics.writeCSV(csvPath))
+                std::cout << "逐帧数据: " << metrics.frames().size() << " 帧写入 " << csvPath << std::endl;
+            else
+                std::cout << "WARNING::FRAME_METRICS::failed to write " << csvPath << std::endl;
+        }
+        if (!baselinePath.empty())
+            regressed = metrics.compare(baselinePath, regressionThreshold);
+        metrics.release();
+    }
+    if (occlusion)
+        occlusion->release();
+    headless.release();
+    glfwTerminate();
     
-    return 0;
+    return regressed ? 1 : 0;
 }
 
 // 处理用户键盘操作
@@ -149,6 +649,102 @@ void processInput(GLFWwindow *window) {
         camera.ProcessKeyboard(RIGHT, deltaTime);
 }
 
+// CPU 变换基准测试：count 个物体（固定种子随机分布）每帧执行一次 TransformStage::update，样本为一帧的耗时。
+// transform.static 只有相机移动（每帧只算 MVP），transform.dynamic 每帧修改全部物体的模型矩阵（同时重新计算法线矩阵）
+void benchmarkTransform(const std::vector<int> &counts) {
+    typedef std::chrono::steady_clock Clock;
+    const int warmupFrames = 10, measureFrames = 200;
+    glm::mat4 projection = glm::perspective(glm::radians(45.0f), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 100.0f);
+    volatile float sink = 0.0f;
+    for (int count : counts) {
+        // 两组模型矩阵交替使用（dynamic 场景中每帧的模型矩阵都不同）
+        std::mt19937 rng(2020);
+        std::uniform_real_distribution<float> position(-50.0f, 50.0f), angle(0.0f, 360.0f), scale(0.5f, 2.0f);
+        std::vector<glm::mat4> models[2];
+        for (int k = 0; k < 2; ++k) {
+            models[k].reserve(count);
+            for (int i = 0; i < count; ++i) {
+                glm::mat4 model = glm::translate(glm::mat4(1.0f), glm::vec3(position(rng), position(rng), position(rng)));
+                model = glm::rotate(model, glm::radians(angle(rng)), glm::vec3(1.0f, 0.3f, 0.5f));
+                models[k].push_back(glm::scale(model, glm::vec3(scale(rng))));
+            }
+        }
+        const char *names[] = { "transform.static", "transform.dynamic" };
+        for (int dynamic = 0; dynamic < 2; ++dynamic) {
+            TransformStage stage;
+            for (int i = 0; i < count; ++i)
+                stage.add(models[0][i]);
+            std::vector<double> samples;
+            for (int frame = 0; frame < warmupFrames + measureFrames; ++frame) {
+                float t = frame * 0.05f;
+                glm::mat4 view = glm::lookAt(glm::vec3(std::sin(t) * 80.0f, 10.0f, std::cos(t) * 80.0f),
+                                             glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+                Clock::time_point start = Clock::now();
+                if (dynamic) {
+                    const std::vector<glm::mat4> &current = models[frame & 1];
+                    for (int i = 0; i < count; ++i)
+                        stage.setModel(i, current[i]);
+                }
+                stage.update(view, projection);
+                double ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+                sink = sink + stage.mvp(frame % count)[3][3] + stage.normalMatrix(frame % count)[0][0];
+                if (frame >= warmupFrames)
+                    samples.push_back(ms);
+            }
+            BenchReport::instance().add(names[dynamic], "objects=" + std::to_string(count), samples,
+                                        (double)count, "objects/s");
+        }
+    }
+}
+
+// 纹理基准测试：目录下的每个图片用 TextureFromFile 解码、上传 repeat 次（glFinish 等待上传完成后删除纹理），
+// 样本为单个纹理的耗时，吞吐量按解码后的图像数据量（MB）计算。
+// texture.stb 总是用 stb_image 解码；有离线压缩的 KTX（--convert-textures）时另外测试 texture.ktx
+// （只包括有 KTX 的图片，吞吐量同样按原图的数据量计算，可以直接和 stb 路径比较）
+void benchmarkTextures(const std::string &directory, unsigned int repeat) {
+    typedef std::chrono::steady_clock Clock;
+    std::vector<std::string> files = ListTextureFiles(directory);
+    bool useCompressed = TextureLoader::useCompressed();
+    const char *names[] = { "texture.stb", "texture.ktx" };
+    for (int compressed = 0; compressed < 2; ++compressed) {
+        TextureLoader::useCompressed() = compressed != 0;
+        std::vector<double> samples;
+        double megabytes = 0.0;
+        unsigned int textures = 0;
+        for (unsigned int i = 0; i < files.size(); ++i) {
+            std::string path = directory + '/' + files[i];
+            int width, height, nrComponents;
+            if ((compressed && !KtxUpToDate(path)) || !stbi_info(path.c_str(), &width, &height, &nrComponents))
+                continue;
+            ++textures;
+            for (unsigned int r = 0; r < repeat; ++r) {
+                Clock::time_point start = Clock::now();
+                GLuint texture = TextureFromFile(files[i].c_str(), directory);
+                glFinish();
+                samples.push_back(std::chrono::duration<double, std::milli>(Clock::now() - start).count());
+                megabytes += (double)width * height * nrComponents / (1024.0 * 1024.0);
+                GLState::instance().deleteTextures(1, &texture);
+            }
+        }
+        if (!samples.empty())
+            BenchReport::instance().add(names[compressed], "dir=" + directory + ";textures=" + std::to_string(textures)
+                                        + ";repeat=" + std::to_string(repeat), samples,
+                                        megabytes / samples.size(), "MB/s");
+    }
+    TextureLoader::useCompressed() = useCompressed;
+}
+
+// 进程的内存占用峰值（字节）
+size_t peakRSS() {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+    return (size_t)usage.ru_maxrss;         // macOS 单位为字节
+#else
+    return (size_t)usage.ru_maxrss * 1024;  // Linux 单位为 KB
+#endif
+}
+
 // 处理窗口变化事件（系统或用户所为）
 void framebuffer_size_callback(GLFWwindow* window, int width, int height) {
     glViewport(0, 0, width, height);
@@ -171,6 +767,23 @@ void mouse_callback(GLFWwindow* window, double xpos, double ypos) {
     camera.ProcessMouseMovement(xoffset, yoffset);
 }
 
+// 处理鼠标按键事件：左键拾取。光标被隐藏时相机跟随鼠标转动，拾取屏幕中心（准星），
+// 否则拾取 mouse_callback 记录的光标位置
+void mouse_button_callback(GLFWwindow* window, int button, int action, int mods) {
+    if (button != GLFW_MOUSE_BUTTON_LEFT || action != GLFW_PRESS)
+        return;
+    if (glfwGetInputMode(window, GLFW_CURSOR) == GLFW_CURSOR_DISABLED) {
+        int width, height;
+        glfwGetWindowSize(window, &width, &height);
+        pickX = width / 2.0;
+        pickY = height / 2.0;
+    } else {
+        pickX = lastX;
+        pickY = lastY;
+    }
+    pickRequested = true;
+}
+
 // 处理鼠标滚轮事件
 void scroll_callback(GLFWwindow* window, double xoffset, double yoffset) {
     camera.ProcessMouseScroll(yoffset);
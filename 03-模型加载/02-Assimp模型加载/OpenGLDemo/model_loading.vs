@@ -1,16 +1,41 @@
 #version 330 core
-layout (location = 0) in vec3 aPos;       // 位置坐标
-layout (location = 1) in vec3 aNormal;    // 法向量
-layout (location = 2) in vec2 aTexCoords; // 纹理坐标
+layout (location = 0) in vec4 aPos;       // 位置坐标（紧凑格式下为量化后的 16 位整数）
+layout (location = 1) in vec3 aNormal;    // 法向量（完整格式）
+layout (location = 2) in vec2 aTexCoords; // 纹理坐标（紧凑格式下为半精度浮点数）
+layout (location = 3) in vec2 aNormalOct; // 八面体编码的法向量（紧凑格式，16 位整数）
 
-out vec2 TexCoords;
+out vec3 FragPos;   // 渲染位置
+out vec3 Normal;    // 法向量
+out vec2 TexCoords; // 纹理坐标
 
+// 以下矩阵由 CPU 端变换阶段（transform_stage.h）每个物体计算一次
 uniform mat4 model;                       // 模型矩阵
-uniform mat4 view;                        // 视图矩阵
-uniform mat4 projection;                  // 投影矩阵
+uniform mat3 normalMatrix;                // 法线矩阵
+uniform mat4 mvp;                         // 模型-观察-投影矩阵
+
+// 顶点格式（vertex_format.h），完整格式时 positionScale 为 1、positionOffset 为 0
+uniform bool compactVertex;
+uniform vec3 positionScale;               // 量化位置的缩放
+uniform vec3 positionOffset;              // 量化位置的偏移（包围盒中心）
+
+// 八面体解码（输入范围 [-1, 1]）
+vec3 OctDecode(vec2 e)
+{
+    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    if (n.z < 0.0)
+        n.xy = (1.0 - abs(n.yx)) * vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
+    return normalize(n);
+}
 
 void main()
 {
+    // 反量化（完整格式时保持原值）
+    vec3 position = aPos.xyz * positionScale + positionOffset;
+    vec3 normal = compactVertex ? OctDecode(aNormalOct / 32767.0) : aNormal;
+    // 世界空间中的顶点位置
+    FragPos = vec3(model * vec4(position, 1.0));
+    // 用模型矩阵左上角的逆矩阵的转置矩阵移除对法向量错误缩放(不等比缩放)的影响
+    Normal = normalMatrix * normal;
     TexCoords = aTexCoords;
-    gl_Position = projection * view * model * vec4(aPos, 1.0);
+    gl_Position = mvp * vec4(position, 1.0);
 }
@@ -0,0 +1,8 @@
+#version 330 core
+out vec4 FragColor;
+
+// 只用于遮挡查询，颜色写入已关闭
+void main()
+{
+    FragColor = vec4(1.0);
+}
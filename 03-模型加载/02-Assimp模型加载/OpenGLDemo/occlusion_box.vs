@@ -0,0 +1,12 @@
+#version 330 core
+layout (location = 0) in vec3 aPos;       // 单位立方体的顶点 [0, 1]^3
+
+// 遮挡查询的包围盒（occlusion_culler.h）
+uniform mat4 mvp;
+uniform vec3 boxMin;
+uniform vec3 boxMax;
+
+void main()
+{
+    gl_Position = mvp * vec4(mix(boxMin, boxMax, aPos), 1.0);
+}
@@ -0,0 +1,68 @@
+//
+//  allocation_counter.h
+//  OpenGLDemo
+//
+//  Created by SeacenLiu on 2020/2/13.
+//  Copyright © 2020 SeacenLiu. All rights reserved.
+//
+
+/**
+ * 堆内存分配计数
+ *
+ * 替换全局 operator new / operator delete，统计进程中 operator new 的调用次数，
+ * 用来确认渲染循环中没有堆内存分配。
+ * 与 stb_image 一样，在且只在一个源文件中包含前定义 ALLOCATION_COUNTER_IMPLEMENTATION。
+ */
+#ifndef allocation_counter_h
+#define allocation_counter_h
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+// 进程启动以来 operator new 的调用次数
+inline std::atomic<unsigned long> &AllocationCount() {
+    static std::atomic<unsigned long> count(0);
+    return count;
+}
+
+#ifdef ALLOCATION_COUNTER_IMPLEMENTATION
+// 单个对象、数组、nothrow 和带大小的 delete 都显式替换，全部经过同一个计数，
+// 不依赖标准库默认版本的转调（也避免 -Wsized-deallocation 的警告）
+void *operator new(std::size_t size) {
+    ++AllocationCount();
+    if (void *p = std::malloc(size ? size : 1))
+        return p;
+    throw std::bad_alloc();
+}
+void *operator new[](std::size_t size) {
+    return operator new(size);
+}
+void *operator new(std::size_t size, const std::nothrow_t &) noexcept {
+    ++AllocationCount();
+    return std::malloc(size ? size : 1);
+}
+void *operator new[](std::size_t size, const std::nothrow_t &tag) noexcept {
+    return operator new(size, tag);
+}
+void operator delete(void *p) noexcept {
+    std::free(p);
+}
+void operator delete[](void *p) noexcept {
+    std::free(p);
+}
+void operator delete(void *p, std::size_t) noexcept {
+    std::free(p);
+}
+void operator delete[](void *p, std::size_t) noexcept {
+    std::free(p);
+}
+void operator delete(void *p, const std::nothrow_t &) noexcept {
+    std::free(p);
+}
+void operator delete[](void *p, const std::nothrow_t &) noexcept {
+    std::free(p);
+}
+#endif
+
+#endif /* allocation_counter_h */
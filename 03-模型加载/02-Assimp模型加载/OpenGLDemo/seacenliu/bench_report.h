@@ -0,0 +1,108 @@
+//
+//  bench_report.h
+//  OpenGLDemo
+//
+//  Created by SeacenLiu on 2020/2/25.
+//  Copyright © 2020 SeacenLiu. All rights reserved.
+//
+
+/**
+ * 基准测试结果
+ *
+ * 各示例的基准测试场景（光照场景的盒子数 × 光源数、模型冷 / 热加载、纹理解码上传、CPU 变换）
+ * 统一输出成同样的 CSV，每个场景一行：
+ *     scenario,params,samples,mean_ms,p50_ms,p90_ms,p99_ms,max_ms,throughput,unit
+ * - 每个样本是一次操作的耗时（一帧、一次加载、一个纹理……），统计与帧时间直方图（frame_histogram.h）一致，
+ *   百分位数取最近的排名
+ * - params 为 key=value，用分号分隔（不含逗号）
+ * - throughput 为每个样本的工作量（帧、物体、MB……）除以平均耗时，unit 为它的单位
+ *
+ * 结果总是写到标准输出；参数 --bench-out FILE 时同时追加到文件（新文件先写表头），
+ * 不同示例的结果可以追加到同一个文件中（见仓库根目录的 benchmark.sh）。
+ */
+#ifndef bench_report_h
+#define bench_report_h
+
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+
+#include "frame_histogram.h"
+
+#define BENCH_REPORT_HEADER "scenario,params,samples,mean_ms,p50_ms,p90_ms,p99_ms,max_ms,throughput,unit"
+
+class BenchReport {
+public:
+    static BenchReport &instance() {
+        static BenchReport report;
+        return report;
+    }
+
+    // 解析参数 --bench-out FILE
+    void parseArguments(int argc, const char *argv[]) {
+        for (int i = 1; i + 1 < argc; ++i) {
+            if (std::string(argv[i]) == "--bench-out")
+                outputPath = argv[++i];
+        }
+    }
+
+    // 记录一个场景：samples 为每次操作的耗时（毫秒），work 为每次操作的工作量（单位为 unit 的分子）
+    void add(const std::string &scenario, const std::string &params, const std::vector<double> &samples,
+             double work, const char *unit) {
+        if (samples.empty())
+            return;
+        FrameTimeHistogram times;
+        for (unsigned int i = 0; i < samples.size(); ++i)
+            times.add(samples[i]);
+        double mean = times.average();
+        char row[512];
+        snprintf(row, sizeof(row), "%s,%s,%zu,%.4f,%.4f,%.4f,%.4f,%.4f,%.2f,%s", scenario.c_str(), params.c_str(),
+                 times.count(), mean, times.percentile(50.0), times.percentile(90.0),
+                 times.percentile(99.0), times.maximum(), mean > 0.0 ? work * 1000.0 / mean : 0.0, unit);
+        if (!headerPrinted) {
+            std::cout << BENCH_REPORT_HEADER << std::endl;
+            headerPrinted = true;
+        }
+        std::cout << row << std::endl;
+        if (outputPath.empty())
+            return;
+        FILE *file = fopen(outputPath.c_str(), "a");
+        if (!file) {
+            std::cout << "WARNING::BENCH_REPORT::failed to open " << outputPath << std::endl;
+            return;
+        }
+        fseek(file, 0, SEEK_END);
+        if (ftell(file) == 0)
+            fprintf(file, "%s\n", BENCH_REPORT_HEADER);
+        fprintf(file, "%s\n", row);
+        fclose(file);
+    }
+
+    // 解析逗号分隔的数量列表（例如 "10,1000,10000"），忽略不大于 0 的项
+    static std::vector<int> ParseList(const std::string &text) {
+        std::vector<int> values;
+        size_t start = 0;
+        while (start <= text.size()) {
+            size_t end = text.find(',', start);
+            if (end == std::string::npos)
+                end = text.size();
+            int value = atoi(text.substr(start, end - start).c_str());
+            if (value > 0)
+                values.push_back(value);
+            start = end + 1;
+        }
+        return values;
+    }
+
+private:
+    std::string outputPath;
+    bool headerPrinted;
+
+    BenchReport() : headerPrinted(false) {}
+    BenchReport(const BenchReport &) = delete;
+    BenchReport &operator=(const BenchReport &) = delete;
+};
+
+#endif /* bench_report_h */
@@ -0,0 +1,147 @@
+//
+//  camera_track.h
+//  OpenGLDemo
+//
+//  Created by SeacenLiu on 2020/2/24.
+//  Copyright © 2020 SeacenLiu. All rights reserved.
+//
+
+/**
+ * 相机轨迹录制与回放（.ctrk）
+ *
+ * 交互时 Camera::ProcessKeyboard / ProcessMouseMovement 的结果取决于实时输入和墙钟 deltaTime，
+ * 两次运行画出的帧不可能一样，性能数据也就没法比较。
+ * 录制时每帧记下输入作用之后的相机状态（位置、偏航角、俯仰角、视野），回放时逐帧直接设置，
+ * 不再经过输入和 deltaTime：同一条轨迹无论帧率多少、窗口还是离屏，画出的都是同一组帧。
+ * 回放按固定步长推进时间（帧号 × 轨迹的步长），依赖时间的逻辑（统计周期、延迟加载）也可以复现。
+ *
+ * 文件布局（小端，与写入机器的字节序一致）：
+ *   CameraTrackHeader
+ *   CameraTrackFrame[frameCount]   每帧 24 字节
+ */
+#ifndef camera_track_h
+#define camera_track_h
+
+#include <glm/glm.hpp>
+
+#include <cstdio>
+#include <cstring>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#define CAMERA_TRACK_MAGIC "CTRK"
+#define CAMERA_TRACK_VERSION 1
+// 录制时写入的步长（回放时每帧推进的时间，秒）
+#define CAMERA_TRACK_STEP (1.0f / 60.0f)
+
+struct CameraTrackHeader {
+    char magic[4];          // CAMERA_TRACK_MAGIC
+    uint32_t version;       // CAMERA_TRACK_VERSION
+    uint32_t frameCount;
+    float step;             // 每帧的时间步长（秒）
+};
+
+// 一帧的相机状态
+struct CameraTrackFrame {
+    float position[3];
+    float yaw;
+    float pitch;
+    float zoom;
+};
+
+class CameraTrack {
+public:
+    CameraTrack() : timeStep(CAMERA_TRACK_STEP) {}
+
+    // 录制一帧（在处理完输入之后调用）
+    template <typename CameraType>
+    void record(const CameraType &camera) {
+        CameraTrackFrame frame;
+        for (int k = 0; k < 3; ++k)
+            frame.position[k] = camera.Position[k];
+        frame.yaw = camera.Yaw;
+        frame.pitch = camera.Pitch;
+        frame.zoom = camera.Zoom;
+        frames.push_back(frame);
+    }
+    // 把第 index 帧的状态设置到相机上（重新计算 Front、Right、Up）
+    template <typename CameraType>
+    void apply(CameraType &camera, size_t index) const {
+        const CameraTrackFrame &frame = frames[index];
+        camera.Position = glm::vec3(frame.position[0], frame.position[1], frame.position[2]);
+        camera.Yaw = frame.yaw;
+        camera.Pitch = frame.pitch;
+        camera.Zoom = frame.zoom;
+        camera.ProcessMouseMovement(0.0f, 0.0f);
+    }
+
+    size_t frameCount() const {
+        return frames.size();
+    }
+    float step() const {
+        return timeStep;
+    }
+    // 第 index 帧的时间（秒）
+    float time(size_t index) const {
+        return index * timeStep;
+    }
+
+    // 写入轨迹文件（先写临时文件再改名，失败时不留下不完整的文件）
+    bool save(const std::string &path) const {
+        CameraTrackHeader header;
+        memcpy(header.magic, CAMERA_TRACK_MAGIC, sizeof(header.magic));
+        header.version = CAMERA_TRACK_VERSION;
+        header.frameCount = (uint32_t)frames.size();
+        header.step = timeStep;
+        std::string tempPath = path + ".tmp";
+        FILE *file = fopen(tempPath.c_str(), "wb");
+        if (!file)
+            return false;
+        bool ok = fwrite(&header, sizeof(header), 1, file) == 1;
+        if (!frames.empty())
+            ok = ok && fwrite(&frames[0], sizeof(CameraTrackFrame), frames.size(), file) == frames.size();
+        ok = (fclose(file) == 0) && ok;
+        if (!ok || rename(tempPath.c_str(), path.c_str()) != 0) {
+            remove(tempPath.c_str());
+            return false;
+        }
+        return true;
+    }
+    // 读取轨迹文件（格式、版本不对或文件大小与帧数不符时返回 false）
+    bool load(const std::string &path) {
+        frames.clear();
+        FILE *file = fopen(path.c_str(), "rb");
+        if (!file)
+            return false;
+        CameraTrackHeader header;
+        bool ok = fread(&header, sizeof(header), 1, file) == 1
+               && memcmp(header.magic, CAMERA_TRACK_MAGIC, sizeof(header.magic)) == 0
+               && header.version == CAMERA_TRACK_VERSION
+               && header.frameCount > 0 && header.step > 0.0f;
+        // 帧数必须与文件剩下的大小一致（截断或损坏的头不会按它去分配内存）
+        if (ok) {
+            long start = ftell(file);
+            ok = start >= 0 && fseek(file, 0, SEEK_END) == 0;
+            long end = ok ? ftell(file) : -1;
+            ok = ok && end >= start
+                 && (uint64_t)(end - start) == (uint64_t)header.frameCount * sizeof(CameraTrackFrame)
+                 && fseek(file, start, SEEK_SET) == 0;
+        }
+        if (ok) {
+            frames.resize(header.frameCount);
+            ok = fread(&frames[0], sizeof(CameraTrackFrame), frames.size(), file) == frames.size();
+            timeStep = header.step;
+        }
+        fclose(file);
+        if (!ok)
+            frames.clear();
+        return ok;
+    }
+
+private:
+    std::vector<CameraTrackFrame> frames;
+    float timeStep;
+};
+
+#endif /* camera_track_h */
@@ -0,0 +1,209 @@
+//
+//  frame_metrics.h
+//  OpenGLDemo
+//
+//  Created by SeacenLiu on 2020/2/24.
+//  Copyright © 2020 SeacenLiu. All rights reserved.
+//
+
+/**
+ * 逐帧基准数据（CSV）与基线比较
+ *
+ * 每帧记录 CPU 耗时、GPU 耗时、绘制调用次数和三角形数量，写成 CSV：
+ *     frame,cpu_ms,gpu_ms,draw_calls,triangles
+ * - CPU 耗时为 beginFrame 到 endFrame 之间的 steady_clock 时间（不含交换缓冲）
+ * - GPU 耗时为帧开始和结束时两个 GL_TIMESTAMP 查询（glQueryCounter）的差，
+ *   不占用 GL_TIME_ELAPSED，可以和分区计时（profiler.h）同时使用。
+ *   查询按帧轮换 FRAME_METRICS_LATENCY 组，复用一组之前才读取它的结果（这时早已就绪，基本不会等待），
+ *   finish 时读取剩下的结果
+ *
+ * compare 读取之前保存的基线 CSV（同一条相机轨迹回放得到），比较 CPU / GPU 的平均值和 p99，
+ * 超过基线 threshold 比例的记为回退；绘制调用和三角形数量不一致说明画的内容不同（或者剔除、LOD 有变化），
+ * 同样报告，增加超过 threshold 的也记为回退。第一帧包含初始化，不参与比较。
+ */
+#ifndef frame_metrics_h
+#define frame_metrics_h
+
+#include <glad/glad.h>
+
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <algorithm>
+
+#include "frame_histogram.h"
+
+// GPU 时间戳查询轮换的组数
+#define FRAME_METRICS_LATENCY 4
+// 默认的回退阈值（比基线慢 10%）
+#define FRAME_METRICS_REGRESSION 0.10
+
+struct FrameMetrics {
+    unsigned long frame;
+    double cpuMs;
+    double gpuMs;               // 没有结果时为 -1
+    unsigned long drawCalls;
+    unsigned long triangles;
+};
+
+// 一组帧数据的汇总（不含第一帧）
+struct FrameMetricsSummary {
+    size_t frames;
+    double cpuAverage, cpuP99;
+    double gpuAverage, gpuP99;
+    unsigned long long drawCalls, triangles;
+
+    static FrameMetricsSummary of(const std::vector<FrameMetrics> &rows) {
+        FrameTimeHistogram cpu, gpu;
+        FrameMetricsSummary summary = FrameMetricsSummary();
+        for (unsigned int i = 1; i < rows.size(); ++i) {
+            cpu.add(rows[i].cpuMs);
+            if (rows[i].gpuMs >= 0.0)
+                gpu.add(rows[i].gpuMs);
+            summary.drawCalls += rows[i].drawCalls;
+            summary.triangles += rows[i].triangles;
+        }
+        summary.frames = cpu.count();
+        summary.cpuAverage = cpu.average();
+        summary.cpuP99 = cpu.percentile(99.0);
+        summary.gpuAverage = gpu.average();
+        summary.gpuP99 = gpu.percentile(99.0);
+        return summary;
+    }
+};
+
+class FrameMetricsLog {
+public:
+    FrameMetricsLog() : pending(0) {
+        for (unsigned int i = 0; i < FRAME_METRICS_LATENCY; ++i)
+            queries[i][0] = queries[i][1] = 0;
+    }
+
+    // 开始一帧（需要 OpenGL 上下文，第一次调用时创建查询对象）
+    void beginFrame() {
+        if (queries[0][0] == 0)
+            glGenQueries(FRAME_METRICS_LATENCY * 2, &queries[0][0]);
+        unsigned int slot = rows.size() % FRAME_METRICS_LATENCY;
+        // 这一组查询还属于 FRAME_METRICS_LATENCY 帧之前的那一帧，先取回它的结果
+        if (pending == FRAME_METRICS_LATENCY)
+            resolve(rows.size() - FRAME_METRICS_LATENCY);
+        glQueryCounter(queries[slot][0], GL_TIMESTAMP);
+        cpuStart = std::chrono::steady_clock::now();
+    }
+    // 结束一帧（在交换缓冲之前调用），drawCalls / triangles 为这一帧提交的绘制调用和三角形
+    void endFrame(unsigned long drawCalls, unsigned long triangles) {
+        FrameMetrics row;
+        row.frame = (unsigned long)rows.size();
+        row.cpuMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - cpuStart).count();
+        row.gpuMs = -1.0;
+        row.drawCalls = drawCalls;
+        row.triangles = triangles;
+        glQueryCounter(queries[row.frame % FRAME_METRICS_LATENCY][1], GL_TIMESTAMP);
+        rows.push_back(row);
+        ++pending;
+    }
+    // 取回所有还没有读取的 GPU 结果（退出前调用）
+    void finish() {
+        while (pending > 0)
+            resolve(rows.size() - pending);
+    }
+
+    const std::vector<FrameMetrics> &frames() const {
+        return rows;
+    }
+
+    // 写入 CSV
+    bool writeCSV(const std::string &path) const {
+        FILE *file = fopen(path.c_str(), "w");
+        if (!file)
+            return false;
+        fprintf(file, "frame,cpu_ms,gpu_ms,draw_calls,triangles\n");
+        for (unsigned int i = 0; i < rows.size(); ++i)
+            fprintf(file, "%lu,%.4f,%.4f,%lu,%lu\n", rows[i].frame, rows[i].cpuMs, rows[i].gpuMs,
+                    rows[i].drawCalls, rows[i].triangles);
+        bool ok = !ferror(file);
+        return (fclose(file) == 0) && ok;
+    }
+    // 读取 writeCSV 写出的文件
+    static bool ReadCSV(const std::string &path, std::vector<FrameMetrics> &result) {
+        result.clear();
+        FILE *file = fopen(path.c_str(), "r");
+        if (!file)
+            return false;
+        char header[128];
+        bool ok = fgets(header, sizeof(header), file) != NULL
+               && std::string(header).compare(0, 5, "frame") == 0;
+        FrameMetrics row;
+        while (ok && fscanf(file, "%lu,%lf,%lf,%lu,%lu", &row.frame, &row.cpuMs, &row.gpuMs,
+                            &row.drawCalls, &row.triangles) == 5)
+            result.push_back(row);
+        fclose(file);
+        return ok && !result.empty();
+    }
+
+    // 与基线比较并输出结果，有回退时返回 true
+    bool compare(const std::string &baselinePath, double threshold = FRAME_METRICS_REGRESSION) const {
+        std::vector<FrameMetrics> baselineRows;
+        if (!ReadCSV(baselinePath, baselineRows)) {
+            std::cout << "WARNING::FRAME_METRICS::failed to read baseline " << baselinePath << std::endl;
+            return false;
+        }
+        FrameMetricsSummary current = FrameMetricsSummary::of(rows);
+        FrameMetricsSummary baseline = FrameMetricsSummary::of(baselineRows);
+        std::cout << "基线比较（" << baselinePath << "，阈值 " << threshold * 100.0 << "%）: 当前 "
+                  << current.frames << " 帧, 基线 " << baseline.frames << " 帧" << std::endl;
+        if (current.frames != baseline.frames)
+            std::cout << "  帧数不一致，可能不是同一条轨迹" << std::endl;
+        unsigned int regressions = 0;
+        regressions += CompareValue("CPU 平均", " ms", current.cpuAverage, baseline.cpuAverage, threshold);
+        regressions += CompareValue("CPU p99", " ms", current.cpuP99, baseline.cpuP99, threshold);
+        regressions += CompareValue("GPU 平均", " ms", current.gpuAverage, baseline.gpuAverage, threshold);
+        regressions += CompareValue("GPU p99", " ms", current.gpuP99, baseline.gpuP99, threshold);
+        regressions += CompareValue("绘制调用", "", (double)current.drawCalls, (double)baseline.drawCalls, threshold);
+        regressions += CompareValue("三角形", "", (double)current.triangles, (double)baseline.triangles, threshold);
+        if (current.drawCalls != baseline.drawCalls || current.triangles != baseline.triangles)
+            std::cout << "  绘制调用或三角形数量与基线不同：画的内容有变化（剔除、LOD 或场景），耗时不能直接比较" << std::endl;
+        std::cout << (regressions ? "  发现 " + std::to_string(regressions) + " 项回退" : std::string("  没有回退"))
+                  << std::endl;
+        return regressions > 0;
+    }
+
+    // 释放查询对象
+    void release() {
+        if (queries[0][0])
+            glDeleteQueries(FRAME_METRICS_LATENCY * 2, &queries[0][0]);
+        for (unsigned int i = 0; i < FRAME_METRICS_LATENCY; ++i)
+            queries[i][0] = queries[i][1] = 0;
+        pending = 0;
+    }
+
+private:
+    // 每组为一帧开始、结束时的时间戳查询
+    GLuint queries[FRAME_METRICS_LATENCY][2];
+    unsigned int pending;
+    std::vector<FrameMetrics> rows;
+    std::chrono::steady_clock::time_point cpuStart;
+
+    // 读取第 index 帧的 GPU 时间戳（必要时等待结果）
+    void resolve(size_t index) {
+        const GLuint *pair = queries[index % FRAME_METRICS_LATENCY];
+        GLuint64 start = 0, end = 0;
+        glGetQueryObjectui64v(pair[0], GL_QUERY_RESULT, &start);
+        glGetQueryObjectui64v(pair[1], GL_QUERY_RESULT, &end);
+        rows[index].gpuMs = end >= start ? (end - start) / 1000000.0 : -1.0;
+        --pending;
+    }
+    // 输出一项比较结果，超过阈值时返回 1
+    static unsigned int CompareValue(const char *name, const char *unit, double current, double baseline,
+                                     double threshold) {
+        double change = baseline > 0.0 ? current / baseline - 1.0 : 0.0;
+        bool regressed = baseline > 0.0 && change > threshold;
+        std::cout << "  " << name << ": " << current << unit << " (基线 " << baseline << unit << ", "
+                  << (change >= 0.0 ? "+" : "") << change * 100.0 << "%)" << (regressed ? " 回退" : "") << std::endl;
+        return regressed ? 1 : 0;
+    }
+};
+
+#endif /* frame_metrics_h */
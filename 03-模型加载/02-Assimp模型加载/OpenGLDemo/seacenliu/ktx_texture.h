@@ -0,0 +1,261 @@
+//
+//  ktx_texture.h
+//  OpenGLDemo
+//
+//  Created by SeacenLiu on 2020/2/20.
+//  Copyright © 2020 SeacenLiu. All rights reserved.
+//
+
+/**
+ * KTX（1.1）压缩纹理容器
+ *
+ * 离线转换工具（texture_compressor.h）把 PNG/JPG 编码为 BCn 块压缩格式，
+ * 连同预先生成的整条 mipmap 链写入 "<图片路径>.ktx"。运行时直接读取压缩块，
+ * 用 glCompressedTexImage2D 逐级上传，不需要解码图片，也不需要 glGenerateMipmap。
+ *
+ * 支持的格式：
+ * - BC1（DXT1）：RGB，每 4x4 块 8 字节（GL_EXT_texture_compression_s3tc）
+ * - BC3（DXT5）：RGBA，每块 16 字节（GL_EXT_texture_compression_s3tc）
+ * - BC4（RGTC1）：单通道，每块 8 字节（OpenGL 3.0 核心）
+ * - BC5（RGTC2）：双通道（法线贴图的 x、y），每块 16 字节（OpenGL 3.0 核心）
+ *
+ * S3TC 不属于核心规范，但桌面平台（包括 macOS）都支持；不支持时调用者回退到 stb_image 路径。
+ */
+#ifndef ktx_texture_h
+#define ktx_texture_h
+
+#include <glad/glad.h>
+
+#include <cstdio>
+#include <cstring>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+#include <sys/stat.h>
+
+#include "gl_state.h"
+
+// 扩展格式（glad 只生成了核心规范时没有这些定义）
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT  0x83F0
+#endif
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+
+// 压缩纹理后缀（"<图片路径>.ktx"）
+#define KTX_EXTENSION ".ktx"
+
+// KTX 1.1 文件头（标识符之后的 13 个 uint32）
+struct KtxHeader {
+    uint8_t  identifier[12];
+    uint32_t endianness;
+    uint32_t glType;
+    uint32_t glTypeSize;
+    uint32_t glFormat;
+    uint32_t glInternalFormat;
+    uint32_t glBaseInternalFormat;
+    uint32_t pixelWidth;
+    uint32_t pixelHeight;
+    uint32_t pixelDepth;
+    uint32_t numberOfArrayElements;
+    uint32_t numberOfFaces;
+    uint32_t numberOfMipmapLevels;
+    uint32_t bytesOfKeyValueData;
+};
+
+static_assert(sizeof(KtxHeader) == 64, "KtxHeader size mismatch");
+
+static const uint8_t KTX_IDENTIFIER[12] = { 0xAB, 'K', 'T', 'X', ' ', '1', '1', 0xBB, '\r', '\n', 0x1A, '\n' };
+
+// 每个 4x4 块的字节数（不是支持的压缩格式时返回 0）
+inline size_t KtxBlockBytes(GLenum internalFormat) {
+    switch (internalFormat) {
+        case GL_COMPRESSED_RGB_S3TC_DXT1_EXT:
+        case GL_COMPRESSED_RED_RGTC1:
+            return 8;
+        case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT:
+        case GL_COMPRESSED_RG_RGTC2:
+            return 16;
+        default:
+            return 0;
+    }
+}
+
+// 压缩格式对应的基本格式（写入文件头）
+inline GLenum KtxBaseFormat(GLenum internalFormat) {
+    switch (internalFormat) {
+        case GL_COMPRESSED_RGB_S3TC_DXT1_EXT:  return GL_RGB;
+        case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT: return GL_RGBA;
+        case GL_COMPRESSED_RED_RGTC1:          return GL_RED;
+        default:                               return GL_RG;
+    }
+}
+
+// 格式名（用于输出统计）
+inline const char *KtxFormatName(GLenum internalFormat) {
+    switch (internalFormat) {
+        case GL_COMPRESSED_RGB_S3TC_DXT1_EXT:  return "BC1";
+        case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT: return "BC3";
+        case GL_COMPRESSED_RED_RGTC1:          return "BC4";
+        case GL_COMPRESSED_RG_RGTC2:           return "BC5";
+        default:                               return "?";
+    }
+}
+
+// 一级 mipmap 的数据量
+inline size_t KtxLevelBytes(GLenum internalFormat, int width, int height) {
+    return (size_t)((width + 3) / 4) * (size_t)((height + 3) / 4) * KtxBlockBytes(internalFormat);
+}
+
+// 压缩纹理（所有 mipmap 层级的数据连续存放）
+struct KtxTexture {
+    GLenum internalFormat;
+    int width, height;
+    std::vector<unsigned char> data;
+    std::vector<size_t> levelOffsets;
+
+    KtxTexture() : internalFormat(0), width(0), height(0) {}
+    unsigned int levelCount() const {
+        return (unsigned int)levelOffsets.size();
+    }
+    int levelWidth(unsigned int level) const {
+        return std::max(1, width >> level);
+    }
+    int levelHeight(unsigned int level) const {
+        return std::max(1, height >> level);
+    }
+    size_t levelBytes(unsigned int level) const {
+        return KtxLevelBytes(internalFormat, levelWidth(level), levelHeight(level));
+    }
+    // 追加一级（数据量必须与格式和尺寸一致）
+    void addLevel(const unsigned char *levelData, size_t bytes) {
+        levelOffsets.push_back(data.size());
+        data.insert(data.end(), levelData, levelData + bytes);
+    }
+    // 显存占用（字节）
+    size_t bytes() const {
+        return data.size();
+    }
+};
+
+// 写入 KTX 文件（先写临时文件再改名）
+inline bool WriteKtx(const std::string &path, const KtxTexture &texture) {
+    KtxHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.identifier, KTX_IDENTIFIER, sizeof(KTX_IDENTIFIER));
+    header.endianness = 0x04030201;
+    header.glTypeSize = 1;
+    header.glInternalFormat = texture.internalFormat;
+    header.glBaseInternalFormat = KtxBaseFormat(texture.internalFormat);
+    header.pixelWidth = (uint32_t)texture.width;
+    header.pixelHeight = (uint32_t)texture.height;
+    header.numberOfFaces = 1;
+    header.numberOfMipmapLevels = texture.levelCount();
+    std::string tempPath = path + ".tmp";
+    FILE *file = fopen(tempPath.c_str(), "wb");
+    if (!file)
+        return false;
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1;
+    // 块压缩数据的大小总是 8 的倍数，不需要按 4 字节补齐
+    for (unsigned int level = 0; ok && level < texture.levelCount(); ++level) {
+        uint32_t imageSize = (uint32_t)texture.levelBytes(level);
+        ok = fwrite(&imageSize, sizeof(imageSize), 1, file) == 1
+          && fwrite(&texture.data[texture.levelOffsets[level]], 1, imageSize, file) == imageSize;
+    }
+    ok = (fclose(file) == 0) && ok;
+    if (!ok || rename(tempPath.c_str(), path.c_str()) != 0) {
+        remove(tempPath.c_str());
+        return false;
+    }
+    return true;
+}
+
+// 读取 KTX 文件（不是支持的格式或文件损坏时返回 false）
+inline bool ReadKtx(const std::string &path, KtxTexture &texture) {
+    FILE *file = fopen(path.c_str(), "rb");
+    if (!file)
+        return false;
+    KtxHeader header;
+    bool ok = fread(&header, sizeof(header), 1, file) == 1
+           && memcmp(header.identifier, KTX_IDENTIFIER, sizeof(KTX_IDENTIFIER)) == 0
+           && header.endianness == 0x04030201
+           && KtxBlockBytes(header.glInternalFormat) != 0
+           && header.pixelWidth > 0 && header.pixelHeight > 0 && header.pixelDepth == 0
+           && header.numberOfArrayElements == 0 && header.numberOfFaces == 1
+           && header.numberOfMipmapLevels <= 32
+           && fseek(file, header.bytesOfKeyValueData, SEEK_CUR) == 0;
+    texture = KtxTexture();
+    if (ok) {
+        texture.internalFormat = header.glInternalFormat;
+        texture.width = (int)header.pixelWidth;
+        texture.height = (int)header.pixelHeight;
+        unsigned int levels = std::max(1u, header.numberOfMipmapLevels);
+        size_t total = 0;
+        for (unsigned int i = 0; i < levels; ++i)
+            total += texture.levelBytes(i);
+        texture.data.resize(total);
+        // 直接读入最终的缓冲区，不经过临时拷贝
+        for (unsigned int i = 0; ok && i < levels; ++i) {
+            uint32_t imageSize = 0;
+            size_t offset = texture.levelOffsets.empty() ? 0 : texture.levelOffsets.back() + texture.levelBytes(i - 1);
+            ok = fread(&imageSize, sizeof(imageSize), 1, file) == 1 && imageSize == texture.levelBytes(i)
+              && fread(&texture.data[offset], 1, imageSize, file) == imageSize;
+            if (ok)
+                texture.levelOffsets.push_back(offset);
+        }
+    }
+    fclose(file);
+    return ok;
+}
+
+// 图片对应的压缩纹理路径
+inline std::string KtxPath(const std::string &imagePath) {
+    return imagePath + KTX_EXTENSION;
+}
+
+// 压缩纹理文件是否存在并且不比源图片旧（图片修改后需要重新转换）
+inline bool KtxUpToDate(const std::string &imagePath) {
+    struct stat ktx, image;
+    if (stat(KtxPath(imagePath).c_str(), &ktx) != 0)
+        return false;
+    return stat(imagePath.c_str(), &image) != 0 || ktx.st_mtime >= image.st_mtime;
+}
+
+// 当前上下文是否支持 S3TC（BC1/BC3）；RGTC（BC4/BC5）属于核心规范
+inline bool KtxSupported(GLenum internalFormat) {
+    if (internalFormat == GL_COMPRESSED_RED_RGTC1 || internalFormat == GL_COMPRESSED_RG_RGTC2)
+        return true;
+    static int s3tc = -1;
+    if (s3tc < 0) {
+        s3tc = 0;
+        GLint count = 0;
+        glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+        for (GLint i = 0; i < count && !s3tc; ++i) {
+            const char *name = (const char *)glGetStringi(GL_EXTENSIONS, (GLuint)i);
+            s3tc = name && strcmp(name, "GL_EXT_texture_compression_s3tc") == 0;
+        }
+    }
+    return s3tc != 0;
+}
+
+// 上传所有 mipmap 层级（环绕和过滤方式与 UploadTexture 一致）
+inline void UploadKtxTexture(unsigned int textureID, const KtxTexture &texture) {
+    GLState::instance().bindTexture(GL_TEXTURE_2D, textureID);
+    for (unsigned int level = 0; level < texture.levelCount(); ++level) {
+        glCompressedTexImage2D(GL_TEXTURE_2D, (GLint)level, texture.internalFormat,
+                               texture.levelWidth(level), texture.levelHeight(level), 0,
+                               (GLsizei)texture.levelBytes(level), &texture.data[texture.levelOffsets[level]]);
+    }
+    // 文件中的 mipmap 链可能不完整，只采样实际存在的层级
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, (GLint)texture.levelCount() - 1);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER,
+                    texture.levelCount() > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+}
+
+#endif /* ktx_texture_h */
@@ -0,0 +1,121 @@
+//
+//  light_block.h
+//  OpenGLDemo
+//
+//  Created by SeacenLiu on 2020/2/3.
+//  Copyright © 2020 SeacenLiu. All rights reserved.
+//
+
+/**
+ * 光源 Uniform 缓冲对象（UBO）
+ * https://learnopengl-cn.github.io/04%20Advanced%20OpenGL/08%20Advanced%20GLSL/#uniform
+ *
+ * 着色器中以 std140 布局声明 LightBlock，所有需要光照的着色器程序共享同一个绑定点，
+ * 每帧只需一次 glBufferSubData 就能上传全部光源，不再逐个字段调用 glUniform*。
+ *
+ * std140 中 vec3 按 16 字节对齐，这里把标量塞进 vec3 后面的 4 字节空隙，
+ * 让 C++ 结构体（glm::vec3 + float）与 GLSL 结构体的内存布局完全一致。
+ */
+#ifndef light_block_h
+#define light_block_h
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <cstddef>
+
+#include "shader.h"
+
+// 最大点光源数量（需与着色器中的 MAX_POINT_LIGHTS 保持一致，UBO 最小保证 16KB）
+#define MAX_POINT_LIGHTS 128
+// LightBlock 使用的 uniform 缓冲绑定点
+#define LIGHT_BLOCK_BINDING 0
+
+// 定向光
+struct DirLightStd140 {
+    glm::vec3 direction; float padding0;
+    glm::vec3 ambient;   float padding1;
+    glm::vec3 diffuse;   float padding2;
+    glm::vec3 specular;  float padding3;
+};
+
+// 点光源
+struct PointLightStd140 {
+    glm::vec3 position;  float constant;
+    glm::vec3 ambient;   float linear;
+    glm::vec3 diffuse;   float quadratic;
+    glm::vec3 specular;  float radius;    // 影响半径（分簇剔除使用，0 表示根据衰减计算）
+};
+
+// 聚光
+struct SpotLightStd140 {
+    glm::vec3 position;  float cutOff;
+    glm::vec3 direction; float outerCutOff;
+    glm::vec3 ambient;   float constant;
+    glm::vec3 diffuse;   float linear;
+    glm::vec3 specular;  float quadratic;
+};
+
+// 与着色器中 LightBlock 一一对应的 CPU 端镜像
+struct LightBlockData {
+    DirLightStd140   dirLight;
+    SpotLightStd140  spotLight;
+    int              pointLightCount;
+    int              padding[3];
+    PointLightStd140 pointLights[MAX_POINT_LIGHTS];
+};
+
+// 布局检查（std140 偏移量）
+static_assert(sizeof(glm::vec3) == 12, "glm::vec3 must be tightly packed");
+static_assert(sizeof(DirLightStd140) == 64, "DirLight std140 size mismatch");
+static_assert(sizeof(PointLightStd140) == 64, "PointLight std140 size mismatch");
+static_assert(sizeof(SpotLightStd140) == 80, "SpotLight std140 size mismatch");
+static_assert(offsetof(PointLightStd140, constant) == 12, "PointLight.constant offset mismatch");
+static_assert(offsetof(SpotLightStd140, outerCutOff) == 28, "SpotLight.outerCutOff offset mismatch");
+static_assert(offsetof(LightBlockData, spotLight) == 64, "LightBlock.spotLight offset mismatch");
+static_assert(offsetof(LightBlockData, pointLightCount) == 144, "LightBlock.pointLightCount offset mismatch");
+static_assert(offsetof(LightBlockData, pointLights) == 160, "LightBlock.pointLights offset mismatch");
+
+class LightBlock {
+public:
+    // UBO 的 ID
+    unsigned int UBO;
+    // CPU 端数据（修改后调用 upload 提交）
+    LightBlockData data;
+
+    // 构造函数（需要在 OpenGL 上下文创建之后调用）
+    LightBlock() {
+        data = LightBlockData();
+        glGenBuffers(1, &UBO);
+        GLState::instance().bindBuffer(GL_UNIFORM_BUFFER, UBO);
+        glBufferData(GL_UNIFORM_BUFFER, sizeof(LightBlockData), NULL, GL_DYNAMIC_DRAW);
+        GLState::instance().bindBuffer(GL_UNIFORM_BUFFER, 0);
+        GLState::instance().bindBufferBase(GL_UNIFORM_BUFFER, LIGHT_BLOCK_BINDING, UBO);
+    }
+    // 将着色器程序中的 LightBlock 关联到共享绑定点（没有声明 LightBlock 的程序会被忽略）
+    void bind(const Shader &shader) const {
+        unsigned int index = glGetUniformBlockIndex(shader.ID, "LightBlock");
+        if (index != GL_INVALID_INDEX)
+            glUniformBlockBinding(shader.ID, index, LIGHT_BLOCK_BINDING);
+    }
+    // 清空点光源
+    void clearPointLights() {
+        data.pointLightCount = 0;
+    }
+    // 添加点光源，返回其下标（超出上限返回 -1）
+    int addPointLight(const PointLightStd140 &light) {
+        if (data.pointLightCount >= MAX_POINT_LIGHTS)
+            return -1;
+        data.pointLights[data.pointLightCount] = light;
+        return data.pointLightCount++;
+    }
+    // 上传：一次 glBufferSubData，只提交实际使用的点光源部分
+    void upload() const {
+        GLsizeiptr size = offsetof(LightBlockData, pointLights)
+                        + data.pointLightCount * sizeof(PointLightStd140);
+        GLState::instance().bindBuffer(GL_UNIFORM_BUFFER, UBO);
+        glBufferSubData(GL_UNIFORM_BUFFER, 0, size, &data);
+    }
+};
+
+#endif /* light_block_h */
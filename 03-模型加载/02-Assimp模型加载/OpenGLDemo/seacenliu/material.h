@@ -0,0 +1,83 @@
+//
+//  material.h
+//  OpenGLDemo
+//
+//  Created by SeacenLiu on 2020/2/13.
+//  Copyright © 2020 SeacenLiu. All rights reserved.
+//
+
+/**
+ * 材质：预先编译好的采样器绑定
+ *
+ * 网格的每个纹理在加载时就确定采样器名字（material.texture_diffuseN 等）和纹理单元（第 i 个纹理用单元 i），
+ * 第一次绑定到某个着色器程序时查出所有采样器的 uniform 句柄，之后每次绘制只需遍历固定大小的数组：
+ * - 纹理绑定经过 GLState，与上一个网格相同时不调用 OpenGL
+ * - 采样器的纹理单元通过 uniform 句柄设置，值没变化时 Shader 会跳过上传
+ * 绘制过程中没有任何字符串拼接和堆内存分配。
+ */
+#ifndef material_h
+#define material_h
+
+#include <glad/glad.h>
+
+#include <string>
+
+#include "shader.h"
+#include "gl_state.h"
+
+// 每个材质最多的纹理数量
+#define MATERIAL_MAX_TEXTURES 8
+
+class Material {
+public:
+    Material() : textureCount(0), program(0) {}
+
+    // 添加纹理（加载时调用），返回分配的纹理单元；超过上限时返回 -1
+    int add(const std::string &sampler, GLuint texture) {
+        if (textureCount >= MATERIAL_MAX_TEXTURES)
+            return -1;
+        samplers[textureCount] = sampler;
+        textures[textureCount] = texture;
+        handles[textureCount] = UniformHandle{ -1 };
+        program = 0;    // 需要重新解析采样器
+        return (int)textureCount++;
+    }
+    unsigned int size() const {
+        return textureCount;
+    }
+    // 两个材质的纹理和采样器完全相同（可以合并绘制）
+    bool sameBindings(const Material &other) const {
+        if (textureCount != other.textureCount)
+            return false;
+        for (unsigned int i = 0; i < textureCount; ++i) {
+            if (textures[i] != other.textures[i] || samplers[i] != other.samplers[i])
+                return false;
+        }
+        return true;
+    }
+    // 绑定到着色器：换了着色器程序时才重新解析采样器位置，之后只遍历数组
+    void bind(const Shader &shader) {
+        if (shader.ID != program)
+            resolve(shader);
+        GLState &state = GLState::instance();
+        for (unsigned int i = 0; i < textureCount; ++i) {
+            shader.setInt(handles[i], (int)i);
+            state.bindTexture(i, GL_TEXTURE_2D, textures[i]);
+        }
+    }
+
+private:
+    std::string samplers[MATERIAL_MAX_TEXTURES];   // 采样器 uniform 名字（只在解析时使用）
+    GLuint textures[MATERIAL_MAX_TEXTURES];
+    UniformHandle handles[MATERIAL_MAX_TEXTURES];
+    unsigned int textureCount;
+    GLuint program;     // 句柄所属的着色器程序
+
+    void resolve(const Shader &shader) {
+        for (unsigned int i = 0; i < textureCount; ++i)
+            handles[i] = shader.getUniform(samplers[i]);
+        program = shader.ID;
+    }
+};
+
+#endif /* material_h */
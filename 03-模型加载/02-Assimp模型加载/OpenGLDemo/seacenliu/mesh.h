@@ -6,6 +6,18 @@
 //  Copyright © 2020 SeacenLiu. All rights reserved.
 //
 
+/**
+ * 网格
+ *
+ * 同一个模型的所有网格共用一个顶点/索引缓冲区（MeshArena）和一个 VAO：
+ * 每个网格只记录自己在共享缓冲中的范围（起始索引、基础顶点、索引数量），
+ * 绘制时用 glDrawElementsBaseVertex / glMultiDrawElementsBaseVertex，
+ * 不再需要为每个子网格切换 VAO。
+ * 共享缓冲默认使用紧凑顶点格式（vertex_format.h），写入时完成量化。
+ *
+ * 每个网格最多 MESH_MAX_LODS 级细节（LOD，见 mesh_simplifier.h）：各级共用同一组顶点，
+ * 简化后的索引依次追加在原始索引后面，一起写入共享缓冲；range 描述第 0 级（原始网格）。
+ */
 #ifndef mesh_h
 #define mesh_h
 
@@ -13,11 +25,20 @@
 #include <glm/glm.hpp>
 #include <string>
 #include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <iostream>
+#include <algorithm>
 using namespace std;
 
 #include <assimp/types.h>
 
 #include "shader.h"
+#include "texture_cache.h"
+#include "material.h"
+#include "vertex_format.h"
+#include "frustum.h"
 
 // 顶点数据
 struct Vertex {
@@ -35,6 +56,206 @@ struct Texture {
     */
     string type;
     aiString path;  // 我们储存纹理的路径用于与其它纹理进行比较
+    TextureHandle handle;   // 纹理缓存中的引用（网格存在期间纹理不会被回收）
+};
+
+// 网格在共享缓冲中的范围
+struct MeshRange {
+    GLsizei indexCount;     // 索引数量
+    GLsizeiptr indexOffset; // 第一个索引在索引缓冲中的字节偏移
+    GLint baseVertex;       // 加到每个索引上的基础顶点
+    GLenum indexType;       // 索引类型（GL_UNSIGNED_SHORT / GL_UNSIGNED_INT）
+};
+
+// LOD 级数上限（第 0 级为原始网格）
+#define MESH_MAX_LODS 4
+
+// 一级 LOD：在网格索引中的范围和简化误差（物体空间的距离，第 0 级为 0）
+struct MeshLod {
+    uint32_t indexFirst;
+    uint32_t indexCount;
+    float error;
+};
+
+// 顶点位置的包围盒（物体空间）
+inline AABB MeshBounds(const Vertex *vertexData, size_t vertices) {
+    AABB bounds;
+    for (size_t i = 0; i < vertices; ++i)
+        bounds.expand(vertexData[i].Position);
+    return bounds;
+}
+
+// 共享的顶点/索引缓冲区（一个模型一个）
+class MeshArena {
+public:
+    // 缓冲和 VAO 的 ID
+    unsigned int VAO, VBO, EBO;
+    // 顶点格式、数据量和量化误差
+    VertexFormatReport report;
+
+    MeshArena()
+        : VAO(0), VBO(0), EBO(0), positionScale(glm::vec3(1.0f)), positionOffset(glm::vec3(0.0f)),
+          program(0), vertexCapacity(0), indexCapacity(0), vertexCount(0), indexCount(0) {}
+    // 按总顶点数、总索引数分配显存并配置顶点属性（之后用 append 逐个写入网格）
+    // - format 为 VERTEX_FORMAT_COMPACT 时按 bounds 量化位置
+    // - indexType 为 GL_UNSIGNED_SHORT 时每个网格的顶点数不能超过 65536
+    void allocate(size_t vertices, size_t indices,
+                  VertexFormat format = VERTEX_FORMAT_FULL, GLenum indexType = GL_UNSIGNED_INT,
+                  const AABB &bounds = AABB()) {
+        vertexCapacity = vertices;
+        indexCapacity = indices;
+        vertexCount = indexCount = 0;
+        report = VertexFormatReport();
+        report.format = format;
+        report.indexType = indexType;
+        positionScale = glm::vec3(1.0f);
+        positionOffset = glm::vec3(0.0f);
+        if (format == VERTEX_FORMAT_COMPACT && !bounds.empty()) {
+            // 包围盒中心对应 0，半边长对应 32767
+            positionOffset = (bounds.min + bounds.max) * 0.5f;
+            positionScale = (bounds.max - bounds.min) * (0.5f / 32767.0f);
+        }
+        glGenVertexArrays(1, &VAO);
+        glGenBuffers(1, &VBO);
+        glGenBuffers(1, &EBO);
+        GLState &state = GLState::instance();
+        state.bindVertexArray(VAO);
+        state.bindBuffer(GL_ARRAY_BUFFER, VBO);
+        glBufferData(GL_ARRAY_BUFFER, vertices * report.vertexSize(), NULL, GL_STATIC_DRAW);
+        state.bindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices * report.indexSize(), NULL, GL_STATIC_DRAW);
+        if (format == VERTEX_FORMAT_COMPACT) {
+            GLsizei stride = sizeof(CompactVertex);
+            // 量化位置（非归一化，着色器中缩放）
+            glEnableVertexAttribArray(0);
+            glVertexAttribPointer(0, 4, GL_SHORT, GL_FALSE, stride, (void*)offsetof(CompactVertex, position));
+            // 八面体法向量（location 3，location 1 不使用）
+            glDisableVertexAttribArray(1);
+            glEnableVertexAttribArray(3);
+            glVertexAttribPointer(3, 2, GL_SHORT, GL_FALSE, stride, (void*)offsetof(CompactVertex, normal));
+            // 半精度纹理坐标
+            glEnableVertexAttribArray(2);
+            glVertexAttribPointer(2, 2, GL_HALF_FLOAT, GL_FALSE, stride, (void*)offsetof(CompactVertex, texCoords));
+        } else {
+            // 顶点位置
+            glEnableVertexAttribArray(0);
+            glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
+            // 顶点法线
+            glEnableVertexAttribArray(1);
+            glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Normal));
+            // 顶点纹理坐标
+            glEnableVertexAttribArray(2);
+            glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, TexCoords));
+        }
+        state.bindVertexArray(0);
+    }
+    // 写入一个网格的顶点和索引（紧凑格式时在这里转换），返回它在共享缓冲中的范围
+    MeshRange append(const Vertex *vertexData, size_t vertices,
+                     const unsigned int *indexData, size_t indices) {
+        MeshRange range;
+        range.indexCount = (GLsizei)indices;
+        range.indexOffset = (GLsizeiptr)(indexCount * report.indexSize());
+        range.baseVertex = (GLint)vertexCount;
+        range.indexType = report.indexType;
+        if (vertexCount + vertices > vertexCapacity || indexCount + indices > indexCapacity) {
+            cout << "ERROR::MESH_ARENA::out of space" << endl;
+            range.indexCount = 0;
+            return range;
+        }
+        if (report.indexType == GL_UNSIGNED_SHORT && vertices > 65536) {
+            cout << "ERROR::MESH_ARENA::mesh too large for 16-bit indices" << endl;
+            range.indexCount = 0;
+            return range;
+        }
+        GLState &state = GLState::instance();
+        state.bindBuffer(GL_ARRAY_BUFFER, VBO);
+        if (vertices > 0) {
+            if (report.format == VERTEX_FORMAT_COMPACT) {
+                vector<CompactVertex> compact(vertices);
+                for (size_t i = 0; i < vertices; ++i)
+                    compress(vertexData[i], compact[i]);
+                glBufferSubData(GL_ARRAY_BUFFER, vertexCount * sizeof(CompactVertex),
+                                vertices * sizeof(CompactVertex), compact.data());
+            } else {
+                glBufferSubData(GL_ARRAY_BUFFER, vertexCount * sizeof(Vertex), vertices * sizeof(Vertex), vertexData);
+            }
+        }
+        // 索引缓冲绑定属于 VAO 状态，先绑定 VAO
+        state.bindVertexArray(VAO);
+        if (indices > 0) {
+            if (report.indexType == GL_UNSIGNED_SHORT) {
+                vector<unsigned short> shortIndices(indexData, indexData + indices);
+                glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, range.indexOffset,
+                                indices * sizeof(unsigned short), shortIndices.data());
+            } else {
+                glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, range.indexOffset, indices * sizeof(unsigned int), indexData);
+            }
+        }
+        vertexCount += vertices;
+        indexCount += indices;
+        report.vertexCount = vertexCount;
+        report.indexCount = indexCount;
+        return range;
+    }
+    // 绑定 VAO 并设置反量化参数（换了着色器程序时才重新解析 uniform 位置）
+    void bind(const Shader &shader) {
+        GLState::instance().bindVertexArray(VAO);
+        if (shader.ID != program) {
+            compactHandle = shader.getUniform("compactVertex");
+            scaleHandle = shader.getUniform("positionScale");
+            offsetHandle = shader.getUniform("positionOffset");
+            program = shader.ID;
+        }
+        shader.setBool(compactHandle, report.format == VERTEX_FORMAT_COMPACT);
+        shader.setVec3(scaleHandle, positionScale);
+        shader.setVec3(offsetHandle, positionOffset);
+    }
+    // 释放 OpenGL 资源
+    void release() {
+        GLState::instance().deleteVertexArrays(1, &VAO);
+        GLState::instance().deleteBuffers(1, &VBO);
+        GLState::instance().deleteBuffers(1, &EBO);
+    }
+
+private:
+    glm::vec3 positionScale, positionOffset;
+    UniformHandle compactHandle, scaleHandle, offsetHandle;
+    GLuint program;     // uniform 句柄所属的着色器程序
+    size_t vertexCapacity, indexCapacity;
+    size_t vertexCount, indexCount;
+
+    // 转换为紧凑顶点并统计量化误差
+    void compress(const Vertex &vertex, CompactVertex &out) {
+        double positionError = 0.0;
+        for (int k = 0; k < 3; ++k) {
+            float q = positionScale[k] > 0.0f ? (vertex.Position[k] - positionOffset[k]) / positionScale[k] : 0.0f;
+            q = std::max(-32767.0f, std::min(32767.0f, q));
+            out.position[k] = (int16_t)std::lround(q);
+            float restored = out.position[k] * positionScale[k] + positionOffset[k];
+            positionError = std::max(positionError, (double)std::fabs(restored - vertex.Position[k]));
+        }
+        out.position[3] = 0;
+        report.maxPositionError = std::max(report.maxPositionError, positionError);
+        // 法向量（零向量不参与误差统计）
+        const glm::vec3 &n = vertex.Normal;
+        float length = std::sqrt(n.x * n.x + n.y * n.y + n.z * n.z);
+        float u, v;
+        OctEncode(n, u, v);
+        out.normal[0] = QuantizeSnorm16(u);
+        out.normal[1] = QuantizeSnorm16(v);
+        if (length > 0.0f) {
+            glm::vec3 restored = OctDecode(out.normal[0] / 32767.0f, out.normal[1] / 32767.0f);
+            double cosine = (restored.x * n.x + restored.y * n.y + restored.z * n.z) / length;
+            double degrees = std::acos(std::max(-1.0, std::min(1.0, cosine))) * 180.0 / 3.14159265358979323846;
+            report.maxNormalError = std::max(report.maxNormalError, degrees);
+        }
+        // 纹理坐标
+        for (int k = 0; k < 2; ++k) {
+            out.texCoords[k] = FloatToHalf(vertex.TexCoords[k]);
+            double error = std::fabs(HalfToFloat(out.texCoords[k]) - vertex.TexCoords[k]);
+            report.maxTexCoordError = std::max(report.maxTexCoordError, error);
+        }
+    }
 };
 
 // 网格
@@ -46,70 +267,106 @@ public:
     vector<unsigned int> indices;
     // 纹理数据
     vector<Texture> textures;
+    // 材质（采样器绑定，由纹理数据生成）
+    Material material;
+    // 在共享缓冲中的范围（upload 之后有效）
+    MeshRange range;
+    // 物体空间的包围盒（用于视锥体剔除）
+    AABB bounds;
+    // 各级 LOD（lods[0] 为原始网格）
+    MeshLod lods[MESH_MAX_LODS];
+    unsigned int lodCount;
     
-    // 构造函数
-    Mesh(vector<Vertex> vertices, vector<unsigned int> indices, vector<Texture> textures) {
-        this->vertices = vertices;
-        this->indices = indices;
-        this->textures = textures;
-        setupMesh();
+    // 构造函数（接管顶点、索引和纹理数据，不发生拷贝；之后调用 upload 写入共享缓冲）
+    Mesh(vector<Vertex> &&vertices, vector<unsigned int> &&indices, vector<Texture> &&textures)
+        : vertices(std::move(vertices)), indices(std::move(indices)), textures(std::move(textures)) {
+        range = MeshRange{ 0, 0, 0, GL_UNSIGNED_INT };
+        bounds = MeshBounds(this->vertices.data(), this->vertices.size());
+        setLods(NULL, 0);
+        setupMaterial();
+    }
+    // 构造函数（直接从外部内存写入共享缓冲，例如 mmap 的网格缓存；keepCPUData 为 true 时才拷贝一份到 CPU 端）
+    // indexData 包含所有 LOD 的索引，lodData 为 NULL 时只有第 0 级
+    Mesh(MeshArena &arena,
+         const Vertex *vertexData, size_t vertexCount,
+         const unsigned int *indexData, size_t indexCount,
+         vector<Texture> &&textures, bool keepCPUData = false,
+         const MeshLod *lodData = NULL, unsigned int lodDataCount = 0)
+        : textures(std::move(textures)) {
+        if (keepCPUData) {
+            vertices.assign(vertexData, vertexData + vertexCount);
+            indices.assign(indexData, indexData + indexCount);
+        }
+        setLods(lodData, lodDataCount, indexCount);
+        range = arena.append(vertexData, vertexCount, indexData, indexCount);
+        range.indexCount = (GLsizei)std::min((size_t)range.indexCount, (size_t)lods[0].indexCount);
+        bounds = MeshBounds(vertexData, vertexCount);
+        setupMaterial();
+    }
+    // 只能移动不能拷贝
+    Mesh(Mesh &&) = default;
+    Mesh &operator=(Mesh &&) = default;
+    Mesh(const Mesh &) = delete;
+    Mesh &operator=(const Mesh &) = delete;
+    // 设置 LOD 表（lodData 为 NULL 时只有第 0 级，即全部 indexTotal 个索引；
+    // indexTotal 为 0 时取 CPU 端的索引数量）。超出索引范围的级别被丢弃
+    void setLods(const MeshLod *lodData, unsigned int lodDataCount, size_t indexTotal = 0) {
+        if (indexTotal == 0)
+            indexTotal = indices.size();
+        lodCount = 1;
+        lods[0] = MeshLod{ 0, (uint32_t)indexTotal, 0.0f };
+        if (!lodData || lodDataCount == 0 || (size_t)lodData[0].indexFirst + lodData[0].indexCount > indexTotal)
+            return;
+        lods[0] = lodData[0];
+        for (unsigned int i = 1; i < lodDataCount && i < MESH_MAX_LODS; ++i) {
+            if ((size_t)lodData[i].indexFirst + lodData[i].indexCount > indexTotal)
+                break;
+            lods[lodCount++] = lodData[i];
+        }
+    }
+    // 把 CPU 端的顶点和索引（包括所有 LOD）写入共享缓冲，range 只覆盖第 0 级
+    void upload(MeshArena &arena) {
+        range = arena.append(vertices.data(), vertices.size(), indices.data(), indices.size());
+        range.indexCount = (GLsizei)std::min((size_t)range.indexCount, (size_t)lods[0].indexCount);
+    }
+    // 第 level 级 LOD 的索引数量和第一个索引在共享缓冲中的字节偏移
+    GLsizei lodIndexCount(unsigned int level) const {
+        return range.indexCount == 0 ? 0 : (GLsizei)lods[level].indexCount;
+    }
+    const void *lodIndexOffset(unsigned int level) const {
+        size_t indexSize = range.indexType == GL_UNSIGNED_SHORT ? sizeof(unsigned short) : sizeof(unsigned int);
+        return (const void *)(range.indexOffset + (GLsizeiptr)(lods[level].indexFirst * indexSize));
     }
-    // 绘制函数
-    void Draw(Shader shader) {
+    // 释放 CPU 端的顶点和索引数据（已经上传到显存，绘制不再需要）
+    void releaseCPUData() {
+        vector<Vertex>().swap(vertices);
+        vector<unsigned int>().swap(indices);
+    }
+    // CPU 端顶点和索引数据占用的内存（字节）
+    size_t cpuBytes() const {
+        return vertices.capacity() * sizeof(Vertex) + indices.capacity() * sizeof(unsigned int);
+    }
+    // 单独绘制这个网格的第 level 级 LOD（需先调用 MeshArena::bind；模型绘制时会把相同材质的网格合并成一次调用）
+    void Draw(const Shader &shader, unsigned int level = 0) {
+        material.bind(shader);
+        glDrawElementsBaseVertex(GL_TRIANGLES, lodIndexCount(level), range.indexType,
+                                 lodIndexOffset(level), range.baseVertex);
+    }
+private:
+    // 生成材质：按类型编号得到采样器名字（texture_diffuseN、texture_specularN），第 i 个纹理使用纹理单元 i
+    void setupMaterial() {
         unsigned int diffuseNr = 1;
         unsigned int specularNr = 1;
-        for(unsigned int i = 0; i < textures.size(); i++)
-        {
-            // 在绑定之前激活相应的纹理单元
-            glActiveTexture(GL_TEXTURE0 + i);
-            // 获取纹理序号（diffuse_textureN 中的 N）
+        for (unsigned int i = 0; i < textures.size(); ++i) {
             string number;
-            string name = textures[i].type;
-            if(name == "texture_diffuse")
+            const string &name = textures[i].type;
+            if (name == "texture_diffuse")
                 number = std::to_string(diffuseNr++);
-            else if(name == "texture_specular")
+            else if (name == "texture_specular")
                 number = std::to_string(specularNr++);
-
-            shader.setFloat(("material." + name + number).c_str(), i);
-            glBindTexture(GL_TEXTURE_2D, textures[i].id);
+            if (material.add("material." + name + number, textures[i].id) < 0)
+                cout << "WARNING::MESH::too many textures, " << name << number << " ignored" << endl;
         }
-        glActiveTexture(GL_TEXTURE0);
-
-        // 绘制网格
-        glBindVertexArray(VAO);
-        glDrawElements(GL_TRIANGLES, (GLsizei)indices.size(), GL_UNSIGNED_INT, 0);
-        glBindVertexArray(0);
-    }
-private:
-    // 渲染数据
-    unsigned int VAO, VBO, EBO;
-    // 配置网格数据
-    void setupMesh() {
-        // 创建 VBO、VAO、EBO
-        glGenBuffers(1, &VBO);
-        glGenVertexArrays(1, &VAO);
-        glGenBuffers(1, &EBO);
-        // 配置 VBO、VAO
-        glBindBuffer(GL_ARRAY_BUFFER, VBO);
-        glBindVertexArray(VAO);
-        glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), &vertices[0], GL_STATIC_DRAW);
-        // 配置 EBO
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int),
-                     &indices[0], GL_STATIC_DRAW);
-        
-        // 顶点位置
-        glEnableVertexAttribArray(0);
-        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
-        // 顶点法线
-        glEnableVertexAttribArray(1);
-        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Normal));
-        // 顶点纹理坐标
-        glEnableVertexAttribArray(2);
-        glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, TexCoords));
-        
-        // 解绑
-        glBindVertexArray(0);
     }
 };
 
@@ -0,0 +1,289 @@
+//
+//  mesh_cache.h
+//  OpenGLDemo
+//
+//  Created by SeacenLiu on 2020/2/9.
+//  Copyright © 2020 SeacenLiu. All rights reserved.
+//
+
+/**
+ * 二进制网格缓存（.meshbin）
+ *
+ * 第一次用 Assimp 导入模型后，把所有网格的交错顶点数据（Vertex）、索引和纹理引用
+ * 原样写入 "<模型路径>.meshbin"，之后启动时直接 mmap 缓存文件，
+ * 顶点和索引数据不经过任何解析和拷贝，直接交给 glBufferData。
+ *
+ * 文件布局（所有偏移量相对文件开头，数据块按 16 字节对齐）：
+ *   MeshBinHeader
+ *   MeshBinMesh[meshCount]
+ *   MeshBinTexture[textureCount]
+ *   每个网格的 Vertex[vertexCount]、unsigned int[indexCount]（包括所有 LOD 的索引）
+ *
+ * 以下任意一项与当前不一致时缓存自动失效，重新走 Assimp 导入并覆盖缓存：
+ * - 格式版本号、sizeof(Vertex)、Assimp 后期处理选项
+ * - 源文件以及它引用的材质库（OBJ 的 mtllib）内容的 FNV-1a 哈希
+ */
+#ifndef mesh_cache_h
+#define mesh_cache_h
+
+#include <cstdio>
+#include <cstring>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <sstream>
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "mesh.h"
+
+// 版本 2：网格经过导入优化（mesh_optimizer.h）
+// 版本 3：网格记录中加入 LOD 表（mesh_simplifier.h）
+#define MESHBIN_VERSION 3
+#define MESHBIN_ALIGN   16
+
+// 文件头
+struct MeshBinHeader {
+    char     magic[8];      // "MESHBIN"
+    uint32_t version;       // MESHBIN_VERSION
+    uint32_t vertexSize;    // sizeof(Vertex)
+    uint64_t sourceHash;    // 源文件哈希
+    uint32_t importFlags;   // Assimp 后期处理选项
+    uint32_t meshCount;
+    uint32_t textureCount;
+    uint32_t padding;
+};
+
+// 网格记录
+struct MeshBinMesh {
+    uint64_t vertexOffset;
+    uint64_t indexOffset;
+    uint32_t vertexCount;
+    uint32_t indexCount;    // 所有 LOD 的索引总数
+    uint32_t textureFirst;  // 在纹理引用表中的起始下标
+    uint32_t textureCount;
+    uint32_t lodCount;
+    uint32_t padding;
+    MeshLod  lods[MESH_MAX_LODS];
+};
+
+// 纹理引用（类型 + 相对模型目录的路径，与 Texture 一致）
+struct MeshBinTexture {
+    char type[32];
+    char path[MAXLEN];
+};
+
+static_assert(sizeof(MeshBinHeader) == 40, "MeshBinHeader size mismatch");
+static_assert(sizeof(MeshBinMesh) == 40 + 12 * MESH_MAX_LODS, "MeshBinMesh size mismatch");
+
+// FNV-1a 64 位哈希
+inline uint64_t MeshCacheHash(const char *data, size_t size, uint64_t hash = 14695981039346656037ULL) {
+    for (size_t i = 0; i < size; ++i) {
+        hash ^= (unsigned char)data[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+// 读取整个文件（失败返回 false）
+inline bool MeshCacheReadFile(const string &path, string &content) {
+    ifstream file(path.c_str(), ios::in | ios::binary);
+    if (!file)
+        return false;
+    stringstream stream;
+    stream << file.rdbuf();
+    content = stream.str();
+    return true;
+}
+
+// 源文件哈希：模型文件内容 + OBJ 中 mtllib 引用的材质库内容（源文件不存在时返回 0）
+inline uint64_t MeshCacheSourceHash(const string &path) {
+    string content;
+    if (!MeshCacheReadFile(path, content))
+        return 0;
+    uint64_t hash = MeshCacheHash(content.data(), content.size());
+    string directory = path.substr(0, path.find_last_of('/'));
+    istringstream lines(content);
+    string line;
+    while (getline(lines, line)) {
+        if (line.compare(0, 7, "mtllib ") != 0)
+            continue;
+        string library = line.substr(7);
+        library.erase(library.find_last_not_of(" \t\r") + 1);
+        string material;
+        if (MeshCacheReadFile(directory + '/' + library, material))
+            hash = MeshCacheHash(material.data(), material.size(), hash);
+    }
+    return hash == 0 ? 1 : hash;
+}
+
+// 写入缓存（先写临时文件再改名，写到一半失败不会留下损坏的缓存）
+inline bool WriteMeshCache(const string &cachePath,
+                           uint64_t sourceHash,
+                           unsigned int importFlags,
+                           const vector<Mesh> &meshes) {
+    MeshBinHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, "MESHBIN", 8);
+    header.version = MESHBIN_VERSION;
+    header.vertexSize = sizeof(Vertex);
+    header.sourceHash = sourceHash;
+    header.importFlags = importFlags;
+    header.meshCount = (uint32_t)meshes.size();
+
+    vector<MeshBinMesh> records(meshes.size());
+    vector<MeshBinTexture> textures;
+    for (size_t i = 0; i < meshes.size(); ++i) {
+        records[i].lodCount = meshes[i].lodCount;
+        memcpy(records[i].lods, meshes[i].lods, sizeof(records[i].lods));
+        records[i].textureFirst = (uint32_t)textures.size();
+        records[i].textureCount = (uint32_t)meshes[i].textures.size();
+        for (size_t j = 0; j < meshes[i].textures.size(); ++j) {
+            MeshBinTexture texture;
+            memset(&texture, 0, sizeof(texture));
+            strncpy(texture.type, meshes[i].textures[j].type.c_str(), sizeof(texture.type) - 1);
+            strncpy(texture.path, meshes[i].textures[j].path.C_Str(), sizeof(texture.path) - 1);
+            textures.push_back(texture);
+        }
+    }
+    header.textureCount = (uint32_t)textures.size();
+
+    // 计算数据块偏移
+    uint64_t offset = sizeof(MeshBinHeader)
+                    + records.size() * sizeof(MeshBinMesh)
+                    + textures.size() * sizeof(MeshBinTexture);
+    for (size_t i = 0; i < meshes.size(); ++i) {
+        offset = (offset + MESHBIN_ALIGN - 1) / MESHBIN_ALIGN * MESHBIN_ALIGN;
+        records[i].vertexOffset = offset;
+        records[i].vertexCount = (uint32_t)meshes[i].vertices.size();
+        offset += meshes[i].vertices.size() * sizeof(Vertex);
+        offset = (offset + MESHBIN_ALIGN - 1) / MESHBIN_ALIGN * MESHBIN_ALIGN;
+        records[i].indexOffset = offset;
+        records[i].indexCount = (uint32_t)meshes[i].indices.size();
+        offset += meshes[i].indices.size() * sizeof(unsigned int);
+    }
+
+    string tempPath = cachePath + ".tmp";
+    FILE *file = fopen(tempPath.c_str(), "wb");
+    if (!file)
+        return false;
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1;
+    if (!records.empty())
+        ok = ok && fwrite(&records[0], sizeof(MeshBinMesh), records.size(), file) == records.size();
+    if (!textures.empty())
+        ok = ok && fwrite(&textures[0], sizeof(MeshBinTexture), textures.size(), file) == textures.size();
+    static const char zeros[MESHBIN_ALIGN] = { 0 };
+    for (size_t i = 0; ok && i < meshes.size(); ++i) {
+        long position = ftell(file);
+        ok = fwrite(zeros, 1, records[i].vertexOffset - position, file) == records[i].vertexOffset - position;
+        if (!meshes[i].vertices.empty())
+            ok = ok && fwrite(&meshes[i].vertices[0], sizeof(Vertex), meshes[i].vertices.size(), file) == meshes[i].vertices.size();
+        position = ftell(file);
+        ok = ok && fwrite(zeros, 1, records[i].indexOffset - position, file) == records[i].indexOffset - position;
+        if (!meshes[i].indices.empty())
+            ok = ok && fwrite(&meshes[i].indices[0], sizeof(unsigned int), meshes[i].indices.size(), file) == meshes[i].indices.size();
+    }
+    ok = (fclose(file) == 0) && ok;
+    if (!ok || rename(tempPath.c_str(), cachePath.c_str()) != 0) {
+        remove(tempPath.c_str());
+        return false;
+    }
+    return true;
+}
+
+// 只读映射缓存文件
+class MeshCacheReader {
+public:
+    MeshCacheReader() : data(NULL), size(0) {}
+    ~MeshCacheReader() {
+        close();
+    }
+    // 映射并校验缓存（与源文件不匹配或文件损坏时返回 false）
+    bool open(const string &cachePath, uint64_t sourceHash, unsigned int importFlags) {
+        close();
+        int fd = ::open(cachePath.c_str(), O_RDONLY);
+        if (fd < 0)
+            return false;
+        struct stat st;
+        if (fstat(fd, &st) == 0 && st.st_size >= (off_t)sizeof(MeshBinHeader)) {
+            void *mapped = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (mapped != MAP_FAILED) {
+                data = (const char *)mapped;
+                size = (size_t)st.st_size;
+            }
+        }
+        ::close(fd);
+        if (!data)
+            return false;
+        if (!validate(sourceHash, importFlags)) {
+            close();
+            return false;
+        }
+        return true;
+    }
+    void close() {
+        if (data)
+            munmap((void *)data, size);
+        data = NULL;
+        size = 0;
+    }
+    const MeshBinHeader &header() const {
+        return *(const MeshBinHeader *)data;
+    }
+    const MeshBinMesh &mesh(unsigned int index) const {
+        return ((const MeshBinMesh *)(data + sizeof(MeshBinHeader)))[index];
+    }
+    const MeshBinTexture &texture(unsigned int index) const {
+        return ((const MeshBinTexture *)(data + sizeof(MeshBinHeader)
+                                         + header().meshCount * sizeof(MeshBinMesh)))[index];
+    }
+    const Vertex *vertices(unsigned int index) const {
+        return (const Vertex *)(data + mesh(index).vertexOffset);
+    }
+    const unsigned int *indices(unsigned int index) const {
+        return (const unsigned int *)(data + mesh(index).indexOffset);
+    }
+
+private:
+    const char *data;
+    size_t size;
+
+    // 禁止拷贝（析构时会解除映射）
+    MeshCacheReader(const MeshCacheReader &);
+    MeshCacheReader &operator=(const MeshCacheReader &);
+
+    bool validate(uint64_t sourceHash, unsigned int importFlags) const {
+        const MeshBinHeader &h = header();
+        if (memcmp(h.magic, "MESHBIN", 8) != 0
+            || h.version != MESHBIN_VERSION
+            || h.vertexSize != sizeof(Vertex)
+            || h.sourceHash != sourceHash
+            || h.importFlags != importFlags)
+            return false;
+        uint64_t tables = sizeof(MeshBinHeader)
+                        + (uint64_t)h.meshCount * sizeof(MeshBinMesh)
+                        + (uint64_t)h.textureCount * sizeof(MeshBinTexture);
+        if (tables > size)
+            return false;
+        // 检查每个数据块都在文件范围内（防止截断的文件）
+        for (unsigned int i = 0; i < h.meshCount; ++i) {
+            const MeshBinMesh &m = mesh(i);
+            if (m.vertexOffset + (uint64_t)m.vertexCount * sizeof(Vertex) > size
+                || m.indexOffset + (uint64_t)m.indexCount * sizeof(unsigned int) > size
+                || (uint64_t)m.textureFirst + m.textureCount > h.textureCount
+                || m.lodCount == 0 || m.lodCount > MESH_MAX_LODS)
+                return false;
+            for (unsigned int j = 0; j < m.lodCount; ++j) {
+                if ((uint64_t)m.lods[j].indexFirst + m.lods[j].indexCount > m.indexCount)
+                    return false;
+            }
+        }
+        return true;
+    }
+};
+
+#endif /* mesh_cache_h */
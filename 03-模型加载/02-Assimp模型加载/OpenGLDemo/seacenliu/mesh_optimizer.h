@@ -0,0 +1,349 @@
+//
+//  mesh_optimizer.h
+//  OpenGLDemo
+//
+//  Created by SeacenLiu on 2020/2/15.
+//  Copyright © 2020 SeacenLiu. All rights reserved.
+//
+
+/**
+ * 导入时的网格优化
+ *
+ * OBJ 等格式按面存储顶点，导入后大量顶点重复，索引顺序也是文件中的原始顺序，
+ * 顶点着色器的变换后缓存（post-transform cache）命中率很低。导入时依次做四步：
+ * 1. 焊接（WeldVertices）：位置、法向量、纹理坐标完全相同的顶点合并为一个（开放寻址哈希表）
+ * 2. 顶点缓存优化（OptimizeVertexCache）：Tipsify 算法重排三角形，
+ *    每次围绕一个顶点输出它所有的三角形，下一个顶点优先选仍在缓存中的
+ * 3. 过度绘制优化（OptimizeOverdraw）：把第 2 步的结果切成若干簇，
+ *    朝外的簇（更可能遮挡其它部分）先画，簇内部的顺序不变，缓存命中率基本不受影响
+ * 4. 顶点读取优化（OptimizeVertexFetch）：按第一次被索引的顺序重排顶点，读取顶点缓冲时更连续
+ *
+ * 效果用 FIFO 缓存模拟（AnalyzeVertexCache）衡量：
+ * - ACMR：平均每个三角形的缓存未命中数（变换的顶点数 / 三角形数），理想值约 0.5
+ * - ATVR：平均每个顶点被变换的次数（以焊接后的顶点数为分母），理想值 1.0
+ */
+#ifndef mesh_optimizer_h
+#define mesh_optimizer_h
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include <iostream>
+#include <algorithm>
+
+#include "mesh.h"
+
+// 模拟和优化时假定的顶点缓存大小（FIFO）
+#define MESH_OPTIMIZER_CACHE_SIZE 16
+// 过度绘制优化切分簇的阈值：簇内 ACMR 低于整体 ACMR 的这个倍数时切分（越大簇越小，缓存效率越低）
+#define MESH_OPTIMIZER_OVERDRAW_THRESHOLD 1.05
+
+// 顶点缓存模拟结果
+struct VertexCacheStats {
+    size_t triangles;   // 三角形数量
+    size_t misses;      // 缓存未命中（需要变换的顶点）数量
+
+    double acmr() const {
+        return triangles ? (double)misses / triangles : 0.0;
+    }
+    double atvr(size_t vertexCount) const {
+        return vertexCount ? (double)misses / vertexCount : 0.0;
+    }
+};
+
+// 网格优化统计（可以累加得到整个模型的统计）
+struct MeshOptimizeStats {
+    size_t verticesBefore;      // 焊接前的顶点数
+    size_t verticesAfter;       // 焊接后的顶点数
+    VertexCacheStats before;    // 优化前的缓存模拟（原始顶点、原始顺序）
+    VertexCacheStats after;     // 优化后的缓存模拟
+
+    MeshOptimizeStats() : verticesBefore(0), verticesAfter(0), before(VertexCacheStats{ 0, 0 }), after(VertexCacheStats{ 0, 0 }) {}
+    void add(const MeshOptimizeStats &other) {
+        verticesBefore += other.verticesBefore;
+        verticesAfter += other.verticesAfter;
+        before.triangles += other.before.triangles;
+        before.misses += other.before.misses;
+        after.triangles += other.after.triangles;
+        after.misses += other.after.misses;
+    }
+    void print() const {
+        std::cout << "网格优化: 顶点 " << verticesBefore << " -> " << verticesAfter << ", "
+                  << before.triangles << " 个三角形, ACMR " << before.acmr() << " -> " << after.acmr()
+                  << ", ATVR " << before.atvr(verticesAfter) << " -> " << after.atvr(verticesAfter)
+                  << " (FIFO 缓存 " << MESH_OPTIMIZER_CACHE_SIZE << ")" << std::endl;
+    }
+};
+
+// 模拟 FIFO 顶点缓存，统计未命中次数
+inline VertexCacheStats AnalyzeVertexCache(const std::vector<unsigned int> &indices, size_t vertexCount,
+                                           unsigned int cacheSize = MESH_OPTIMIZER_CACHE_SIZE) {
+    VertexCacheStats stats = { indices.size() / 3, 0 };
+    // 每个顶点进入缓存时的时间戳，时间戳落后超过 cacheSize 说明已经被挤出缓存
+    std::vector<size_t> stamp(vertexCount, 0);
+    size_t time = cacheSize + 1;
+    for (size_t i = 0; i < indices.size(); ++i) {
+        unsigned int v = indices[i];
+        if (v >= vertexCount)
+            continue;
+        if (time - stamp[v] > cacheSize) {
+            stamp[v] = time++;
+            ++stats.misses;
+        }
+    }
+    return stats;
+}
+
+// 焊接完全相同的顶点，返回焊接后的顶点数
+inline size_t WeldVertices(std::vector<Vertex> &vertices, std::vector<unsigned int> &indices) {
+    size_t count = vertices.size();
+    if (count == 0)
+        return 0;
+    // 开放寻址哈希表，容量为 2 的幂且不低于顶点数的 2 倍，空位为 ~0u
+    size_t capacity = 1;
+    while (capacity < count * 2)
+        capacity <<= 1;
+    std::vector<unsigned int> table(capacity, ~0u);
+    std::vector<unsigned int> remap(count);
+    size_t unique = 0;
+    for (size_t i = 0; i < count; ++i) {
+        // 按字节比较（-0.0 与 0.0 视为不同，不影响正确性）
+        const unsigned char *bytes = (const unsigned char *)&vertices[i];
+        uint32_t hash = 2166136261u;
+        for (size_t b = 0; b < sizeof(Vertex); ++b) {
+            hash ^= bytes[b];
+            hash *= 16777619u;
+        }
+        size_t slot = hash & (capacity - 1);
+        while (table[slot] != ~0u && std::memcmp(&vertices[table[slot]], &vertices[i], sizeof(Vertex)) != 0)
+            slot = (slot + 1) & (capacity - 1);
+        if (table[slot] == ~0u) {
+            // 新顶点：原地前移（unique <= i，不会覆盖还没处理的顶点）
+            vertices[unique] = vertices[i];
+            table[slot] = (unsigned int)unique;
+            remap[i] = (unsigned int)unique++;
+        } else {
+            remap[i] = table[slot];
+        }
+    }
+    vertices.resize(unique);
+    for (size_t i = 0; i < indices.size(); ++i)
+        indices[i] = indices[i] < count ? remap[indices[i]] : 0;
+    return unique;
+}
+
+// Tipsify 顶点缓存优化（Sander 等，2007），返回重排后的索引；
+// clusters 输出每一簇的起始三角形（缓存“断流”、不得不跳到别处继续的位置）
+inline std::vector<unsigned int> OptimizeVertexCache(const std::vector<unsigned int> &indices, size_t vertexCount,
+                                                     std::vector<size_t> *clusters = NULL,
+                                                     unsigned int cacheSize = MESH_OPTIMIZER_CACHE_SIZE) {
+    size_t triangleCount = indices.size() / 3;
+    std::vector<unsigned int> result;
+    result.reserve(triangleCount * 3);
+    if (clusters)
+        clusters->clear();
+    if (triangleCount == 0 || vertexCount == 0)
+        return result;
+    // 顶点 -> 三角形邻接表（CSR 格式），live 为每个顶点还没输出的三角形数量
+    std::vector<unsigned int> live(vertexCount, 0);
+    for (size_t i = 0; i < triangleCount * 3; ++i)
+        ++live[indices[i]];
+    std::vector<size_t> offsets(vertexCount + 1, 0);
+    for (size_t v = 0; v < vertexCount; ++v)
+        offsets[v + 1] = offsets[v] + live[v];
+    std::vector<unsigned int> adjacency(offsets[vertexCount]);
+    std::vector<size_t> fill(offsets.begin(), offsets.end() - 1);
+    for (size_t t = 0; t < triangleCount; ++t)
+        for (int k = 0; k < 3; ++k)
+            adjacency[fill[indices[t * 3 + k]]++] = (unsigned int)t;
+
+    std::vector<size_t> stamp(vertexCount, 0);
+    std::vector<bool> emitted(triangleCount, false);
+    std::vector<unsigned int> deadEnd;     // 最近输出过的顶点（缓存断流时从这里找下一个）
+    std::vector<unsigned int> candidates;  // 本轮输出的三角形涉及的顶点
+    size_t time = cacheSize + 1;
+    size_t cursor = 0;                     // 全局扫描位置
+    int fanning = -1;
+    for (;;) {
+        if (fanning < 0) {
+            // 缓存中没有合适的顶点：先找最近输出过的顶点，再按顺序扫描全部顶点
+            while (!deadEnd.empty() && fanning < 0) {
+                unsigned int d = deadEnd.back();
+                deadEnd.pop_back();
+                if (live[d] > 0)
+                    fanning = (int)d;
+            }
+            while (fanning < 0 && cursor < vertexCount) {
+                if (live[cursor] > 0)
+                    fanning = (int)cursor;
+                ++cursor;
+            }
+            if (fanning < 0)
+                break;
+            // 这里开始新的一簇
+            if (clusters)
+                clusters->push_back(result.size() / 3);
+        }
+        // 输出围绕 fanning 的所有三角形
+        candidates.clear();
+        for (size_t a = offsets[fanning]; a < offsets[fanning + 1]; ++a) {
+            unsigned int t = adjacency[a];
+            if (emitted[t])
+                continue;
+            emitted[t] = true;
+            for (int k = 0; k < 3; ++k) {
+                unsigned int v = indices[t * 3 + k];
+                result.push_back(v);
+                deadEnd.push_back(v);
+                candidates.push_back(v);
+                --live[v];
+                if (time - stamp[v] > cacheSize)
+                    stamp[v] = time++;
+            }
+        }
+        // 下一个顶点：仍在缓存中、并且输出它剩下的三角形后仍不会被挤出缓存的顶点里，在缓存中最久的优先；
+        // 没有这样的顶点时回到断流处理
+        int best = -1;
+        size_t bestPriority = 0;
+        for (size_t c = 0; c < candidates.size(); ++c) {
+            unsigned int v = candidates[c];
+            if (live[v] == 0)
+                continue;
+            size_t priority = 0;
+            if (time - stamp[v] + 2 * live[v] <= cacheSize)
+                priority = time - stamp[v];
+            if (priority > bestPriority) {
+                best = (int)v;
+                bestPriority = priority;
+            }
+        }
+        fanning = best;
+    }
+    return result;
+}
+
+// 过度绘制优化：按 clusters 切分后把朝外的簇排在前面（Sander 等，2007 的线性时间版本）
+// clusters 一般来自 OptimizeVertexCache，簇内 ACMR 足够低时会进一步切小
+inline void OptimizeOverdraw(std::vector<unsigned int> &indices, const std::vector<Vertex> &vertices,
+                             const std::vector<size_t> &clusters,
+                             unsigned int cacheSize = MESH_OPTIMIZER_CACHE_SIZE,
+                             double threshold = MESH_OPTIMIZER_OVERDRAW_THRESHOLD) {
+    size_t triangleCount = indices.size() / 3;
+    if (triangleCount == 0 || clusters.empty())
+        return;
+    // 细分簇：从簇起点开始（缓存清空）累计未命中数，ACMR 降到 阈值 × 整体 ACMR 以下就在这里切开，
+    // 这样即使重排后每一簇都从空缓存开始，整体 ACMR 也大致不超过 阈值 × 原来的 ACMR
+    double limit = AnalyzeVertexCache(indices, vertices.size(), cacheSize).acmr() * threshold;
+    std::vector<size_t> starts;
+    std::vector<size_t> stamp(vertices.size(), 0);
+    size_t time = cacheSize + 1;
+    for (size_t c = 0; c < clusters.size(); ++c) {
+        size_t end = c + 1 < clusters.size() ? clusters[c + 1] : triangleCount;
+        size_t start = clusters[c];
+        size_t misses = 0;
+        starts.push_back(start);
+        time += cacheSize + 1;
+        for (size_t t = clusters[c]; t < end; ++t) {
+            for (int k = 0; k < 3; ++k) {
+                unsigned int v = indices[t * 3 + k];
+                if (time - stamp[v] > cacheSize) {
+                    stamp[v] = time++;
+                    ++misses;
+                }
+            }
+            if (t + 1 < end && (double)misses / (t + 1 - start) <= limit) {
+                start = t + 1;
+                misses = 0;
+                starts.push_back(start);
+                time += cacheSize + 1;
+            }
+        }
+    }
+    // 整个网格的中心（按面积加权）
+    glm::vec3 meshCenter(0.0f);
+    float meshArea = 0.0f;
+    std::vector<glm::vec3> centers(starts.size(), glm::vec3(0.0f));
+    std::vector<glm::vec3> normals(starts.size(), glm::vec3(0.0f));
+    std::vector<float> areas(starts.size(), 0.0f);
+    for (size_t c = 0; c < starts.size(); ++c) {
+        size_t end = c + 1 < starts.size() ? starts[c + 1] : triangleCount;
+        for (size_t t = starts[c]; t < end; ++t) {
+            const glm::vec3 &p0 = vertices[indices[t * 3 + 0]].Position;
+            const glm::vec3 &p1 = vertices[indices[t * 3 + 1]].Position;
+            const glm::vec3 &p2 = vertices[indices[t * 3 + 2]].Position;
+            glm::vec3 e1 = p1 - p0, e2 = p2 - p0;
+            glm::vec3 n(e1.y * e2.z - e1.z * e2.y, e1.z * e2.x - e1.x * e2.z, e1.x * e2.y - e1.y * e2.x);
+            float area = std::sqrt(n.x * n.x + n.y * n.y + n.z * n.z) * 0.5f;
+            glm::vec3 center = (p0 + p1 + p2) / 3.0f;
+            centers[c] += center * area;
+            normals[c] += n;
+            areas[c] += area;
+        }
+        meshCenter += centers[c];
+        meshArea += areas[c];
+    }
+    if (meshArea > 0.0f)
+        meshCenter = meshCenter / meshArea;
+    // 遮挡潜力：簇中心相对网格中心的偏移在簇法向量上的投影，越大越靠外
+    std::vector<std::pair<float, size_t> > order(starts.size());
+    for (size_t c = 0; c < starts.size(); ++c) {
+        glm::vec3 center = areas[c] > 0.0f ? centers[c] / areas[c] : meshCenter;
+        glm::vec3 d = center - meshCenter;
+        const glm::vec3 &n = normals[c];
+        float length = std::sqrt(n.x * n.x + n.y * n.y + n.z * n.z);
+        float potential = length > 0.0f ? (d.x * n.x + d.y * n.y + d.z * n.z) / length : 0.0f;
+        order[c] = std::make_pair(-potential, c);
+    }
+    std::stable_sort(order.begin(), order.end(),
+                     [](const std::pair<float, size_t> &a, const std::pair<float, size_t> &b) {
+                         return a.first < b.first;
+                     });
+    std::vector<unsigned int> sorted;
+    sorted.reserve(indices.size());
+    for (size_t i = 0; i < order.size(); ++i) {
+        size_t c = order[i].second;
+        size_t end = c + 1 < starts.size() ? starts[c + 1] : triangleCount;
+        sorted.insert(sorted.end(), indices.begin() + starts[c] * 3, indices.begin() + end * 3);
+    }
+    indices.swap(sorted);
+}
+
+// 按第一次被索引的顺序重排顶点（没有被引用的顶点会被丢弃），返回重排后的顶点数
+inline size_t OptimizeVertexFetch(std::vector<Vertex> &vertices, std::vector<unsigned int> &indices) {
+    std::vector<unsigned int> remap(vertices.size(), ~0u);
+    std::vector<Vertex> ordered;
+    ordered.reserve(vertices.size());
+    for (size_t i = 0; i < indices.size(); ++i) {
+        unsigned int v = indices[i];
+        if (remap[v] == ~0u) {
+            remap[v] = (unsigned int)ordered.size();
+            ordered.push_back(vertices[v]);
+        }
+        indices[i] = remap[v];
+    }
+    vertices.swap(ordered);
+    return vertices.size();
+}
+
+// 依次执行焊接、顶点缓存优化、过度绘制优化、顶点读取优化（不是三角形列表时不处理）
+inline void OptimizeMesh(std::vector<Vertex> &vertices, std::vector<unsigned int> &indices,
+                         MeshOptimizeStats *stats = NULL) {
+    MeshOptimizeStats result;
+    result.verticesBefore = vertices.size();
+    result.before = AnalyzeVertexCache(indices, vertices.size());
+    if (indices.size() % 3 == 0 && !indices.empty()) {
+        WeldVertices(vertices, indices);
+        std::vector<size_t> clusters;
+        std::vector<unsigned int> reordered = OptimizeVertexCache(indices, vertices.size(), &clusters);
+        indices.swap(reordered);
+        OptimizeOverdraw(indices, vertices, clusters);
+        OptimizeVertexFetch(vertices, indices);
+    }
+    result.verticesAfter = vertices.size();
+    result.after = AnalyzeVertexCache(indices, vertices.size());
+    if (stats)
+        stats->add(result);
+}
+
+#endif /* mesh_optimizer_h */
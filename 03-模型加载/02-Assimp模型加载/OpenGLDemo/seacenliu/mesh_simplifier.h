@@ -0,0 +1,386 @@
+//
+//  mesh_simplifier.h
+//  OpenGLDemo
+//
+//  Created by SeacenLiu on 2020/2/19.
+//  Copyright © 2020 SeacenLiu. All rights reserved.
+//
+
+/**
+ * 网格简化和 LOD 链生成
+ *
+ * 二次误差度量（Garland & Heckbert，1997）的边折叠简化：
+ * - 每个三角形所在的平面 p = (n, d) 构成二次型 K = p p^T，按面积加权累加到三个顶点上，
+ *   顶点移动到 x 的代价 x^T (ΣK) x 是到这些平面距离平方的加权和；
+ *   除以权重（面积和）得到平均距离平方，开方就是物体空间中的距离，可以直接投影到屏幕上选择 LOD
+ * - 边 (a, b) 折叠到端点 b，不产生新顶点：所有 LOD 共用原始网格的顶点，每一级只多一份索引
+ * - 边界（只属于一个三角形的边）和接缝（同一位置有多个顶点，纹理坐标或法向量不连续）上的顶点锁定不动，
+ *   模型轮廓不会收缩，贴图也不会被撕开
+ * - 每一轮按代价从小到大贪心地选出互不相邻的折叠，会让三角形法向量翻转的折叠跳过，
+ *   然后统一重写索引、去掉退化三角形，直到三角形数量达到目标或者没有可折叠的边
+ *
+ * GenerateMeshLods 连续简化到原始三角形数量的 1/2、1/4、1/8，每一级的误差都相对原始网格累计；
+ * 某一级比上一级减少的三角形不到 MESH_LOD_MIN_REDUCTION 时（大部分顶点被锁定），不再生成更粗的级别。
+ * 每一级的索引再做一次顶点缓存优化，依次追加在原始索引后面。
+ */
+#ifndef mesh_simplifier_h
+#define mesh_simplifier_h
+
+#include <cmath>
+#include <cstdint>
+#include <vector>
+#include <iostream>
+#include <algorithm>
+
+#include "mesh.h"
+#include "mesh_optimizer.h"
+
+// 每一级 LOD 的目标三角形数量相对上一级的比例
+#define MESH_LOD_RATIO 0.5
+// 相邻两级 LOD 至少要减少的三角形比例
+#define MESH_LOD_MIN_REDUCTION 0.2
+// 三角形少于这个数量的网格（或 LOD）不再简化
+#define MESH_LOD_MIN_TRIANGLES 32
+
+// 二次误差（对称矩阵的上三角部分）和累计权重
+struct Quadric {
+    double a00, a01, a02, a03, a11, a12, a13, a22, a23, a33;
+    double weight;
+
+    Quadric() : a00(0), a01(0), a02(0), a03(0), a11(0), a12(0), a13(0), a22(0), a23(0), a33(0), weight(0) {}
+    // 平面 n·x + d = 0（n 为单位向量）的二次型，乘以权重
+    Quadric(double nx, double ny, double nz, double d, double w)
+        : a00(w * nx * nx), a01(w * nx * ny), a02(w * nx * nz), a03(w * nx * d),
+          a11(w * ny * ny), a12(w * ny * nz), a13(w * ny * d),
+          a22(w * nz * nz), a23(w * nz * d), a33(w * d * d), weight(w) {}
+    void add(const Quadric &q) {
+        a00 += q.a00; a01 += q.a01; a02 += q.a02; a03 += q.a03;
+        a11 += q.a11; a12 += q.a12; a13 += q.a13;
+        a22 += q.a22; a23 += q.a23; a33 += q.a33;
+        weight += q.weight;
+    }
+    // 点到各平面距离平方的加权和
+    double evaluate(const glm::vec3 &p) const {
+        double x = p.x, y = p.y, z = p.z;
+        double e = a00 * x * x + a11 * y * y + a22 * z * z
+                 + 2.0 * (a01 * x * y + a02 * x * z + a12 * y * z)
+                 + 2.0 * (a03 * x + a13 * y + a23 * z) + a33;
+        return e > 0.0 ? e : 0.0;
+    }
+};
+
+// 增量简化器：可以多次调用 simplify，每次在上一次的结果上继续简化（二次误差持续累积）
+class MeshSimplifier {
+public:
+    MeshSimplifier(const std::vector<Vertex> &vertices, const std::vector<unsigned int> &indices)
+        : vertices(vertices), current(indices), maxCost(0.0) {
+        if (current.size() % 3 != 0)
+            current.clear();
+        setup();
+    }
+    // 继续简化到不超过 targetIndexCount 个索引（做不到时尽量接近），返回当前的索引
+    const std::vector<unsigned int> &simplify(size_t targetIndexCount) {
+        while (current.size() > targetIndexCount) {
+            if (!collapsePass(current.size() / 3 - targetIndexCount / 3))
+                break;
+        }
+        return current;
+    }
+    // 当前的索引
+    const std::vector<unsigned int> &indices() const {
+        return current;
+    }
+    // 到目前为止的最大误差（物体空间的距离）
+    float error() const {
+        return (float)std::sqrt(maxCost);
+    }
+
+private:
+    // 一次候选折叠：from 合并到 to
+    struct Collapse {
+        float cost;
+        unsigned int from, to;
+
+        bool operator<(const Collapse &other) const {
+            return cost < other.cost;
+        }
+    };
+    const std::vector<Vertex> &vertices;
+    std::vector<unsigned int> current;
+    // 每个顶点所在位置的编号（位置相同的第一个顶点），按位置编号的锁定标记和二次误差
+    std::vector<unsigned int> positionIds;
+    std::vector<unsigned char> locked;
+    std::vector<Quadric> quadrics;
+    double maxCost;
+    // 每一轮的临时数组
+    std::vector<Collapse> collapses;
+    std::vector<unsigned int> remap;
+    std::vector<unsigned char> touched;
+    std::vector<unsigned int> adjacencyOffsets, adjacency;
+
+    // 按位置焊接、锁定边界和接缝顶点、累加平面二次型
+    void setup() {
+        size_t vertexCount = vertices.size();
+        positionIds.resize(vertexCount);
+        locked.assign(vertexCount, 0);
+        quadrics.assign(vertexCount, Quadric());
+        remap.resize(vertexCount);
+        touched.resize(vertexCount);
+        // 按位置排序，相同位置的顶点编号为其中下标最小的一个；同一位置有多个顶点就是接缝
+        std::vector<unsigned int> order(vertexCount);
+        for (unsigned int i = 0; i < vertexCount; ++i)
+            order[i] = i;
+        std::sort(order.begin(), order.end(), [&](unsigned int a, unsigned int b) {
+            const glm::vec3 &p = vertices[a].Position, &q = vertices[b].Position;
+            if (p.x != q.x) return p.x < q.x;
+            if (p.y != q.y) return p.y < q.y;
+            if (p.z != q.z) return p.z < q.z;
+            return a < b;
+        });
+        for (size_t i = 0; i < vertexCount; ) {
+            size_t j = i + 1;
+            while (j < vertexCount && vertices[order[j]].Position == vertices[order[i]].Position)
+                ++j;
+            for (size_t k = i; k < j; ++k)
+                positionIds[order[k]] = order[i];
+            if (j - i > 1)
+                locked[order[i]] = 1;
+            i = j;
+        }
+        // 边界边：按位置编号只出现一次的边
+        std::vector<uint64_t> edges;
+        edges.reserve(current.size());
+        for (size_t t = 0; t + 2 < current.size(); t += 3) {
+            for (int k = 0; k < 3; ++k) {
+                uint64_t a = positionIds[current[t + k]], b = positionIds[current[t + (k + 1) % 3]];
+                if (a != b)
+                    edges.push_back(a < b ? (a << 32) | b : (b << 32) | a);
+            }
+        }
+        std::sort(edges.begin(), edges.end());
+        for (size_t i = 0; i < edges.size(); ) {
+            size_t j = i + 1;
+            while (j < edges.size() && edges[j] == edges[i])
+                ++j;
+            if (j - i == 1) {
+                locked[(unsigned int)(edges[i] >> 32)] = 1;
+                locked[(unsigned int)(edges[i] & 0xffffffffu)] = 1;
+            }
+            i = j;
+        }
+        // 三角形平面的二次型（按面积加权）
+        for (size_t t = 0; t + 2 < current.size(); t += 3) {
+            const glm::vec3 &p0 = vertices[current[t]].Position;
+            glm::vec3 e1 = vertices[current[t + 1]].Position - p0, e2 = vertices[current[t + 2]].Position - p0;
+            double nx = (double)e1.y * e2.z - (double)e1.z * e2.y;
+            double ny = (double)e1.z * e2.x - (double)e1.x * e2.z;
+            double nz = (double)e1.x * e2.y - (double)e1.y * e2.x;
+            double length = std::sqrt(nx * nx + ny * ny + nz * nz);
+            if (length <= 0.0)
+                continue;
+            nx /= length;
+            ny /= length;
+            nz /= length;
+            Quadric q(nx, ny, nz, -(nx * p0.x + ny * p0.y + nz * p0.z), length * 0.5);
+            for (int k = 0; k < 3; ++k)
+                quadrics[positionIds[current[t + k]]].add(q);
+        }
+    }
+    // 三角形的（未归一化）法向量，vertex 被替换为 position
+    glm::vec3 triangleNormal(size_t t, unsigned int vertex, const glm::vec3 &position) const {
+        glm::vec3 p[3];
+        for (int k = 0; k < 3; ++k)
+            p[k] = current[t + k] == vertex ? position : vertices[current[t + k]].Position;
+        return glm::cross(p[1] - p[0], p[2] - p[0]);
+    }
+    // 一轮折叠（最多去掉 removeGoal 个三角形），没有任何折叠时返回 false
+    bool collapsePass(size_t removeGoal) {
+        size_t vertexCount = vertices.size();
+        // 顶点到三角形的邻接表
+        adjacencyOffsets.assign(vertexCount + 1, 0);
+        for (size_t i = 0; i < current.size(); ++i)
+            ++adjacencyOffsets[current[i] + 1];
+        for (size_t v = 0; v < vertexCount; ++v)
+            adjacencyOffsets[v + 1] += adjacencyOffsets[v];
+        adjacency.resize(current.size());
+        {
+            std::vector<unsigned int> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+            for (size_t i = 0; i < current.size(); ++i)
+                adjacency[fill[current[i]]++] = (unsigned int)(i / 3 * 3);
+        }
+        // 候选折叠：未锁定的端点合并到另一个端点（未锁定的顶点位置唯一，位置编号就是它自己）
+        collapses.clear();
+        for (size_t t = 0; t + 2 < current.size(); t += 3) {
+            for (int k = 0; k < 3; ++k) {
+                unsigned int a = current[t + k], b = current[t + (k + 1) % 3];
+                addCollapse(a, b);
+                addCollapse(b, a);
+            }
+        }
+        if (collapses.empty())
+            return false;
+        std::sort(collapses.begin(), collapses.end());
+        // 贪心选择互不相邻的折叠
+        for (size_t v = 0; v < vertexCount; ++v)
+            remap[v] = (unsigned int)v;
+        std::fill(touched.begin(), touched.end(), 0);
+        size_t removed = 0, applied = 0;
+        for (size_t c = 0; c < collapses.size() && removed < removeGoal; ++c) {
+            unsigned int a = collapses[c].from, b = collapses[c].to;
+            if (touched[a])
+                continue;
+            const glm::vec3 &target = vertices[b].Position;
+            size_t degenerate = 0;
+            bool flipped = false;
+            for (unsigned int j = adjacencyOffsets[a]; j < adjacencyOffsets[a + 1] && !flipped; ++j) {
+                size_t t = adjacency[j];
+                bool shared = false;
+                for (int k = 0; k < 3; ++k)
+                    shared = shared || positionIds[current[t + k]] == positionIds[b];
+                if (shared) {
+                    ++degenerate;
+                    continue;
+                }
+                glm::vec3 before = triangleNormal(t, a, vertices[a].Position);
+                glm::vec3 after = triangleNormal(t, a, target);
+                flipped = glm::dot(before, after) <= 0.0f;
+            }
+            if (flipped)
+                continue;
+            remap[a] = b;
+            quadrics[positionIds[b]].add(quadrics[a]);
+            maxCost = std::max(maxCost, (double)collapses[c].cost);
+            removed += degenerate;
+            ++applied;
+            // 周围的顶点这一轮不再参与折叠（保证邻接表和法向量检查有效）
+            for (unsigned int j = adjacencyOffsets[a]; j < adjacencyOffsets[a + 1]; ++j) {
+                size_t t = adjacency[j];
+                for (int k = 0; k < 3; ++k)
+                    touched[current[t + k]] = 1;
+            }
+        }
+        if (applied == 0)
+            return false;
+        // 重写索引，去掉退化三角形（两个顶点位置相同）
+        size_t write = 0;
+        for (size_t t = 0; t + 2 < current.size(); t += 3) {
+            unsigned int i0 = remap[current[t]], i1 = remap[current[t + 1]], i2 = remap[current[t + 2]];
+            unsigned int p0 = positionIds[i0], p1 = positionIds[i1], p2 = positionIds[i2];
+            if (p0 == p1 || p1 == p2 || p0 == p2)
+                continue;
+            current[write++] = i0;
+            current[write++] = i1;
+            current[write++] = i2;
+        }
+        current.resize(write);
+        return true;
+    }
+    // 候选折叠 from -> to 的代价：两端二次型之和在 to 处的平均距离平方
+    void addCollapse(unsigned int from, unsigned int to) {
+        if (locked[positionIds[from]] || positionIds[from] == positionIds[to])
+            return;
+        Quadric q = quadrics[from];
+        q.add(quadrics[positionIds[to]]);
+        double cost = q.weight > 0.0 ? q.evaluate(vertices[to].Position) / q.weight : 0.0;
+        collapses.push_back(Collapse{ (float)cost, from, to });
+    }
+};
+
+// 把三角形列表简化到不超过 targetIndexCount 个索引，error 输出最大误差（物体空间的距离）
+inline std::vector<unsigned int> SimplifyMesh(const std::vector<Vertex> &vertices, const std::vector<unsigned int> &indices,
+                                              size_t targetIndexCount, float *error = NULL) {
+    MeshSimplifier simplifier(vertices, indices);
+    std::vector<unsigned int> result = simplifier.simplify(targetIndexCount);
+    if (error)
+        *error = simplifier.error();
+    return result;
+}
+
+// LOD 统计（可以累加得到整个模型的统计）
+struct MeshLodStats {
+    size_t meshes;                          // 网格数量
+    size_t levels[MESH_MAX_LODS];           // 至少有 i + 1 级 LOD 的网格数量
+    size_t triangles[MESH_MAX_LODS];        // 第 i 级的三角形总数（没有这一级的网格按它最粗的一级计）
+    float maxError[MESH_MAX_LODS];          // 第 i 级的最大误差
+    size_t extraIndices;                    // LOD 额外占用的索引数量
+
+    MeshLodStats() : meshes(0), extraIndices(0) {
+        for (int i = 0; i < MESH_MAX_LODS; ++i) {
+            levels[i] = triangles[i] = 0;
+            maxError[i] = 0.0f;
+        }
+    }
+    void add(const MeshLod *lods, unsigned int lodCount) {
+        if (lodCount == 0)
+            return;
+        ++meshes;
+        for (unsigned int i = 0; i < MESH_MAX_LODS; ++i) {
+            const MeshLod &lod = lods[std::min(i, lodCount - 1)];
+            triangles[i] += lod.indexCount / 3;
+            if (i < lodCount) {
+                ++levels[i];
+                maxError[i] = std::max(maxError[i], lod.error);
+                if (i > 0)
+                    extraIndices += lod.indexCount;
+            }
+        }
+    }
+    void print() const {
+        std::cout << "LOD:";
+        for (int i = 0; i < MESH_MAX_LODS; ++i)
+            std::cout << " 第 " << i << " 级 " << triangles[i] << " 个三角形 (" << levels[i] << " 个网格, 误差 "
+                      << maxError[i] << ")" << (i + 1 < MESH_MAX_LODS ? "," : "");
+        std::cout << ", 额外索引 " << extraIndices << std::endl;
+    }
+};
+
+// LOD 绘制统计（可以累加多次绘制）
+struct LodDrawStats {
+    unsigned long meshes[MESH_MAX_LODS];    // 用第 i 级绘制的网格数量
+    unsigned long triangles;                // 实际提交的三角形
+    unsigned long fullTriangles;            // 全部使用原始网格时的三角形
+
+    LodDrawStats() : triangles(0), fullTriangles(0) {
+        for (int i = 0; i < MESH_MAX_LODS; ++i)
+            meshes[i] = 0;
+    }
+    void add(unsigned int level, unsigned long levelTriangles, unsigned long originalTriangles) {
+        ++meshes[level];
+        triangles += levelTriangles;
+        fullTriangles += originalTriangles;
+    }
+    void add(const LodDrawStats &other) {
+        for (int i = 0; i < MESH_MAX_LODS; ++i)
+            meshes[i] += other.meshes[i];
+        triangles += other.triangles;
+        fullTriangles += other.fullTriangles;
+    }
+};
+
+// 生成 LOD 链：indices 为原始网格（第 0 级），简化后的各级索引追加在后面，lods 输出各级的范围和误差，
+// 返回级数（至少为 1）
+inline unsigned int GenerateMeshLods(const std::vector<Vertex> &vertices, std::vector<unsigned int> &indices,
+                                     MeshLod lods[MESH_MAX_LODS], MeshLodStats *stats = NULL) {
+    size_t baseCount = indices.size();
+    lods[0] = MeshLod{ 0, (uint32_t)baseCount, 0.0f };
+    unsigned int lodCount = 1;
+    if (baseCount % 3 == 0 && baseCount / 3 >= MESH_LOD_MIN_TRIANGLES) {
+        MeshSimplifier simplifier(vertices, indices);
+        size_t previous = baseCount;
+        while (lodCount < MESH_MAX_LODS && previous / 3 >= MESH_LOD_MIN_TRIANGLES) {
+            size_t target = (size_t)(previous / 3 * MESH_LOD_RATIO) * 3;
+            const std::vector<unsigned int> &simplified = simplifier.simplify(target);
+            if (simplified.empty() || (double)simplified.size() > previous * (1.0 - MESH_LOD_MIN_REDUCTION))
+                break;
+            std::vector<unsigned int> reordered = OptimizeVertexCache(simplified, vertices.size());
+            lods[lodCount++] = MeshLod{ (uint32_t)indices.size(), (uint32_t)reordered.size(), simplifier.error() };
+            indices.insert(indices.end(), reordered.begin(), reordered.end());
+            previous = reordered.size();
+        }
+    }
+    if (stats)
+        stats->add(lods, lodCount);
+    return lodCount;
+}
+
+#endif /* mesh_simplifier_h */
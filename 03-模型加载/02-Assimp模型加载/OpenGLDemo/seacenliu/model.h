@@ -10,6 +10,12 @@
 #define model_h
 
 #include "mesh.h"
+#include "mesh_cache.h"
+#include "mesh_optimizer.h"
+#include "mesh_simplifier.h"
+#include "bvh.h"
+#include "occlusion_culler.h"
+#include "profiler.h"
 
 // assimp 头文件
 #include <assimp/Importer.hpp>
@@ -19,28 +25,264 @@
 // stb_image 头文件
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb_image.h"
+#include "texture_loader.h"
+#include "texture_streamer.h"
 unsigned int TextureFromFile(const char *path, const string &directory, bool gamma = false);
 
+// Assimp 后期处理选项（写入网格缓存，修改后旧缓存自动失效）
+#define MODEL_IMPORT_FLAGS (aiProcess_Triangulate | aiProcess_FlipUVs)
+// LOD 选择的默认阈值：简化误差投影到屏幕上不超过这么多像素
+#define MODEL_LOD_PIXEL_ERROR 1.0f
+
 class Model {
 public:
-    // 构造函数
-    Model(char *path) {
+    // 是否从网格缓存（.meshbin）加载
+    bool loadedFromCache = false;
+    // 纹理加载器（记录每个纹理的解码、上传耗时）
+    TextureLoader textureLoader;
+    // 导入时网格优化的统计（从网格缓存加载时为空，缓存中已经是优化后的数据）
+    MeshOptimizeStats optimizeStats;
+    // 构造函数（keepCPUData 为 true 时上传后保留 CPU 端的顶点和索引数据，例如用于拾取；
+    // vertexFormat 为显存中的顶点格式，网格缓存中始终保存完整格式；
+    // 指定 streamer 时纹理交给它在之后的帧中逐步上传，构造函数不等待纹理）
+    Model(const char *path, bool keepCPUData = false, VertexFormat vertexFormat = VERTEX_FORMAT_COMPACT,
+          TextureStreamer *streamer = NULL)
+        : keepCPUData(keepCPUData), vertexFormat(vertexFormat), streamer(streamer) {
         loadModel(path);
     }
-    // 绘制函数
-    void Draw(Shader shader) {
+    // 绘制函数：只绑定一次 VAO，材质相同的网格用一次 glMultiDrawElementsBaseVertex 绘制
+    void Draw(const Shader &shader) {
+        static const unsigned int zoneDraw = Profiler::instance().zone("Model::Draw");
+        ProfileScope scope(zoneDraw);
+        arena.bind(shader);
+        for (unsigned int i = 0; i < batches.size(); ++i) {
+            const DrawBatch &batch = batches[i];
+            meshes[batch.mesh].material.bind(shader);
+            glMultiDrawElementsBaseVertex(GL_TRIANGLES, batch.counts.data(), arena.report.indexType,
+                                          batch.offsets.data(), (GLsizei)batch.counts.size(),
+                                          batch.baseVertices.data());
+        }
+    }
+    // 带视锥体剔除的绘制：frustum 为物体空间的视锥体（用这个模型的 MVP 矩阵构造），
+    // 通过网格 BVH 查询可见网格，包围盒完全在视锥体外的网格不提交，批次中的网格全部被剔除时连材质也不绑定
+    void Draw(const Shader &shader, const Frustum &frustum) {
+        static const unsigned int zoneDraw = Profiler::instance().zone("Model::Draw");
+        ProfileScope scope(zoneDraw);
+        cullMeshes(frustum);
+        drawVisible(shader);
+    }
+    // 带视锥体剔除和遮挡剔除的绘制（mvp 为这个模型的 MVP 矩阵）：
+    // 上次查询没有被遮挡的网格先合并绘制写入深度，然后对视锥体内的网格画包围盒发出遮挡查询，
+    // 处于遮挡状态的网格最后逐个用条件渲染绘制（GPU 根据刚发出的查询决定是否执行，不等待 CPU）
+    void Draw(const Shader &shader, const glm::mat4 &mvp, OcclusionCuller &occlusion) {
+        static const unsigned int zoneDraw = Profiler::instance().zone("Model::Draw");
+        ProfileScope scope(zoneDraw);
+        Frustum frustum(mvp);
+        cullMeshes(frustum);
+        occlusion.update(meshes.size());
+        // 分出处于遮挡状态的网格；视锥体外和与近平面相交（查询不可靠）的网格重置为可见
+        const glm::vec4 &nearPlane = frustum.planes[Frustum::PLANE_NEAR];
+        occludedMeshes.clear();
+        queryMeshes.clear();
+        for (unsigned int i = 0; i < meshes.size(); ++i) {
+            if (!visibility[i]) {
+                occlusion.reset(i);
+                continue;
+            }
+            glm::vec3 c = meshBounds[i].center(), e = meshBounds[i].extent();
+            float distance = nearPlane.x * c.x + nearPlane.y * c.y + nearPlane.z * c.z + nearPlane.w;
+            float radius = std::fabs(nearPlane.x) * e.x + std::fabs(nearPlane.y) * e.y + std::fabs(nearPlane.z) * e.z;
+            if (distance - radius < 0.0f) {
+                occlusion.reset(i);
+                continue;
+            }
+            queryMeshes.push_back(i);
+            if (occlusion.occluded(i)) {
+                visibility[i] = 0;
+                occludedMeshes.push_back(i);
+            }
+        }
+        drawVisible(shader);
+        // 包围盒查询（在可见网格写入深度之后）
+        occlusion.beginQueries(mvp);
+        for (unsigned int i = 0; i < queryMeshes.size(); ++i)
+            occlusion.query(queryMeshes[i], meshBounds[queryMeshes[i]]);
+        occlusion.endQueries();
+        // 被遮挡的网格用条件渲染绘制
+        if (occludedMeshes.empty())
+            return;
+        GLState::instance().useProgram(shader.ID);
+        arena.bind(shader);
+        for (unsigned int i = 0; i < occludedMeshes.size(); ++i) {
+            occlusion.beginConditional(occludedMeshes[i]);
+            const Mesh &mesh = meshes[occludedMeshes[i]];
+            unsigned int level = lodLevels[occludedMeshes[i]];
+            meshes[occludedMeshes[i]].Draw(shader, level);
+            ++drawCalls;
+            lodStats.add(level, mesh.lodIndexCount(level) / 3, mesh.range.indexCount / 3);
+            occlusion.endConditional();
+        }
+    }
+    // 最近一次剔除的可见、剔除网格数量
+    CullStats lastCullStats() const {
+        return cullStats;
+    }
+    // 按屏幕空间误差选择每个网格的 LOD（之后带剔除的 Draw 使用选中的级别）：
+    // 网格简化误差乘以模型矩阵的最大缩放，除以相机到网格包围盒的距离，再乘以 viewportHeight / (2 tan(fovy / 2))
+    // 得到投影到屏幕上的像素数，选择不超过 pixelError 的最粗一级；相机在包围盒内时使用原始网格。
+    // fovy 为相机的视野（Camera::Zoom，角度），pixelError 为 0 时始终使用原始网格
+    void selectLod(const glm::mat4 &model, const glm::vec3 &cameraPosition, float fovy, float viewportHeight,
+                   float pixelError = MODEL_LOD_PIXEL_ERROR) {
+        float scale = 0.0f;
+        for (int c = 0; c < 3; ++c)
+            scale = std::max(scale, glm::length(glm::vec3(model[c])));
+        float pixelsPerUnit = viewportHeight / (2.0f * std::tan(glm::radians(fovy) * 0.5f));
+        for (unsigned int i = 0; i < meshes.size(); ++i) {
+            const Mesh &mesh = meshes[i];
+            lodLevels[i] = 0;
+            if (mesh.lodCount <= 1 || pixelError <= 0.0f)
+                continue;
+            AABB box = TransformAABB(meshBounds[i], model);
+            glm::vec3 offset;
+            for (int k = 0; k < 3; ++k)
+                offset[k] = std::max(std::max(box.min[k] - cameraPosition[k], cameraPosition[k] - box.max[k]), 0.0f);
+            float distance = glm::length(offset);
+            if (distance <= 0.0f)
+                continue;
+            float errorToPixels = scale / distance * pixelsPerUnit;
+            for (unsigned int level = mesh.lodCount - 1; level > 0; --level) {
+                if (mesh.lods[level].error * errorToPixels <= pixelError) {
+                    lodLevels[i] = (unsigned char)level;
+                    break;
+                }
+            }
+        }
+    }
+    // 最近一次带剔除的绘制中每一级 LOD 的网格数量和三角形数量
+    const LodDrawStats &lastLodStats() const {
+        return lodStats;
+    }
+    // 最近一次带剔除的绘制实际提交的绘制调用次数（全部被剔除的批次不提交，条件渲染的网格各算一次）
+    unsigned long lastDrawCalls() const {
+        return drawCalls;
+    }
+    // 导入时生成的 LOD 链统计
+    MeshLodStats lodChainStats() const {
+        MeshLodStats stats;
+        for (unsigned int i = 0; i < meshes.size(); ++i)
+            stats.add(meshes[i].lods, meshes[i].lodCount);
+        return stats;
+    }
+    // 射线拾取：ray 为物体空间的射线（用 ScreenRay 和这个模型的 MVP 矩阵生成），
+    // 返回最近的命中网格（没有命中返回 -1），distance 为命中点的射线参数。
+    // 保留了 CPU 端数据时精确到三角形（原始网格），否则只能精确到网格的包围盒
+    int pick(const Ray &ray, float &distance) const {
+        distance = FLT_MAX;
+        return meshTree.intersect(ray, distance, [&](unsigned int index, float &tMax) {
+            const Mesh &mesh = meshes[index];
+            if (mesh.indices.empty()) {
+                float t;
+                if (!IntersectAABB(ray, mesh.bounds.min, mesh.bounds.max, tMax, t) || t >= tMax)
+                    return false;
+                tMax = t;
+                return true;
+            }
+            bool hit = false;
+            size_t indexCount = std::min(mesh.indices.size(), (size_t)mesh.lods[0].indexCount);
+            for (size_t i = 0; i + 2 < indexCount; i += 3) {
+                float t;
+                if (IntersectTriangle(ray, mesh.vertices[mesh.indices[i]].Position,
+                                      mesh.vertices[mesh.indices[i + 1]].Position,
+                                      mesh.vertices[mesh.indices[i + 2]].Position, tMax, t)) {
+                    tMax = t;
+                    hit = true;
+                }
+            }
+            return hit;
+        });
+    }
+    // 整个模型在物体空间的包围盒
+    AABB bounds() const {
+        AABB box;
+        for (unsigned int i = 0; i < meshes.size(); ++i)
+            box.expand(meshes[i].bounds);
+        return box;
+    }
+    // 释放 OpenGL 资源
+    void release() {
+        arena.release();
+    }
+    // 网格数量
+    size_t meshCount() const {
+        return meshes.size();
+    }
+    // 每帧的绘制调用次数（合并后的批次数量）
+    size_t drawCallCount() const {
+        return batches.size();
+    }
+    // 顶点格式、显存数据量和量化误差
+    const VertexFormatReport &vertexReport() const {
+        return arena.report;
+    }
+    // CPU 端保留的顶点和索引数据（字节）
+    size_t cpuBytes() const {
+        size_t bytes = 0;
         for (unsigned int i = 0; i < meshes.size(); ++i)
-            meshes[i].Draw(shader);
+            bytes += meshes[i].cpuBytes();
+        return bytes;
     }
 private:
+    // 合并绘制批次（材质相同的网格）
+    struct DrawBatch {
+        unsigned int mesh;                  // 提供材质的网格
+        vector<unsigned int> meshes;        // 批次中的网格（剔除时使用）
+        vector<GLsizei> counts;             // 每个网格的索引数量
+        vector<const void *> offsets;       // 每个网格第一个索引的字节偏移
+        vector<GLint> baseVertices;         // 每个网格的基础顶点
+    };
     // 网格数据
     vector<Mesh> meshes;
-    // 已加载的纹理数据
-    vector<Texture> textures_loaded;
+    // 所有网格共用的顶点/索引缓冲
+    MeshArena arena;
+    // 绘制批次
+    vector<DrawBatch> batches;
+    // 网格包围盒（与 meshes 下标一致）、网格 BVH 和剔除结果
+    vector<AABB> meshBounds;
+    BVH meshTree;
+    vector<unsigned int> visibleMeshes;
+    vector<unsigned char> visibility;
+    // 遮挡剔除时要查询的网格和处于遮挡状态的网格
+    vector<unsigned int> queryMeshes;
+    vector<unsigned int> occludedMeshes;
+    CullStats cullStats = CullStats{ 0, 0 };
+    // 每个网格选中的 LOD 级别和绘制统计
+    vector<unsigned char> lodLevels;
+    LodDrawStats lodStats;
+    unsigned long drawCalls = 0;
+    // 剔除后每个批次的绘制参数（按最大批次预留）
+    vector<GLsizei> visibleCounts;
+    vector<const void *> visibleOffsets;
+    vector<GLint> visibleBaseVertices;
+    // 是否保留 CPU 端的网格数据
+    bool keepCPUData;
+    // 显存中的顶点格式
+    VertexFormat vertexFormat;
+    // 纹理流式加载（为空时在构造函数中用 textureLoader 一次性加载）
+    TextureStreamer *streamer;
     // 模型路径
     string directory;
     // 加载模型函数
-    void loadModel(string path) {
+    void loadModel(const string &path) {
+        // 配置文件路径
+        directory = path.substr(0, path.find_last_of('/'));
+        // 优先使用网格缓存（源文件没有变化时跳过 Assimp 解析）
+        string cachePath = path + ".meshbin";
+        uint64_t sourceHash = MeshCacheSourceHash(path);
+        if (sourceHash != 0 && loadCache(cachePath, sourceHash)) {
+            textureLoader.finish();
+            buildBatches();
+            return;
+        }
         // 使用 assimp 读入场景数据
         Assimp::Importer importer;
         // Post-processing(后期处理)
@@ -50,18 +292,151 @@ private:
         // - aiProcess_SplitLargeMeshes: 将比较大的网格分割成更小的子网格，用于减少单个网格的顶点数
         // - aiProcess_OptimizeMeshes: 将多个小网格拼接为一个大的网格，减少绘制调用从而进行优化
         // - aiProcess_CalcTangentSpace:
-        const aiScene* scene = importer.ReadFile(path, aiProcess_Triangulate | aiProcess_FlipUVs);
+        const aiScene* scene = importer.ReadFile(path, MODEL_IMPORT_FLAGS);
         if(!scene                                        // Scene 是否为空
            || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE  // 场景是否加载完毕
            || !scene->mRootNode) {                       // 是否存在根结点
             cout << "ERROR::ASSIMP::" << importer.GetErrorString() << endl;
             return;
         }
-        // 配置文件路径
-        directory = path.substr(0, path.find_last_of('/'));
-        // 递归处理结点
+        // 递归处理结点（只登记纹理，不解码）
+        meshes.reserve(scene->mNumMeshes);
         processNode(scene->mRootNode, scene);
-        
+        // 所有网格写入共享缓冲
+        size_t vertexTotal = 0, indexTotal = 0, largestMesh = 0;
+        AABB bounds;
+        for (unsigned int i = 0; i < meshes.size(); ++i) {
+            vertexTotal += meshes[i].vertices.size();
+            indexTotal += meshes[i].indices.size();
+            largestMesh = std::max(largestMesh, meshes[i].vertices.size());
+            bounds.expand(meshes[i].bounds);
+        }
+        allocateArena(vertexTotal, indexTotal, largestMesh, bounds);
+        for (unsigned int i = 0; i < meshes.size(); ++i)
+            meshes[i].upload(arena);
+        buildBatches();
+        // 并行解码并上传所有纹理
+        textureLoader.finish();
+        // 写入网格缓存，下次启动直接映射
+        if (sourceHash != 0 && !WriteMeshCache(cachePath, sourceHash, MODEL_IMPORT_FLAGS, meshes))
+            cout << "WARNING::MESHBIN::failed to write " << cachePath << endl;
+        // 缓存写完后 CPU 端数据不再需要
+        if (!keepCPUData) {
+            for (unsigned int i = 0; i < meshes.size(); ++i)
+                meshes[i].releaseCPUData();
+        }
+    }
+    // 从网格缓存加载（缓存不存在或已失效时返回 false）
+    bool loadCache(const string &cachePath, uint64_t sourceHash) {
+        MeshCacheReader cache;
+        if (!cache.open(cachePath, sourceHash, MODEL_IMPORT_FLAGS))
+            return false;
+        const MeshBinHeader &header = cache.header();
+        size_t vertexTotal = 0, indexTotal = 0, largestMesh = 0;
+        AABB bounds;
+        for (unsigned int i = 0; i < header.meshCount; ++i) {
+            vertexTotal += cache.mesh(i).vertexCount;
+            indexTotal += cache.mesh(i).indexCount;
+            largestMesh = std::max(largestMesh, (size_t)cache.mesh(i).vertexCount);
+            bounds.expand(MeshBounds(cache.vertices(i), cache.mesh(i).vertexCount));
+        }
+        allocateArena(vertexTotal, indexTotal, largestMesh, bounds);
+        meshes.reserve(header.meshCount);
+        for (unsigned int i = 0; i < header.meshCount; ++i) {
+            const MeshBinMesh &record = cache.mesh(i);
+            vector<Texture> textures;
+            for (unsigned int j = 0; j < record.textureCount; ++j) {
+                const MeshBinTexture &ref = cache.texture(record.textureFirst + j);
+                textures.push_back(loadTexture(ref.path, ref.type));
+            }
+            meshes.push_back(Mesh(arena, cache.vertices(i), record.vertexCount,
+                                  cache.indices(i), record.indexCount,
+                                  std::move(textures), keepCPUData,
+                                  record.lods, record.lodCount));
+        }
+        loadedFromCache = true;
+        return true;
+    }
+    // 分配共享缓冲：紧凑格式按整个模型的包围盒量化（所有网格共用一组反量化参数，才能合并绘制），
+    // 每个网格的顶点数都不超过 65536 时使用 16 位索引（索引相对各自的基础顶点）
+    void allocateArena(size_t vertexTotal, size_t indexTotal, size_t largestMesh, const AABB &bounds) {
+        GLenum indexType = largestMesh <= 65536 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+        arena.allocate(vertexTotal, indexTotal, vertexFormat, indexType, bounds);
+    }
+    // 按材质把网格分组成绘制批次（同一批次只绑定一次纹理）
+    void buildBatches() {
+        batches.clear();
+        for (unsigned int i = 0; i < meshes.size(); ++i) {
+            const MeshRange &range = meshes[i].range;
+            if (range.indexCount == 0)
+                continue;
+            unsigned int b = 0;
+            while (b < batches.size() && !meshes[batches[b].mesh].material.sameBindings(meshes[i].material))
+                ++b;
+            if (b == batches.size()) {
+                batches.push_back(DrawBatch());
+                batches.back().mesh = i;
+            }
+            batches[b].meshes.push_back(i);
+            batches[b].counts.push_back(range.indexCount);
+            batches[b].offsets.push_back((const void *)range.indexOffset);
+            batches[b].baseVertices.push_back(range.baseVertex);
+        }
+        // 剔除、拾取用的 BVH 和临时数组
+        meshBounds.resize(meshes.size());
+        for (unsigned int i = 0; i < meshes.size(); ++i)
+            meshBounds[i] = meshes[i].bounds;
+        meshTree.build(meshBounds);
+        visibleMeshes.reserve(meshes.size());
+        queryMeshes.reserve(meshes.size());
+        occludedMeshes.reserve(meshes.size());
+        visibility.resize(meshes.size());
+        lodLevels.assign(meshes.size(), 0);
+        size_t largest = 0;
+        for (unsigned int b = 0; b < batches.size(); ++b)
+            largest = std::max(largest, batches[b].counts.size());
+        visibleCounts.reserve(largest);
+        visibleOffsets.reserve(largest);
+        visibleBaseVertices.reserve(largest);
+    }
+    // 视锥体剔除：visibility[i] 为 1 表示网格 i 可见
+    void cullMeshes(const Frustum &frustum) {
+        visibleMeshes.clear();
+        size_t visibleCount = meshTree.query(frustum, meshBounds, visibleMeshes);
+        std::fill(visibility.begin(), visibility.end(), 0);
+        for (unsigned int i = 0; i < visibleMeshes.size(); ++i)
+            visibility[visibleMeshes[i]] = 1;
+        cullStats = CullStats{ visibleCount, meshBounds.size() - visibleCount };
+    }
+    // 按批次合并绘制 visibility 中可见的网格（使用 selectLod 选中的级别）
+    void drawVisible(const Shader &shader) {
+        lodStats = LodDrawStats();
+        drawCalls = 0;
+        arena.bind(shader);
+        for (unsigned int i = 0; i < batches.size(); ++i) {
+            const DrawBatch &batch = batches[i];
+            // 可见网格写入预留好的临时数组（不分配内存）
+            visibleCounts.clear();
+            visibleOffsets.clear();
+            visibleBaseVertices.clear();
+            for (unsigned int j = 0; j < batch.meshes.size(); ++j) {
+                if (!visibility[batch.meshes[j]])
+                    continue;
+                const Mesh &mesh = meshes[batch.meshes[j]];
+                unsigned int level = lodLevels[batch.meshes[j]];
+                visibleCounts.push_back(mesh.lodIndexCount(level));
+                visibleOffsets.push_back(mesh.lodIndexOffset(level));
+                visibleBaseVertices.push_back(batch.baseVertices[j]);
+                lodStats.add(level, mesh.lodIndexCount(level) / 3, batch.counts[j] / 3);
+            }
+            if (visibleCounts.empty())
+                continue;
+            meshes[batch.mesh].material.bind(shader);
+            glMultiDrawElementsBaseVertex(GL_TRIANGLES, visibleCounts.data(), arena.report.indexType,
+                                          visibleOffsets.data(), (GLsizei)visibleCounts.size(),
+                                          visibleBaseVertices.data());
+            ++drawCalls;
+        }
     }
     // 处理结点
     void processNode(aiNode *node, const aiScene *scene) {
@@ -81,6 +456,9 @@ private:
         vector<Vertex> vertices;      // 顶点数据
         vector<unsigned int> indices; // 网格索引数据
         vector<Texture> textures;     // 纹理数据
+        // 按顶点数、面数预留空间（经过 aiProcess_Triangulate，每个面 3 个索引）
+        vertices.reserve(mesh->mNumVertices);
+        indices.reserve(mesh->mNumFaces * 3);
 
         // 处理顶点
         for(unsigned int i = 0; i < mesh->mNumVertices; ++i) {
@@ -110,7 +488,7 @@ private:
         
         // 处理索引
         for (unsigned int i = 0; i < mesh->mNumFaces; ++i) {
-            aiFace face = mesh->mFaces[i];
+            const aiFace &face = mesh->mFaces[i];
             for(unsigned int j = 0; j < face.mNumIndices; ++j)
                 indices.push_back(face.mIndices[j]);
         }
@@ -122,45 +500,60 @@ private:
             vector<Texture> diffuseMaps = loadMaterialTextures(material,
                                                                aiTextureType_DIFFUSE,
                                                                "texture_diffuse");
-            textures.insert(textures.end(), diffuseMaps.begin(), diffuseMaps.end());
+            textures.insert(textures.end(),
+                            make_move_iterator(diffuseMaps.begin()),
+                            make_move_iterator(diffuseMaps.end()));
             // 镜面光照材质
             vector<Texture> specularMaps = loadMaterialTextures(material,
                                                                 aiTextureType_SPECULAR,
                                                                 "texture_specular");
-            textures.insert(textures.end(), specularMaps.begin(), specularMaps.end());
+            textures.insert(textures.end(),
+                            make_move_iterator(specularMaps.begin()),
+                            make_move_iterator(specularMaps.end()));
         }
 
-        return Mesh(vertices, indices, textures);
+        // 焊接重复顶点，按顶点缓存、过度绘制、顶点读取顺序重排
+        OptimizeMesh(vertices, indices, &optimizeStats);
+        // 生成 LOD 链（简化后的索引追加在原始索引后面）
+        MeshLod lods[MESH_MAX_LODS];
+        unsigned int lodCount = GenerateMeshLods(vertices, indices, lods);
+
+        // 顶点、索引、纹理数据直接移交给网格
+        Mesh result(std::move(vertices), std::move(indices), std::move(textures));
+        result.setLods(lods, lodCount);
+        return result;
     }
     
     // 加载材质
     vector<Texture> loadMaterialTextures(aiMaterial *mat,
                                          aiTextureType type,
-                                         string typeName) {
+                                         const string &typeName) {
         vector<Texture> textures;
+        textures.reserve(mat->GetTextureCount(type));
         for (unsigned int i = 0; i < mat->GetTextureCount(type); ++i) {
             aiString str;
             mat->GetTexture(type, i, &str);
-            bool skip = false;
-            // 防止重复加载相同纹理
-            for (unsigned int j = 0; j < textures_loaded.size(); ++j) {
-                if (std::strcmp(textures_loaded[j].path.data, str.C_Str()) == 0) {
-                    textures.push_back(textures_loaded[j]);
-                    skip = true;
-                    break;
-                }
-            }
-            if (!skip) { // 如果纹理还没有被加载，则加载它
-                Texture texture;
-                texture.id   = TextureFromFile(str.C_Str(), directory);
-                texture.type = typeName;
-                texture.path = str.C_Str();
-                textures.push_back(texture);
-                textures_loaded.push_back(texture); // 添加到已加载的纹理中
-            }
+            textures.push_back(loadTexture(str.C_Str(), typeName));
         }
         return textures;
     }
+    // 加载纹理
+    Texture loadTexture(const char *path, const string &typeName) {
+        // 通过进程级纹理缓存防止重复加载（多个网格、多个模型共享同一纹理）
+        string filename = directory + '/' + path;
+        bool created = false;
+        Texture texture;
+        texture.handle = TextureCache::instance().acquire(filename, &created);
+        texture.id   = texture.handle.id();
+        texture.type = typeName;
+        texture.path = path;
+        // 如果纹理还没有被加载，则交给加载器解码上传（或者交给流式加载）
+        if (created && streamer)
+            streamer->add(filename, texture.id);
+        else if (created)
+            textureLoader.add(filename, texture.id);
+        return texture;
+    }
 };
 
 unsigned int TextureFromFile(const char *path,
@@ -172,42 +565,19 @@ unsigned int TextureFromFile(const char *path,
     // 创建纹理对象
     unsigned int textureID;
     glGenTextures(1, &textureID);
+    // 有离线转换好的压缩纹理时直接上传压缩块和 mipmap
+    KtxTexture compressed;
+    if (TextureLoader::useCompressed() && KtxUpToDate(filename)
+        && ReadKtx(KtxPath(filename), compressed) && KtxSupported(compressed.internalFormat)) {
+        UploadKtxTexture(textureID, compressed);
+        return textureID;
+    }
     // 加载纹理文件
     int width, height, nrComponents; // 宽度、高度、颜色通道数
     unsigned char *data = stbi_load(filename.c_str(), &width, &height, &nrComponents, 0);
     if (data) {
-        // 配置存储格式
-        GLenum format;
-        if (nrComponents == 1)
-            format = GL_RED;
-        else if (nrComponents == 3)
-            format = GL_RGB;
-        else if (nrComponents == 4)
-            format = GL_RGBA;
-        else
-            format = GL_RGBA;
-        
-        // 绑定当前纹理
-        glBindTexture(GL_TEXTURE_2D, textureID);
-        // 创建2D纹理
-        glTexImage2D(GL_TEXTURE_2D,     // 纹理类型
-                     0,                 // 多级渐远纹理类型
-                     format,            // 纹理存储格式
-                     width,             // 纹理宽度
-                     height,            // 纹理高度
-                     0,                 // 历史遗留参数(0即可)
-                     format,            // 源图数据格式
-                     GL_UNSIGNED_BYTE,  // 源图数据类型
-                     data);             // 源图数据
-        // 为纹理对象生成一组完整的 mipmap？
-        glGenerateMipmap(GL_TEXTURE_2D);
-        // 为当前绑定的纹理对象设置环绕模式
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-        // 为当前绑定的纹理对象设置过滤方式
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-        
+        // 上传纹理数据并生成 mipmap（与并行加载共用同一套配置）
+        UploadTexture(textureID, data, width, height, nrComponents);
         // 释放资源
         stbi_image_free(data);
     } else {
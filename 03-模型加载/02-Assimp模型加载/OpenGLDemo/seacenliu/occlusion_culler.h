@@ -0,0 +1,188 @@
+//
+//  occlusion_culler.h
+//  OpenGLDemo
+//
+//  Created by SeacenLiu on 2020/2/18.
+//  Copyright © 2020 SeacenLiu. All rights reserved.
+//
+
+/**
+ * 硬件遮挡查询 + 条件渲染
+ *
+ * 每个物体（网格）一个 GL_ANY_SAMPLES_PASSED 查询对象，每帧的流程：
+ * 1. update：读取之前发出的查询中已经有结果的（GL_QUERY_RESULT_AVAILABLE，从不等待），更新遮挡状态
+ * 2. 没有被遮挡的物体正常绘制，写入深度
+ * 3. beginQueries / query / endQueries：关闭颜色和深度写入，对视锥体内的物体画包围盒并发出查询
+ *    （上一次查询还没有结果的物体这一帧不再发出）
+ * 4. 被遮挡的物体在 beginConditional / endConditional 之间绘制：
+ *    glBeginConditionalRender 让 GPU 根据刚才的包围盒查询决定是否执行绘制，CPU 不需要等待结果，
+ *    物体重新露出来的那一帧就会被画出来
+ *
+ * 滞后（hysteresis）：连续 OCCLUSION_HYSTERESIS 次查询都被遮挡才进入遮挡状态，
+ * 一次查询可见就立即恢复，避免物体在遮挡边缘每帧来回切换。
+ *
+ * 包围盒与近平面相交（相机在包围盒内或贴近包围盒）时包围盒会被裁掉，查询结果不可靠，
+ * 这样的物体由调用者直接当作可见（见 Model::Draw）。
+ */
+#ifndef occlusion_culler_h
+#define occlusion_culler_h
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <vector>
+
+#include "shader.h"
+#include "gl_state.h"
+#include "frustum.h"
+
+// 连续多少次查询被遮挡后才认为物体被遮挡
+#define OCCLUSION_HYSTERESIS 3
+
+// 遮挡剔除统计（每帧）
+struct OcclusionStats {
+    unsigned long queries;      // 发出的包围盒查询
+    unsigned long occluded;     // 处于遮挡状态（交给条件渲染）的物体
+};
+
+class OcclusionCuller {
+public:
+    // 包围盒着色器
+    Shader boxShader;
+
+    // 构造函数（需要在 OpenGL 上下文创建之后调用）
+    OcclusionCuller(const char *vertexPath = "occlusion_box.vs", const char *fragmentPath = "occlusion_box.fs")
+        : boxShader(vertexPath, fragmentPath), stats(OcclusionStats{ 0, 0 }) {
+        mvpHandle = boxShader.getUniform("mvp");
+        minHandle = boxShader.getUniform("boxMin");
+        maxHandle = boxShader.getUniform("boxMax");
+        // 单位立方体 [0, 1]^3（着色器中缩放到包围盒）
+        const float corners[] = {
+            0, 0, 0,  1, 0, 0,  1, 1, 0,  0, 1, 0,
+            0, 0, 1,  1, 0, 1,  1, 1, 1,  0, 1, 1
+        };
+        const unsigned char indices[] = {
+            0, 2, 1,  0, 3, 2,  4, 5, 6,  4, 6, 7,  0, 1, 5,  0, 5, 4,
+            3, 6, 2,  3, 7, 6,  0, 4, 7,  0, 7, 3,  1, 2, 6,  1, 6, 5
+        };
+        glGenVertexArrays(1, &VAO);
+        glGenBuffers(1, &VBO);
+        glGenBuffers(1, &EBO);
+        GLState::instance().bindVertexArray(VAO);
+        GLState::instance().bindBuffer(GL_ARRAY_BUFFER, VBO);
+        glBufferData(GL_ARRAY_BUFFER, sizeof(corners), corners, GL_STATIC_DRAW);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
+        glEnableVertexAttribArray(0);
+        GLState::instance().bindVertexArray(0);
+    }
+    // 释放 OpenGL 资源
+    void release() {
+        for (unsigned int i = 0; i < objects.size(); ++i)
+            glDeleteQueries(1, &objects[i].query);
+        objects.clear();
+        GLState::instance().deleteVertexArrays(1, &VAO);
+        GLState::instance().deleteBuffers(1, &VBO);
+        GLState::instance().deleteBuffers(1, &EBO);
+        GLState::instance().deleteProgram(boxShader.ID);
+    }
+    // 每帧开始时调用：物体数量变化时分配查询对象，读取已经有结果的查询并更新遮挡状态
+    void update(size_t objectCount) {
+        while (objects.size() < objectCount) {
+            Object object = Object();
+            glGenQueries(1, &object.query);
+            objects.push_back(object);
+        }
+        stats = OcclusionStats{ 0, 0 };
+        for (unsigned int i = 0; i < objects.size(); ++i) {
+            Object &object = objects[i];
+            if (!object.pending)
+                continue;
+            GLuint available = 0;
+            glGetQueryObjectuiv(object.query, GL_QUERY_RESULT_AVAILABLE, &available);
+            if (!available)
+                continue;
+            GLuint samplesPassed = 0;
+            glGetQueryObjectuiv(object.query, GL_QUERY_RESULT, &samplesPassed);
+            object.pending = false;
+            if (samplesPassed) {
+                object.occludedResults = 0;
+                object.occluded = false;
+            } else if (++object.occludedResults >= OCCLUSION_HYSTERESIS) {
+                object.occluded = true;
+            }
+        }
+    }
+    // 物体是否处于遮挡状态（需要用条件渲染绘制）
+    bool occluded(unsigned int index) const {
+        return index < objects.size() && objects[index].occluded;
+    }
+    // 物体离开视锥体或无法查询（与近平面相交）时重置为可见，重新进入时不会用过期的结果
+    void reset(unsigned int index) {
+        if (index >= objects.size())
+            return;
+        objects[index].occluded = false;
+        objects[index].occludedResults = 0;
+    }
+    // 开始包围盒查询：mvp 为物体所在空间（包围盒所在空间）的 MVP 矩阵
+    void beginQueries(const glm::mat4 &mvp) {
+        boxShader.use();
+        boxShader.setMat4(mvpHandle, mvp);
+        GLState::instance().bindVertexArray(VAO);
+        glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+        glDepthMask(GL_FALSE);
+    }
+    // 对一个物体的包围盒发出查询（上一次查询还没有结果时跳过）
+    void query(unsigned int index, const AABB &box) {
+        Object &object = objects[index];
+        if (object.pending || box.empty())
+            return;
+        boxShader.setVec3(minHandle, box.min);
+        boxShader.setVec3(maxHandle, box.max);
+        glBeginQuery(GL_ANY_SAMPLES_PASSED, object.query);
+        glDrawElements(GL_TRIANGLES, 36, GL_UNSIGNED_BYTE, (void*)0);
+        glEndQuery(GL_ANY_SAMPLES_PASSED);
+        object.pending = true;
+        object.queried = true;
+        ++stats.queries;
+    }
+    // 结束包围盒查询，恢复颜色和深度写入
+    void endQueries() {
+        glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+        glDepthMask(GL_TRUE);
+    }
+    // 条件渲染：之间的绘制调用由 GPU 根据这个物体最近一次查询的结果决定是否执行
+    void beginConditional(unsigned int index) {
+        ++stats.occluded;
+        if (objects[index].queried)
+            glBeginConditionalRender(objects[index].query, GL_QUERY_WAIT);
+        conditional = objects[index].queried;
+    }
+    void endConditional() {
+        if (conditional)
+            glEndConditionalRender();
+        conditional = false;
+    }
+    // 本帧的查询和遮挡数量
+    OcclusionStats frameStats() const {
+        return stats;
+    }
+
+private:
+    // 每个物体的查询和遮挡状态
+    struct Object {
+        GLuint query;
+        bool queried;                   // 查询发出过（条件渲染需要）
+        bool pending;                   // 查询已发出、结果还没读取
+        bool occluded;                  // 遮挡状态
+        unsigned int occludedResults;   // 连续被遮挡的查询次数
+    };
+    std::vector<Object> objects;
+    GLuint VAO, VBO, EBO;
+    UniformHandle mvpHandle, minHandle, maxHandle;
+    OcclusionStats stats;
+    bool conditional = false;
+};
+
+#endif /* occlusion_culler_h */
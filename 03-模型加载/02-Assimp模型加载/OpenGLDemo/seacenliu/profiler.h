@@ -0,0 +1,366 @@
+//
+//  profiler.h
+//  OpenGLDemo
+//
+//  Created by SeacenLiu on 2020/2/22.
+//  Copyright © 2020 SeacenLiu. All rights reserved.
+//
+
+/**
+ * 每帧 CPU / GPU 分区计时
+ *
+ * 代码中用 ProfileScope 标出一段区域（zone），作用域结束时记录耗时：
+ *     static const unsigned int zoneDraw = Profiler::instance().zone("绘制");
+ *     ProfileScope scope(zoneDraw, true);     // true：同时测量 GPU 耗时
+ * - CPU 耗时用 steady_clock 测量，CPU 区域可以任意嵌套
+ * - GPU 耗时用 GL_TIME_ELAPSED 查询测量（开始时另外用 glQueryCounter 记下 GPU 时间戳，用于导出时间线）。
+ *   同一时间只能有一个 GL_TIME_ELAPSED 查询，GPU 区域不能嵌套，嵌套在 GPU 区域里的 GPU 区域只测量 CPU 耗时
+ * - 查询对象按帧轮换（PROFILER_FRAME_LATENCY 组，默认双缓冲），复用一组查询之前读取它上一轮的结果；
+ *   结果还没有就绪时直接丢弃那一帧的 GPU 数据（计入 droppedFrames），从不等待 GPU
+ *
+ * 每个区域保留最近 PROFILER_WINDOW 帧的每帧耗时（同一帧多次进入的累加），printSummary 输出
+ * min / avg / p99，并比较 CPU 帧时间和 GPU 忙碌时间，判断是 CPU 提交还是 GPU（着色）占主导。
+ * startTrace 之后的每次进入都记录为事件，writeTrace 导出为 Chrome trace JSON（chrome://tracing 或 Perfetto 打开）。
+ *
+ * 只能在 OpenGL 上下文所在的线程使用。区域 ID 在第一次执行时注册（函数内的 static 变量），
+ * 之后进入区域不分配内存（渲染循环中的堆内存分配计数不受影响；记录 trace 时事件缓冲也是预先分配的）。
+ */
+#ifndef profiler_h
+#define profiler_h
+
+#include <glad/glad.h>
+
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+
+#include "frame_histogram.h"
+
+// GPU 查询按帧轮换的组数（2 为双缓冲：读取的是两帧之前的结果）
+#define PROFILER_FRAME_LATENCY 2
+// 每帧最多多少个 GPU 区域（超过的只测量 CPU 耗时）
+#define PROFILER_MAX_GPU_ZONES 256
+// 滚动统计的帧数
+#define PROFILER_WINDOW 240
+// 超过这个值（1 秒）的 GPU 查询结果视为无效
+#define PROFILER_MAX_GPU_NS 1000000000ull
+// trace 最多记录的事件数
+#define PROFILER_TRACE_MAX_EVENTS (256u * 1024u)
+
+class Profiler {
+public:
+    // 当前上下文的分析器（示例中只有一个上下文）
+    static Profiler &instance() {
+        static Profiler profiler;
+        return profiler;
+    }
+
+    // 注册区域（同名区域返回同一个 ID）
+    unsigned int zone(const char *name) {
+        for (unsigned int i = 0; i < zones.size(); ++i) {
+            if (strcmp(zones[i].name, name) == 0)
+                return i;
+        }
+        Zone zone;
+        zone.name = name;
+        zone.cpuFrame = 0.0;
+        zone.calls = 0;
+        zone.cpuHistory.assign(PROFILER_WINDOW, 0.0);
+        zone.gpuHistory.assign(PROFILER_WINDOW, 0.0);
+        zone.cpuCount = zone.gpuCount = 0;
+        zone.callsTotal = 0;
+        zones.push_back(zone);
+        return (unsigned int)zones.size() - 1;
+    }
+    // 开启计时（需要在 OpenGL 上下文创建之后调用，第一次开启时创建查询对象）
+    void setEnabled(bool value) {
+        if (value && frames[0].elapsed.empty()) {
+            for (unsigned int f = 0; f < PROFILER_FRAME_LATENCY; ++f) {
+                GpuFrame &frame = frames[f];
+                frame.elapsed.resize(PROFILER_MAX_GPU_ZONES);
+                frame.timestamps.resize(PROFILER_MAX_GPU_ZONES);
+                frame.zones.resize(PROFILER_MAX_GPU_ZONES);
+                glGenQueries(PROFILER_MAX_GPU_ZONES, frame.elapsed.data());
+                glGenQueries(PROFILER_MAX_GPU_ZONES, frame.timestamps.data());
+                frame.count = 0;
+                frame.pending = false;
+            }
+            gpuScratch.assign(zones.size(), -1.0);
+        }
+        active = value;
+    }
+    bool enabled() const {
+        return active;
+    }
+    // 释放查询对象
+    void release() {
+        for (unsigned int f = 0; f < PROFILER_FRAME_LATENCY; ++f) {
+            GpuFrame &frame = frames[f];
+            if (frame.elapsed.empty())
+                continue;
+            glDeleteQueries((GLsizei)frame.elapsed.size(), frame.elapsed.data());
+            glDeleteQueries((GLsizei)frame.timestamps.size(), frame.timestamps.data());
+            frame.elapsed.clear();
+            frame.timestamps.clear();
+            frame.zones.clear();
+        }
+        active = false;
+    }
+
+    // 每帧开始时调用：读取这一组查询上一轮的结果，开始新的一帧
+    void beginFrame() {
+        if (!active)
+            return;
+        ++frameNumber;
+        GpuFrame &frame = frames[frameNumber % PROFILER_FRAME_LATENCY];
+        if (frame.pending)
+            resolve(frame);
+        frame.count = 0;
+        frame.pending = false;
+        frameStart = now();
+        gpuDepth = 0;
+    }
+    // 每帧结束时调用（交换缓冲之前）：把每个区域这一帧的累计 CPU 耗时放进滚动窗口
+    void endFrame() {
+        if (!active)
+            return;
+        double frameMs = (now() - frameStart) / 1000.0;
+        push(cpuFrameHistory, cpuFrameCount, frameMs);
+        if (tracing)
+            record(TRACE_FRAME, frameStart, frameMs * 1000.0, false);
+        for (unsigned int i = 0; i < zones.size(); ++i) {
+            Zone &z = zones[i];
+            if (z.calls > 0)
+                push(z.cpuHistory, z.cpuCount, z.cpuFrame);
+            z.callsTotal += z.calls;
+            z.cpuFrame = 0.0;
+            z.calls = 0;
+        }
+        GpuFrame &frame = frames[frameNumber % PROFILER_FRAME_LATENCY];
+        frame.pending = frame.count > 0;
+        ++completedFrames;
+    }
+
+    // 开始记录 trace 事件（GPU 时间戳换算到 CPU 时间线：用 GL_TIMESTAMP 查询一次当前 GPU 时间对齐）
+    void startTrace() {
+        events.clear();
+        events.reserve(PROFILER_TRACE_MAX_EVENTS);
+        GLint64 gpuNow = 0;
+        glGetInteger64v(GL_TIMESTAMP, &gpuNow);
+        gpuOffsetUs = now() - gpuNow / 1000.0;
+        tracing = true;
+    }
+    // 导出 Chrome trace JSON（tid 1 为 CPU，tid 2 为 GPU）
+    bool writeTrace(const std::string &path) const {
+        FILE *file = fopen(path.c_str(), "w");
+        if (!file)
+            return false;
+        fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+        fprintf(file, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"name\":\"CPU\"}},\n");
+        fprintf(file, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":2,\"args\":{\"name\":\"GPU\"}}");
+        for (unsigned int i = 0; i < events.size(); ++i) {
+            const Event &e = events[i];
+            std::string name = e.zone == TRACE_FRAME ? "帧" : EscapeJson(zones[e.zone].name);
+            fprintf(file, ",\n{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%d}",
+                    name.c_str(), e.gpu ? "gpu" : "cpu", e.start, e.duration, e.gpu ? 2 : 1);
+        }
+        fprintf(file, "\n]}\n");
+        bool ok = !ferror(file);
+        return (fclose(file) == 0) && ok;
+    }
+    size_t traceEventCount() const {
+        return events.size();
+    }
+
+    // 输出每个区域最近 PROFILER_WINDOW 帧的 min / avg / p99（毫秒）和 CPU / GPU 谁占主导
+    void printSummary() const {
+        FrameTimeHistogram scratch;
+        std::cout << "分区计时（最近 " << std::min<unsigned long>(cpuFrameCount, PROFILER_WINDOW) << " 帧，毫秒，min / avg / p99）:"
+                  << std::endl;
+        double gpuBusy = 0.0;
+        for (unsigned int i = 0; i < zones.size(); ++i) {
+            const Zone &z = zones[i];
+            if (z.cpuCount == 0)
+                continue;
+            Summary cpu = Summarize(z.cpuHistory, z.cpuCount, scratch);
+            std::cout << "  " << std::left << std::setw(18) << z.name << std::right << std::fixed << std::setprecision(3)
+                      << " CPU " << cpu.min << " / " << cpu.avg << " / " << cpu.p99;
+            if (z.gpuCount > 0) {
+                Summary gpu = Summarize(z.gpuHistory, z.gpuCount, scratch);
+                std::cout << "  GPU " << gpu.min << " / " << gpu.avg << " / " << gpu.p99;
+                gpuBusy += gpu.avg;
+            }
+            std::cout << std::defaultfloat << std::setprecision(6) << "  (每帧 "
+                      << (completedFrames ? (double)z.callsTotal / completedFrames : 0.0) << " 次)" << std::endl;
+        }
+        Summary frame = Summarize(cpuFrameHistory, cpuFrameCount, scratch);
+        std::cout << "  CPU 帧（不含交换缓冲）平均 " << frame.avg << " ms, p99 " << frame.p99 << " ms; GPU 区域合计平均 "
+                  << gpuBusy << " ms; 丢弃的 GPU 结果 " << droppedFrames << " 帧 → "
+                  << (gpuBusy > frame.avg ? "GPU 占主导（着色/光栅化）" : "CPU 提交占主导") << std::endl;
+    }
+
+private:
+    friend class ProfileScope;
+    // 帧事件使用的特殊区域 ID
+    static const unsigned int TRACE_FRAME = 0xFFFFFFFFu;
+
+    struct Zone {
+        const char *name;
+        double cpuFrame;                        // 当前帧累计（毫秒）
+        unsigned int calls;                     // 当前帧进入次数
+        unsigned long callsTotal;
+        std::vector<double> cpuHistory, gpuHistory;
+        unsigned long cpuCount, gpuCount;       // 写入过的帧数（环形缓冲）
+    };
+    // 一帧的 GPU 查询
+    struct GpuFrame {
+        std::vector<GLuint> elapsed;            // GL_TIME_ELAPSED
+        std::vector<GLuint> timestamps;         // 区域开始时的 GL_TIMESTAMP
+        std::vector<unsigned int> zones;
+        unsigned int count;
+        bool pending;
+    };
+    struct Event {
+        unsigned int zone;
+        double start, duration;                 // 微秒
+        bool gpu;
+    };
+    struct Summary {
+        double min, avg, p99;
+    };
+
+    std::vector<Zone> zones;
+    GpuFrame frames[PROFILER_FRAME_LATENCY];
+    std::vector<double> gpuScratch;             // 解析 GPU 结果时每个区域的累计（负数表示这一帧没有测量）
+    std::vector<double> cpuFrameHistory;
+    unsigned long cpuFrameCount = 0;
+    unsigned long frameNumber = 0, completedFrames = 0, droppedFrames = 0;
+    double frameStart = 0.0;
+    unsigned int gpuDepth = 0;
+    bool active = false, tracing = false;
+    std::vector<Event> events;
+    double gpuOffsetUs = 0.0;
+    std::chrono::steady_clock::time_point epoch;
+
+    Profiler() : cpuFrameHistory(PROFILER_WINDOW, 0.0), epoch(std::chrono::steady_clock::now()) {}
+
+    // 从创建开始的微秒数
+    double now() const {
+        return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - epoch).count();
+    }
+    static void push(std::vector<double> &history, unsigned long &count, double value) {
+        history[count % history.size()] = value;
+        ++count;
+    }
+    void record(unsigned int zone, double start, double duration, bool gpu) {
+        if (events.size() < events.capacity())
+            events.push_back(Event{ zone, start, duration, gpu });
+    }
+    // 读取一帧的 GPU 查询结果（查询按提交顺序完成，最后一个就绪时前面的都已就绪）
+    void resolve(const GpuFrame &frame) {
+        GLuint available = 0;
+        glGetQueryObjectuiv(frame.elapsed[frame.count - 1], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available) {
+            ++droppedFrames;
+            return;
+        }
+        gpuScratch.resize(zones.size(), -1.0);
+        for (unsigned int i = 0; i < frame.count; ++i) {
+            GLuint64 elapsed = 0;
+            glGetQueryObjectui64v(frame.elapsed[i], GL_QUERY_RESULT, &elapsed);
+            // 明显无效的结果（有的驱动第一次查询返回的是绝对时间）
+            if (elapsed >= PROFILER_MAX_GPU_NS)
+                continue;
+            double &sum = gpuScratch[frame.zones[i]];
+            sum = std::max(sum, 0.0) + elapsed / 1.0e6;
+            if (tracing) {
+                GLuint64 timestamp = 0;
+                glGetQueryObjectui64v(frame.timestamps[i], GL_QUERY_RESULT, &timestamp);
+                record(frame.zones[i], timestamp / 1000.0 + gpuOffsetUs, elapsed / 1000.0, true);
+            }
+        }
+        for (unsigned int i = 0; i < zones.size(); ++i) {
+            if (gpuScratch[i] >= 0.0)
+                push(zones[i].gpuHistory, zones[i].gpuCount, gpuScratch[i]);
+            gpuScratch[i] = -1.0;
+        }
+    }
+    // GPU 区域开始（返回 false 表示没有测量：嵌套或者这一帧的查询用完了）
+    bool beginGpu(unsigned int zone) {
+        GpuFrame &frame = frames[frameNumber % PROFILER_FRAME_LATENCY];
+        if (gpuDepth++ > 0 || frame.count >= frame.elapsed.size())
+            return false;
+        frame.zones[frame.count] = zone;
+        glQueryCounter(frame.timestamps[frame.count], GL_TIMESTAMP);
+        glBeginQuery(GL_TIME_ELAPSED, frame.elapsed[frame.count]);
+        return true;
+    }
+    void endGpu(bool measured) {
+        --gpuDepth;
+        if (!measured)
+            return;
+        glEndQuery(GL_TIME_ELAPSED);
+        ++frames[frameNumber % PROFILER_FRAME_LATENCY].count;
+    }
+    void endCpu(unsigned int zone, double start) {
+        double duration = now() - start;
+        Zone &z = zones[zone];
+        z.cpuFrame += duration / 1000.0;
+        ++z.calls;
+        if (tracing)
+            record(zone, start, duration, false);
+    }
+    // 滚动窗口的 min / avg / p99
+    static Summary Summarize(const std::vector<double> &history, unsigned long count, FrameTimeHistogram &scratch) {
+        size_t n = (size_t)std::min<unsigned long>(count, history.size());
+        scratch.clear();
+        for (size_t i = 0; i < n; ++i)
+            scratch.add(history[i]);
+        return Summary{ scratch.minimum(), scratch.average(), scratch.percentile(99.0) };
+    }
+    static std::string EscapeJson(const char *text) {
+        std::string escaped;
+        for (const char *c = text; *c; ++c) {
+            if (*c == '"' || *c == '\\')
+                escaped += '\\';
+            escaped += *c;
+        }
+        return escaped;
+    }
+};
+
+// 区域作用域：构造时开始计时，析构时记录（分析器关闭时什么也不做）
+class ProfileScope {
+public:
+    explicit ProfileScope(unsigned int zone, bool gpu = false)
+        : zone(zone), start(0.0), measuring(false), gpuMeasured(false), gpuZone(false) {
+        Profiler &profiler = Profiler::instance();
+        if (!profiler.active)
+            return;
+        measuring = true;
+        gpuZone = gpu;
+        if (gpu)
+            gpuMeasured = profiler.beginGpu(zone);
+        start = profiler.now();
+    }
+    ~ProfileScope() {
+        if (!measuring)
+            return;
+        Profiler &profiler = Profiler::instance();
+        profiler.endCpu(zone, start);
+        if (gpuZone)
+            profiler.endGpu(gpuMeasured);
+    }
+
+private:
+    unsigned int zone;
+    double start;
+    bool measuring, gpuMeasured, gpuZone;
+};
+
+#endif /* profiler_h */
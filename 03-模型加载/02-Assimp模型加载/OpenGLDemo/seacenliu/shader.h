@@ -12,6 +12,10 @@
  * Xcode 调试中想使用源码相对路径需要设置
  * Edit Scheme -> Run -> Options -> Working Directory -> Use custom working directory
  *
+ * 连接后通过 GL_ACTIVE_UNIFORMS 反射所有 uniform，set* 方法不再每次调用 glGetUniformLocation，
+ * 并缓存上一次上传的值，值未变化时跳过 glUniform*。
+ * 注意：缓存假设 uniform 只通过本类修改，直接调用 glUniform* 会使缓存失效。
+ *
  */
 #ifndef shader_h
 #define shader_h
@@ -23,11 +27,42 @@
 #include <fstream>
 #include <sstream>
 #include <iostream>
+#include <cstring>
+#include <memory>
+#include <vector>
+#include <unordered_map>
 // glm
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
+#include "gl_state.h"
+
+// uniform 反射槽位（缓存上一次上传的值，最大为 mat4）
+struct UniformSlot {
+    GLint location;
+    bool  valid;
+    float cache[16];
+};
+
+// uniform 句柄（反射表下标，-1 表示着色器中不存在该 uniform）
+struct UniformHandle {
+    int index;
+};
+
+// uniform 调用统计
+// - lookupsSaved: 名字查找命中反射表，省掉的 glGetUniformLocation 次数
+// - uploadsSkipped: 值未变化（或 uniform 不存在）而跳过的 glUniform* 次数
+// - uploadsIssued: 实际发出的 glUniform* 次数
+// - lookupFallbacks: 反射表中没有、回退到 glGetUniformLocation 的名字查找次数
+struct UniformStats {
+    unsigned long lookupsSaved;
+    unsigned long uploadsSkipped;
+    unsigned long uploadsIssued;
+    unsigned long lookupFallbacks;
+    unsigned long callsSaved() const { return lookupsSaved + uploadsSkipped; }
+};
+
 class Shader {
 public:
     // Program 的 ID
@@ -104,6 +139,7 @@ public:
             glAttachShader(ID, geometry);
         glLinkProgram(ID);
         checkCompileErrors(ID, "PROGRAM");
+        reflectUniforms();
         // 连接后着色器就没用了，删除即可
         glDeleteShader(vertex);
         glDeleteShader(fragment);
@@ -113,53 +149,114 @@ public:
     // 激活着色器程序
     // ------------------------------------------------------------------------
     void use() {
-        glUseProgram(ID);
+        GLState::instance().useProgram(ID);
+    }
+    // 获取 uniform 句柄（在渲染循环外获取一次，之后用句柄设置可避免字符串查找）
+    // ------------------------------------------------------------------------
+    UniformHandle getUniform(const std::string &name) const {
+        return UniformHandle{ findSlot(name) };
+    }
+    // uniform 统计（所有着色器共享，每帧读取后清零）
+    // ------------------------------------------------------------------------
+    static UniformStats &stats() {
+        static UniformStats s = { 0, 0, 0, 0 };
+        return s;
+    }
+    static UniformStats frameStats() {
+        UniformStats s = stats();
+        stats() = UniformStats{ 0, 0, 0, 0 };
+        return s;
     }
-    // uniform 工具方法
+    // uniform 工具方法（名字版本：先查反射表，再走句柄版本）
     // ------------------------------------------------------------------------
     void setBool(const std::string &name, bool value) const {
-        glUniform1i(glGetUniformLocation(ID, name.c_str()), (int)value);
+        setBool(lookup(name), value);
     }
     // ------------------------------------------------------------------------
     void setInt(const std::string &name, int value) const {
-        glUniform1i(glGetUniformLocation(ID, name.c_str()), value);
+        setInt(lookup(name), value);
     }
     // ------------------------------------------------------------------------
     void setFloat(const std::string &name, float value) const {
-        glUniform1f(glGetUniformLocation(ID, name.c_str()), value);
+        setFloat(lookup(name), value);
     }
     // ------------------------------------------------------------------------
     void setVec2(const std::string &name, const glm::vec2 &value) const {
-        glUniform2fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]);
+        setVec2(lookup(name), value);
     }
     void setVec2(const std::string &name, float x, float y) const {
-        glUniform2f(glGetUniformLocation(ID, name.c_str()), x, y);
+        setVec2(lookup(name), glm::vec2(x, y));
     }
     // ------------------------------------------------------------------------
     void setVec3(const std::string &name, const glm::vec3 &value) const {
-        glUniform3fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]);
+        setVec3(lookup(name), value);
     }
     void setVec3(const std::string &name, float x, float y, float z) const {
-        glUniform3f(glGetUniformLocation(ID, name.c_str()), x, y, z);
+        setVec3(lookup(name), glm::vec3(x, y, z));
     }
     // ------------------------------------------------------------------------
     void setVec4(const std::string &name, const glm::vec4 &value) const {
-        glUniform4fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]);
+        setVec4(lookup(name), value);
     }
     void setVec4(const std::string &name, float x, float y, float z, float w) {
-        glUniform4f(glGetUniformLocation(ID, name.c_str()), x, y, z, w);
+        setVec4(lookup(name), glm::vec4(x, y, z, w));
     }
     // ------------------------------------------------------------------------
     void setMat2(const std::string &name, const glm::mat2 &mat) const {
-        glUniformMatrix2fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+        setMat2(lookup(name), mat);
     }
     // ------------------------------------------------------------------------
     void setMat3(const std::string &name, const glm::mat3 &mat) const {
-        glUniformMatrix3fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+        setMat3(lookup(name), mat);
     }
     // ------------------------------------------------------------------------
     void setMat4(const std::string &name, glm::mat4 value) const {
-        glUniformMatrix4fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, glm::value_ptr(value));
+        setMat4(lookup(name), value);
+    }
+    // uniform 工具方法（句柄版本：值未变化时跳过上传）
+    // ------------------------------------------------------------------------
+    void setBool(UniformHandle h, bool value) const {
+        setInt(h, (int)value);
+    }
+    // ------------------------------------------------------------------------
+    void setInt(UniformHandle h, int value) const {
+        if (UniformSlot *slot = changed(h, &value, sizeof(value)))
+            glUniform1i(slot->location, value);
+    }
+    // ------------------------------------------------------------------------
+    void setFloat(UniformHandle h, float value) const {
+        if (UniformSlot *slot = changed(h, &value, sizeof(value)))
+            glUniform1f(slot->location, value);
+    }
+    // ------------------------------------------------------------------------
+    void setVec2(UniformHandle h, const glm::vec2 &value) const {
+        if (UniformSlot *slot = changed(h, &value[0], sizeof(value)))
+            glUniform2fv(slot->location, 1, &value[0]);
+    }
+    // ------------------------------------------------------------------------
+    void setVec3(UniformHandle h, const glm::vec3 &value) const {
+        if (UniformSlot *slot = changed(h, &value[0], sizeof(value)))
+            glUniform3fv(slot->location, 1, &value[0]);
+    }
+    // ------------------------------------------------------------------------
+    void setVec4(UniformHandle h, const glm::vec4 &value) const {
+        if (UniformSlot *slot = changed(h, &value[0], sizeof(value)))
+            glUniform4fv(slot->location, 1, &value[0]);
+    }
+    // ------------------------------------------------------------------------
+    void setMat2(UniformHandle h, const glm::mat2 &mat) const {
+        if (UniformSlot *slot = changed(h, &mat[0][0], sizeof(mat)))
+            glUniformMatrix2fv(slot->location, 1, GL_FALSE, &mat[0][0]);
+    }
+    // ------------------------------------------------------------------------
+    void setMat3(UniformHandle h, const glm::mat3 &mat) const {
+        if (UniformSlot *slot = changed(h, &mat[0][0], sizeof(mat)))
+            glUniformMatrix3fv(slot->location, 1, GL_FALSE, &mat[0][0]);
+    }
+    // ------------------------------------------------------------------------
+    void setMat4(UniformHandle h, const glm::mat4 &mat) const {
+        if (UniformSlot *slot = changed(h, &mat[0][0], sizeof(mat)))
+            glUniformMatrix4fv(slot->location, 1, GL_FALSE, glm::value_ptr(mat));
     }
 
 private:
@@ -182,6 +279,84 @@ private:
             }
         }
     }
+    // uniform 反射表（拷贝 Shader 时共享同一份，保证缓存值与程序状态一致）
+    // ------------------------------------------------------------------------
+    struct UniformTable {
+        std::unordered_map<std::string, int> index; // 名字 -> slots 下标
+        std::vector<UniformSlot> slots;
+    };
+    std::shared_ptr<UniformTable> uniforms;
+    // 连接后枚举所有活跃 uniform，建立名字到位置的哈希表
+    // ------------------------------------------------------------------------
+    void reflectUniforms() {
+        uniforms = std::make_shared<UniformTable>();
+        GLint count = 0, maxLength = 0;
+        glGetProgramiv(ID, GL_ACTIVE_UNIFORMS, &count);
+        glGetProgramiv(ID, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+        std::vector<GLchar> buffer(maxLength > 0 ? maxLength : 1);
+        for (GLint i = 0; i < count; ++i) {
+            GLint size = 0;
+            GLenum type = 0;
+            glGetActiveUniform(ID, (GLuint)i, (GLsizei)buffer.size(), NULL, &size, &type, buffer.data());
+            std::string name(buffer.data());
+            GLint location = glGetUniformLocation(ID, name.c_str());
+            if (location < 0) // uniform block 中的成员没有位置
+                continue;
+            addSlot(name, location);
+            // 基础类型数组只返回 "name[0]"，需要展开其余元素
+            std::string::size_type bracket = name.rfind("[0]");
+            if (bracket != std::string::npos && bracket + 3 == name.size()) {
+                std::string base = name.substr(0, bracket);
+                uniforms->index[base] = uniforms->index[name];
+                for (GLint j = 1; j < size; ++j) {
+                    std::string element = base + "[" + std::to_string(j) + "]";
+                    addSlot(element, glGetUniformLocation(ID, element.c_str()));
+                }
+            }
+        }
+    }
+    int addSlot(const std::string &name, GLint location) const {
+        UniformSlot slot;
+        slot.location = location;
+        slot.valid = false;
+        uniforms->slots.push_back(slot);
+        int idx = (int)uniforms->slots.size() - 1;
+        uniforms->index[name] = idx;
+        return idx;
+    }
+    // 查找 uniform，反射表中没有时回退到 glGetUniformLocation 并记住结果
+    int findSlot(const std::string &name) const {
+        std::unordered_map<std::string, int>::const_iterator it = uniforms->index.find(name);
+        if (it != uniforms->index.end())
+            return it->second;
+        return addSlot(name, glGetUniformLocation(ID, name.c_str()));
+    }
+    // 只有命中反射表（或之前回退时记住的结果）才算省掉了一次 glGetUniformLocation
+    UniformHandle lookup(const std::string &name) const {
+        std::unordered_map<std::string, int>::const_iterator it = uniforms->index.find(name);
+        if (it != uniforms->index.end()) {
+            ++stats().lookupsSaved;
+            return UniformHandle{ it->second };
+        }
+        ++stats().lookupFallbacks;
+        return UniformHandle{ addSlot(name, glGetUniformLocation(ID, name.c_str())) };
+    }
+    // 与缓存比较，值发生变化才需要上传（返回 nullptr 表示跳过）
+    UniformSlot *changed(UniformHandle h, const void *data, size_t bytes) const {
+        if (h.index < 0 || uniforms->slots[h.index].location < 0) {
+            ++stats().uploadsSkipped;
+            return nullptr;
+        }
+        UniformSlot &slot = uniforms->slots[h.index];
+        if (slot.valid && std::memcmp(slot.cache, data, bytes) == 0) {
+            ++stats().uploadsSkipped;
+            return nullptr;
+        }
+        std::memcpy(slot.cache, data, bytes);
+        slot.valid = true;
+        ++stats().uploadsIssued;
+        return &slot;
+    }
 };
 
 #endif /* shader_h */
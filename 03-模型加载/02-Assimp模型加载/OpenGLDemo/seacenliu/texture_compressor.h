@@ -0,0 +1,487 @@
+//
+//  texture_compressor.h
+//  OpenGLDemo
+//
+//  Created by SeacenLiu on 2020/2/20.
+//  Copyright © 2020 SeacenLiu. All rights reserved.
+//
+
+/**
+ * 离线纹理压缩：PNG/JPG -> BCn 块压缩 + 预生成 mipmap -> KTX（ktx_texture.h）
+ *
+ * 格式选择（ChooseTextureFormat）：
+ * - 文件名含 "_ddn" 的法线贴图：BC5，只保存 x、y 两个分量，z 在着色器中用 sqrt(1 - x² - y²) 还原；
+ *   生成 mipmap 时先解码成向量再平均、归一化，远处的法线不会变短
+ * - 单通道图片：BC4（与 stb 路径的 GL_RED 一致）
+ * - 有透明像素（alpha < 255）：BC3，否则 BC1
+ *
+ * 编码器：
+ * - BC1 颜色块：取块内颜色主成分方向（协方差矩阵幂迭代）上的投影范围作为端点，
+ *   再按选出的索引做一次最小二乘修正，误差更小时采用
+ * - BC4 单通道块（也用于 BC3 的 alpha、BC5 的两个通道）：块内最小、最大值作为端点，8 级插值
+ * - 索引按像素在端点连线上的投影取整选择（QuantizeBlock），支持 SSE2 时一次处理 4 个像素
+ * - 每一级图像按块行分给多个线程编码
+ *
+ * mipmap 与 glGenerateMipmap 一样在线性空间做 2x2 盒式滤波。
+ * 转换结果与 stb 路径对比显存占用和加载耗时（ConvertTextureDirectory 输出每个文件的对比）。
+ */
+#ifndef texture_compressor_h
+#define texture_compressor_h
+
+#include <glad/glad.h>
+
+#include <cmath>
+#include <cctype>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <thread>
+#include <chrono>
+#include <iostream>
+#include <algorithm>
+
+#include <dirent.h>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "ktx_texture.h"
+#include "texture_loader.h"
+
+// 把 16 个像素投影到端点连线上并取整到 [0, steps]：
+// out[i] = round(clamp((r[i] - base[0]) * axis[0] + (g[i] - base[1]) * axis[1] + (b[i] - base[2]) * axis[2], 0, steps))
+inline void QuantizeBlock(const float *r, const float *g, const float *b,
+                          const float base[3], const float axis[3], float steps, int out[16]) {
+#if defined(__SSE2__)
+    for (int i = 0; i < 16; i += 4) {
+        __m128 t = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(r + i), _mm_set1_ps(base[0])), _mm_set1_ps(axis[0]));
+        t = _mm_add_ps(t, _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(g + i), _mm_set1_ps(base[1])), _mm_set1_ps(axis[1])));
+        t = _mm_add_ps(t, _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(b + i), _mm_set1_ps(base[2])), _mm_set1_ps(axis[2])));
+        t = _mm_min_ps(_mm_max_ps(t, _mm_setzero_ps()), _mm_set1_ps(steps));
+        _mm_storeu_si128((__m128i *)(out + i), _mm_cvtps_epi32(t));
+    }
+#else
+    for (int i = 0; i < 16; ++i) {
+        float t = (r[i] - base[0]) * axis[0] + (g[i] - base[1]) * axis[1] + (b[i] - base[2]) * axis[2];
+        out[i] = (int)std::lrint(std::min(std::max(t, 0.0f), steps));
+    }
+#endif
+}
+
+// RGB565 打包（输入 0~255）
+inline uint16_t PackRGB565(const float c[3]) {
+    int r = (int)std::lround(std::min(std::max(c[0], 0.0f), 255.0f) * 31.0f / 255.0f);
+    int g = (int)std::lround(std::min(std::max(c[1], 0.0f), 255.0f) * 63.0f / 255.0f);
+    int b = (int)std::lround(std::min(std::max(c[2], 0.0f), 255.0f) * 31.0f / 255.0f);
+    return (uint16_t)((r << 11) | (g << 5) | b);
+}
+
+// RGB565 解包（高位复制到低位，与硬件解码一致）
+inline void UnpackRGB565(uint16_t v, float c[3]) {
+    int r = (v >> 11) & 31, g = (v >> 5) & 63, b = v & 31;
+    c[0] = (float)((r << 3) | (r >> 2));
+    c[1] = (float)((g << 2) | (g >> 4));
+    c[2] = (float)((b << 3) | (b >> 2));
+}
+
+// 用端点 c0 > c1（四色模式）为 16 个像素选择索引，返回平方误差
+inline float SelectBC1Indices(const float *r, const float *g, const float *b,
+                              uint16_t c0, uint16_t c1, uint32_t &indices) {
+    float palette[4][3];
+    UnpackRGB565(c0, palette[0]);
+    UnpackRGB565(c1, palette[1]);
+    float axis[3], length = 0.0f;
+    for (int k = 0; k < 3; ++k) {
+        palette[2][k] = (2.0f * palette[0][k] + palette[1][k]) / 3.0f;
+        palette[3][k] = (palette[0][k] + 2.0f * palette[1][k]) / 3.0f;
+        axis[k] = palette[1][k] - palette[0][k];
+        length += axis[k] * axis[k];
+    }
+    for (int k = 0; k < 3; ++k)
+        axis[k] = length > 0.0f ? axis[k] * 3.0f / length : 0.0f;
+    int steps[16];
+    QuantizeBlock(r, g, b, palette[0], axis, 3.0f, steps);
+    // 投影位置 0、1、2、3 对应 c0、2/3 c0 + 1/3 c1、1/3 c0 + 2/3 c1、c1
+    static const int order[4] = { 0, 2, 3, 1 };
+    indices = 0;
+    float error = 0.0f;
+    for (int i = 0; i < 16; ++i) {
+        int index = order[steps[i]];
+        indices |= (uint32_t)index << (2 * i);
+        float dr = r[i] - palette[index][0], dg = g[i] - palette[index][1], db = b[i] - palette[index][2];
+        error += dr * dr + dg * dg + db * db;
+    }
+    return error;
+}
+
+// 整理端点顺序（四色模式要求 c0 > c1；相等时所有像素使用 c0）并选择索引，返回平方误差
+inline float FinishBC1Block(const float *r, const float *g, const float *b,
+                            uint16_t &c0, uint16_t &c1, uint32_t &indices) {
+    if (c0 < c1)
+        std::swap(c0, c1);
+    if (c0 != c1)
+        return SelectBC1Indices(r, g, b, c0, c1, indices);
+    indices = 0;
+    float color[3], error = 0.0f;
+    UnpackRGB565(c0, color);
+    for (int i = 0; i < 16; ++i)
+        error += (r[i] - color[0]) * (r[i] - color[0]) + (g[i] - color[1]) * (g[i] - color[1])
+               + (b[i] - color[2]) * (b[i] - color[2]);
+    return error;
+}
+
+// 编码一个 BC1 颜色块（16 个像素的 RGB，0~255），输出 8 字节
+inline void EncodeBC1Block(const float *r, const float *g, const float *b, uint8_t *out) {
+    // 均值和协方差
+    float mean[3] = { 0.0f, 0.0f, 0.0f };
+    for (int i = 0; i < 16; ++i) {
+        mean[0] += r[i];
+        mean[1] += g[i];
+        mean[2] += b[i];
+    }
+    for (int k = 0; k < 3; ++k)
+        mean[k] /= 16.0f;
+    float cov[6] = { 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f };  // rr rg rb gg gb bb
+    for (int i = 0; i < 16; ++i) {
+        float dr = r[i] - mean[0], dg = g[i] - mean[1], db = b[i] - mean[2];
+        cov[0] += dr * dr; cov[1] += dr * dg; cov[2] += dr * db;
+        cov[3] += dg * dg; cov[4] += dg * db; cov[5] += db * db;
+    }
+    // 幂迭代求主方向（从方差最大的通道开始）
+    float axis[3] = { 0.0f, 0.0f, 0.0f };
+    axis[cov[0] >= cov[3] && cov[0] >= cov[5] ? 0 : (cov[3] >= cov[5] ? 1 : 2)] = 1.0f;
+    for (int iteration = 0; iteration < 8; ++iteration) {
+        float x = cov[0] * axis[0] + cov[1] * axis[1] + cov[2] * axis[2];
+        float y = cov[1] * axis[0] + cov[3] * axis[1] + cov[4] * axis[2];
+        float z = cov[2] * axis[0] + cov[4] * axis[1] + cov[5] * axis[2];
+        float length = std::sqrt(x * x + y * y + z * z);
+        if (length <= 0.0f)
+            break;
+        axis[0] = x / length;
+        axis[1] = y / length;
+        axis[2] = z / length;
+    }
+    // 主方向上的投影范围作为端点
+    float tMin = 0.0f, tMax = 0.0f;
+    for (int i = 0; i < 16; ++i) {
+        float t = (r[i] - mean[0]) * axis[0] + (g[i] - mean[1]) * axis[1] + (b[i] - mean[2]) * axis[2];
+        tMin = std::min(tMin, t);
+        tMax = std::max(tMax, t);
+    }
+    float e0[3], e1[3];
+    for (int k = 0; k < 3; ++k) {
+        e0[k] = mean[k] + axis[k] * tMax;
+        e1[k] = mean[k] + axis[k] * tMin;
+    }
+    uint16_t c0 = PackRGB565(e0), c1 = PackRGB565(e1);
+    uint32_t indices;
+    float error = FinishBC1Block(r, g, b, c0, c1, indices);
+    // 最小二乘修正：固定索引，求使误差最小的两个端点
+    if (error > 0.0f && c0 != c1) {
+        static const float weights[4] = { 1.0f, 0.0f, 2.0f / 3.0f, 1.0f / 3.0f };
+        float aa = 0.0f, ab = 0.0f, bb = 0.0f, ax[3] = { 0.0f, 0.0f, 0.0f }, bx[3] = { 0.0f, 0.0f, 0.0f };
+        for (int i = 0; i < 16; ++i) {
+            float wa = weights[(indices >> (2 * i)) & 3], wb = 1.0f - wa;
+            aa += wa * wa;
+            ab += wa * wb;
+            bb += wb * wb;
+            ax[0] += wa * r[i]; ax[1] += wa * g[i]; ax[2] += wa * b[i];
+            bx[0] += wb * r[i]; bx[1] += wb * g[i]; bx[2] += wb * b[i];
+        }
+        float det = aa * bb - ab * ab;
+        if (std::fabs(det) > 1e-6f) {
+            for (int k = 0; k < 3; ++k) {
+                e0[k] = (bb * ax[k] - ab * bx[k]) / det;
+                e1[k] = (aa * bx[k] - ab * ax[k]) / det;
+            }
+            uint16_t r0 = PackRGB565(e0), r1 = PackRGB565(e1);
+            uint32_t refined;
+            float refinedError = FinishBC1Block(r, g, b, r0, r1, refined);
+            if (refinedError < error) {
+                c0 = r0;
+                c1 = r1;
+                indices = refined;
+            }
+        }
+    }
+    out[0] = (uint8_t)(c0 & 0xff);
+    out[1] = (uint8_t)(c0 >> 8);
+    out[2] = (uint8_t)(c1 & 0xff);
+    out[3] = (uint8_t)(c1 >> 8);
+    for (int k = 0; k < 4; ++k)
+        out[4 + k] = (uint8_t)(indices >> (8 * k));
+}
+
+// 编码一个 BC4 单通道块（16 个值，0~255），输出 8 字节
+inline void EncodeBC4Block(const float *values, uint8_t *out) {
+    float lo = values[0], hi = values[0];
+    for (int i = 1; i < 16; ++i) {
+        lo = std::min(lo, values[i]);
+        hi = std::max(hi, values[i]);
+    }
+    int a0 = (int)std::lround(hi), a1 = (int)std::lround(lo);
+    out[0] = (uint8_t)a0;
+    out[1] = (uint8_t)a1;
+    uint64_t bits = 0;
+    // a0 > a1 时为 8 级插值模式；相等时所有值都用索引 0（a0）
+    if (a0 > a1) {
+        float base[3] = { (float)a1, 0.0f, 0.0f };
+        float axis[3] = { 7.0f / (float)(a0 - a1), 0.0f, 0.0f };
+        int steps[16];
+        QuantizeBlock(values, values, values, base, axis, 7.0f, steps);
+        // 投影位置 7 为 a0（索引 0），0 为 a1（索引 1），中间的 s 对应索引 8 - s
+        for (int i = 0; i < 16; ++i) {
+            int s = steps[i];
+            uint64_t index = s == 7 ? 0 : (s == 0 ? 1 : (uint64_t)(8 - s));
+            bits |= index << (3 * i);
+        }
+    }
+    for (int k = 0; k < 6; ++k)
+        out[2 + k] = (uint8_t)(bits >> (8 * k));
+}
+
+// 从 RGBA8 图像取出一个 4x4 块（超出边缘的像素重复使用边缘像素）
+inline void LoadBlock(const uint8_t *rgba, int width, int height, int bx, int by,
+                      float r[16], float g[16], float b[16], float a[16]) {
+    for (int y = 0; y < 4; ++y) {
+        int sy = std::min(by * 4 + y, height - 1);
+        for (int x = 0; x < 4; ++x) {
+            int sx = std::min(bx * 4 + x, width - 1);
+            const uint8_t *p = rgba + ((size_t)sy * width + sx) * 4;
+            int i = y * 4 + x;
+            r[i] = p[0];
+            g[i] = p[1];
+            b[i] = p[2];
+            a[i] = p[3];
+        }
+    }
+}
+
+// 压缩一级 RGBA8 图像，out 需要 KtxLevelBytes 字节；按块行分给 threads 个线程
+inline void CompressLevel(const uint8_t *rgba, int width, int height, GLenum format,
+                          uint8_t *out, unsigned int threads) {
+    int blocksX = (width + 3) / 4, blocksY = (height + 3) / 4;
+    size_t blockBytes = KtxBlockBytes(format);
+    auto encodeRows = [=](int firstRow, int lastRow) {
+        float r[16], g[16], b[16], a[16];
+        for (int by = firstRow; by < lastRow; ++by) {
+            for (int bx = 0; bx < blocksX; ++bx) {
+                uint8_t *block = out + ((size_t)by * blocksX + bx) * blockBytes;
+                LoadBlock(rgba, width, height, bx, by, r, g, b, a);
+                switch (format) {
+                    case GL_COMPRESSED_RGB_S3TC_DXT1_EXT:
+                        EncodeBC1Block(r, g, b, block);
+                        break;
+                    case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT:
+                        EncodeBC4Block(a, block);
+                        EncodeBC1Block(r, g, b, block + 8);
+                        break;
+                    case GL_COMPRESSED_RED_RGTC1:
+                        EncodeBC4Block(r, block);
+                        break;
+                    default:
+                        EncodeBC4Block(r, block);
+                        EncodeBC4Block(g, block + 8);
+                        break;
+                }
+            }
+        }
+    };
+    threads = std::max(1u, std::min(threads, (unsigned int)blocksY));
+    if (threads == 1) {
+        encodeRows(0, blocksY);
+        return;
+    }
+    std::vector<std::thread> workers;
+    for (unsigned int t = 0; t < threads; ++t)
+        workers.push_back(std::thread(encodeRows, blocksY * (int)t / (int)threads, blocksY * (int)(t + 1) / (int)threads));
+    for (unsigned int t = 0; t < workers.size(); ++t)
+        workers[t].join();
+}
+
+// 2x2 盒式滤波缩小一级（奇数尺寸时边缘像素重复使用）；
+// normalMap 为 true 时 RGB 按法向量解码、平均后重新归一化
+inline std::vector<uint8_t> DownsampleRGBA(const std::vector<uint8_t> &src, int width, int height, bool normalMap) {
+    int w = std::max(1, width / 2), h = std::max(1, height / 2);
+    std::vector<uint8_t> dst((size_t)w * h * 4);
+    for (int y = 0; y < h; ++y) {
+        for (int x = 0; x < w; ++x) {
+            float sum[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+            for (int dy = 0; dy < 2; ++dy) {
+                for (int dx = 0; dx < 2; ++dx) {
+                    int sx = std::min(x * 2 + dx, width - 1), sy = std::min(y * 2 + dy, height - 1);
+                    const uint8_t *p = &src[((size_t)sy * width + sx) * 4];
+                    for (int k = 0; k < 4; ++k)
+                        sum[k] += normalMap && k < 3 ? p[k] / 127.5f - 1.0f : (float)p[k];
+                }
+            }
+            uint8_t *q = &dst[((size_t)y * w + x) * 4];
+            if (normalMap) {
+                float length = std::sqrt(sum[0] * sum[0] + sum[1] * sum[1] + sum[2] * sum[2]);
+                for (int k = 0; k < 3; ++k) {
+                    float n = length > 0.0f ? sum[k] / length : (k == 2 ? 1.0f : 0.0f);
+                    q[k] = (uint8_t)std::lround((n + 1.0f) * 127.5f);
+                }
+            } else {
+                for (int k = 0; k < 3; ++k)
+                    q[k] = (uint8_t)std::lround(sum[k] * 0.25f);
+            }
+            q[3] = (uint8_t)std::lround(sum[3] * 0.25f);
+        }
+    }
+    return dst;
+}
+
+// 是否为法线贴图（按文件名约定，例如 nanosuit 的 *_ddn.png）
+inline bool IsNormalMap(const std::string &path) {
+    std::string name = path.substr(path.find_last_of('/') + 1);
+    return name.find("_ddn") != std::string::npos || name.find("_normal") != std::string::npos;
+}
+
+// 选择压缩格式（rgba 为 4 通道数据，nrComponents 为图片原本的通道数）
+inline GLenum ChooseTextureFormat(const std::string &path, const uint8_t *rgba, int width, int height, int nrComponents) {
+    if (IsNormalMap(path))
+        return GL_COMPRESSED_RG_RGTC2;
+    if (nrComponents == 1)
+        return GL_COMPRESSED_RED_RGTC1;
+    if (nrComponents == 2 || nrComponents == 4) {
+        for (size_t i = 0; i < (size_t)width * height; ++i) {
+            if (rgba[i * 4 + 3] < 255)
+                return GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+        }
+    }
+    return GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+}
+
+// 压缩 RGBA8 图像并生成完整的 mipmap 链（threads 为 0 时使用所有硬件线程）
+inline KtxTexture CompressTexture(const uint8_t *rgba, int width, int height, GLenum format,
+                                  bool normalMap, unsigned int threads = 0) {
+    if (threads == 0)
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    KtxTexture texture;
+    texture.internalFormat = format;
+    texture.width = width;
+    texture.height = height;
+    std::vector<uint8_t> level(rgba, rgba + (size_t)width * height * 4);
+    std::vector<uint8_t> blocks;
+    for (int w = width, h = height; ; ) {
+        blocks.resize(KtxLevelBytes(format, w, h));
+        CompressLevel(level.data(), w, h, format, blocks.data(), threads);
+        texture.addLevel(blocks.data(), blocks.size());
+        if (w == 1 && h == 1)
+            break;
+        level = DownsampleRGBA(level, w, h, normalMap);
+        w = std::max(1, w / 2);
+        h = std::max(1, h / 2);
+    }
+    return texture;
+}
+
+// 单个文件的转换结果
+struct TextureConversion {
+    std::string filename;
+    int width, height, nrComponents;
+    GLenum format;
+    size_t rawBytes;            // stb 路径的显存占用（与 TextureCache 的估算一致）
+    size_t compressedBytes;     // 压缩后的显存占用（包括所有 mipmap）
+    double encodeMs;            // 编码耗时（包括生成 mipmap）
+    double stbLoadMs;           // stb 路径加载耗时：解码 + 上传 + glGenerateMipmap
+    double ktxLoadMs;           // KTX 路径加载耗时：读取 + 上传
+};
+
+// 把一张图片转换为 "<图片路径>.ktx"（解码失败或写入失败时返回 false）
+inline bool ConvertTexture(const std::string &path, TextureConversion &result, unsigned int threads = 0) {
+    result = TextureConversion();
+    result.filename = path;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    int width = 0, height = 0, nrComponents = 0;
+    unsigned char *rgba = stbi_load(path.c_str(), &width, &height, &nrComponents, 4);
+    if (!rgba)
+        return false;
+    result.width = width;
+    result.height = height;
+    result.nrComponents = nrComponents;
+    result.format = ChooseTextureFormat(path, rgba, width, height, nrComponents);
+    KtxTexture texture = CompressTexture(rgba, width, height, result.format, IsNormalMap(path), threads);
+    stbi_image_free(rgba);
+    result.rawBytes = TextureCache::estimateBytes(width, height, nrComponents);
+    result.compressedBytes = texture.bytes();
+    result.encodeMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    return WriteKtx(KtxPath(path), texture);
+}
+
+// 分别用 stb 路径和 KTX 路径加载一次（到临时纹理对象，glFinish 等待上传完成），记录耗时
+inline void MeasureTextureLoad(TextureConversion &result) {
+    GLuint texture;
+    glGenTextures(1, &texture);
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    int width, height, nrComponents;
+    unsigned char *data = stbi_load(result.filename.c_str(), &width, &height, &nrComponents, 0);
+    if (data) {
+        UploadTexture(texture, data, width, height, nrComponents);
+        stbi_image_free(data);
+    }
+    glFinish();
+    result.stbLoadMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    GLState::instance().deleteTextures(1, &texture);
+
+    glGenTextures(1, &texture);
+    start = std::chrono::steady_clock::now();
+    KtxTexture ktx;
+    if (ReadKtx(KtxPath(result.filename), ktx) && KtxSupported(ktx.internalFormat))
+        UploadKtxTexture(texture, ktx);
+    glFinish();
+    result.ktxLoadMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    GLState::instance().deleteTextures(1, &texture);
+}
+
+// 目录下所有图片（png/jpg/jpeg/tga/bmp）的文件名（不含目录），按名字排序
+inline std::vector<std::string> ListTextureFiles(const std::string &directory) {
+    std::vector<std::string> files;
+    if (DIR *dir = opendir(directory.c_str())) {
+        while (struct dirent *entry = readdir(dir)) {
+            std::string name = entry->d_name;
+            std::string extension = name.substr(name.find_last_of('.') + 1);
+            std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+            if (extension == "png" || extension == "jpg" || extension == "jpeg" || extension == "tga" || extension == "bmp")
+                files.push_back(name);
+        }
+        closedir(dir);
+    }
+    std::sort(files.begin(), files.end());
+    return files;
+}
+
+// 转换目录下所有图片，输出每个文件和总计的显存、加载耗时对比，返回转换成功的数量
+inline unsigned int ConvertTextureDirectory(const std::string &directory, unsigned int threads = 0) {
+    std::vector<std::string> files = ListTextureFiles(directory);
+    for (unsigned int i = 0; i < files.size(); ++i)
+        files[i] = directory + '/' + files[i];
+    unsigned int converted = 0;
+    size_t rawSum = 0, compressedSum = 0;
+    double stbSum = 0.0, ktxSum = 0.0, encodeSum = 0.0;
+    for (unsigned int i = 0; i < files.size(); ++i) {
+        TextureConversion result;
+        if (!ConvertTexture(files[i], result, threads)) {
+            std::cout << "压缩纹理失败: " << files[i] << std::endl;
+            continue;
+        }
+        MeasureTextureLoad(result);
+        std::cout << "压缩纹理 " << files[i] << " (" << result.width << "x" << result.height << "x" << result.nrComponents
+                  << "): " << KtxFormatName(result.format) << ", 显存 " << result.rawBytes / 1024 << " KB -> "
+                  << result.compressedBytes / 1024 << " KB, 编码 " << result.encodeMs << " ms, 加载 "
+                  << result.stbLoadMs << " ms -> " << result.ktxLoadMs << " ms" << std::endl;
+        ++converted;
+        rawSum += result.rawBytes;
+        compressedSum += result.compressedBytes;
+        encodeSum += result.encodeMs;
+        stbSum += result.stbLoadMs;
+        ktxSum += result.ktxLoadMs;
+    }
+    std::cout << "压缩纹理: " << converted << " 个, 显存 " << rawSum / 1024 << " KB -> " << compressedSum / 1024
+              << " KB, 编码累计 " << encodeSum << " ms, 加载累计 " << stbSum << " ms -> " << ktxSum << " ms" << std::endl;
+    return converted;
+}
+
+#endif /* texture_compressor_h */
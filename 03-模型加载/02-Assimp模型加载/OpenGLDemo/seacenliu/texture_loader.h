@@ -0,0 +1,231 @@
+//
+//  texture_loader.h
+//  OpenGLDemo
+//
+//  Created by SeacenLiu on 2020/2/10.
+//  Copyright © 2020 SeacenLiu. All rights reserved.
+//
+
+/**
+ * 并行纹理加载
+ *
+ * 解码（stbi_load）和上传（glTexImage2D）分开：
+ * 1. 遍历模型时只登记纹理路径和纹理缓存分配的纹理 ID，ID 立即交给网格使用（此时还没有数据）
+ * 2. finish() 时由线程池并行解码所有纹理，主线程（OpenGL 上下文所在线程）
+ *    按解码完成的先后顺序逐个上传，解码和上传互相重叠
+ * 每个纹理的解码、上传耗时都会记录下来，可以用 printStats() 输出。
+ * 上传完成后把尺寸登记到纹理缓存（TextureCache::commit）。
+ *
+ * 图片旁边有离线转换好的压缩纹理（"<图片路径>.ktx"，见 texture_compressor.h）并且不比图片旧时，
+ * 工作线程直接读取压缩块，主线程用 glCompressedTexImage2D 上传全部 mipmap；
+ * 没有压缩纹理、文件损坏或者不支持该格式时回退到 stb_image 解码。
+ */
+#ifndef texture_loader_h
+#define texture_loader_h
+
+#include <glad/glad.h>
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <algorithm>
+#include <condition_variable>
+
+// stb_image 的实现部分没有重复包含保护，已经包含过（例如定义了 STB_IMAGE_IMPLEMENTATION）时不再包含
+#ifndef STBI_INCLUDE_STB_IMAGE_H
+#include "stb_image.h"
+#endif
+
+#include "texture_cache.h"
+#include "ktx_texture.h"
+
+// 把解码后的图像上传到纹理对象（生成 mipmap，设置环绕和过滤方式）
+inline void UploadTexture(unsigned int textureID, unsigned char *data,
+                          int width, int height, int nrComponents) {
+    // 配置存储格式
+    GLenum format;
+    if (nrComponents == 1)
+        format = GL_RED;
+    else if (nrComponents == 3)
+        format = GL_RGB;
+    else
+        format = GL_RGBA;
+    // 每行数据按 1 字节对齐（RGB 纹理的宽度不一定是 4 的倍数）
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    GLState::instance().bindTexture(GL_TEXTURE_2D, textureID);
+    glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
+    glGenerateMipmap(GL_TEXTURE_2D);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+}
+
+class TextureLoader {
+public:
+    // 单个纹理的加载记录
+    struct Entry {
+        std::string filename;
+        unsigned int id;
+        int width, height, nrComponents;
+        double decodeMs;    // 解码耗时（工作线程）
+        double uploadMs;    // 上传耗时（主线程）
+        unsigned int worker;
+        GLenum compressedFormat;    // 使用压缩纹理时的格式（否则为 0）
+        size_t bytes;               // 显存占用（压缩纹理为实际数据量，否则为估算值）
+    };
+    // 所有纹理（登记顺序）
+    std::vector<Entry> entries;
+    // 最近一次 finish 的总耗时
+    double totalMs;
+    // 使用的工作线程数
+    unsigned int threadCount;
+
+    TextureLoader() : totalMs(0.0), threadCount(0), finished(0) {}
+
+    // 是否优先使用压缩纹理（进程级开关，默认开启；关闭后总是走 stb 解码，用于对比）
+    static bool &useCompressed() {
+        static bool enabled = true;
+        return enabled;
+    }
+
+    // 登记纹理文件和它的纹理 ID（数据在 finish 后才可用）
+    void add(const std::string &filename, unsigned int id) {
+        Entry entry;
+        entry.filename = filename;
+        entry.id = id;
+        entry.width = entry.height = entry.nrComponents = 0;
+        entry.decodeMs = entry.uploadMs = 0.0;
+        entry.worker = 0;
+        entry.compressedFormat = 0;
+        entry.bytes = 0;
+        entries.push_back(entry);
+    }
+    // 并行解码所有登记的纹理，并在当前线程按完成顺序上传
+    void finish() {
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        size_t first = finished;
+        size_t count = entries.size() - first;
+        if (count == 0)
+            return;
+        unsigned int hw = std::max(1u, std::thread::hardware_concurrency());
+        threadCount = (unsigned int)std::min<size_t>(hw, count);
+        next = first;
+        // 扩展查询需要在 OpenGL 上下文所在的线程进行，先在这里缓存结果
+        KtxSupported(GL_COMPRESSED_RGB_S3TC_DXT1_EXT);
+        std::vector<std::thread> workers;
+        for (unsigned int t = 0; t < threadCount; ++t)
+            workers.push_back(std::thread(&TextureLoader::decodeLoop, this, t));
+        // 主线程：谁先解码完就先上传谁
+        for (size_t uploaded = 0; uploaded < count; ++uploaded) {
+            Decoded decoded;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                ready.wait(lock, [this] { return !queue.empty(); });
+                decoded = std::move(queue.front());
+                queue.pop_front();
+            }
+            Entry &entry = entries[decoded.index];
+            std::chrono::steady_clock::time_point uploadStart = std::chrono::steady_clock::now();
+            if (decoded.ktx && KtxSupported(decoded.ktx->internalFormat)) {
+                UploadKtxTexture(entry.id, *decoded.ktx);
+                entry.width = decoded.ktx->width;
+                entry.height = decoded.ktx->height;
+                entry.compressedFormat = decoded.ktx->internalFormat;
+                entry.bytes = decoded.ktx->bytes();
+            } else {
+                // 没有压缩纹理，或者驱动不支持它的格式（在主线程补做解码）
+                if (decoded.ktx)
+                    decoded.data = stbi_load(entry.filename.c_str(), &entry.width, &entry.height, &entry.nrComponents, 0);
+                if (decoded.data) {
+                    UploadTexture(entry.id, decoded.data, entry.width, entry.height, entry.nrComponents);
+                    stbi_image_free(decoded.data);
+                } else {
+                    std::cout << "Texture failed to load at path: " << entry.filename << std::endl;
+                }
+                entry.bytes = TextureCache::estimateBytes(entry.width, entry.height, entry.nrComponents);
+            }
+            entry.uploadMs = elapsedMs(uploadStart);
+            TextureCache::instance().commit(entry.id, entry.bytes);
+        }
+        for (unsigned int t = 0; t < workers.size(); ++t)
+            workers[t].join();
+        finished = entries.size();
+        totalMs = elapsedMs(start);
+    }
+    // 输出每个纹理的解码（压缩纹理为读取）、上传耗时和显存占用
+    void printStats() const {
+        double decodeSum = 0.0, uploadSum = 0.0;
+        size_t compressedCount = 0, bytesSum = 0;
+        for (unsigned int i = 0; i < entries.size(); ++i) {
+            const Entry &e = entries[i];
+            std::cout << "纹理 " << e.filename << " (" << e.width << "x" << e.height << "x";
+            if (e.compressedFormat)
+                std::cout << KtxFormatName(e.compressedFormat) << " KTX";
+            else
+                std::cout << e.nrComponents;
+            std::cout << "): 解码 " << e.decodeMs << " ms (线程 " << e.worker << "), 上传 " << e.uploadMs << " ms, 显存 "
+                      << e.bytes / 1024 << " KB" << std::endl;
+            decodeSum += e.decodeMs;
+            uploadSum += e.uploadMs;
+            compressedCount += e.compressedFormat ? 1 : 0;
+            bytesSum += e.bytes;
+        }
+        std::cout << "纹理加载: " << entries.size() << " 个 (压缩纹理 " << compressedCount << " 个), " << threadCount
+                  << " 个解码线程, 总耗时 " << totalMs << " ms (解码累计 " << decodeSum << " ms, 上传累计 " << uploadSum
+                  << " ms), 显存 " << bytesSum / 1024 << " KB" << std::endl;
+    }
+
+private:
+    // 解码结果（stb 解码的像素，或者读取的压缩纹理）
+    struct Decoded {
+        size_t index;
+        unsigned char *data;
+        std::unique_ptr<KtxTexture> ktx;
+    };
+    std::mutex mutex;
+    std::condition_variable ready;
+    std::deque<Decoded> queue;
+    std::atomic<size_t> next;
+    size_t finished;    // 已经上传完成的纹理数量
+
+    // 工作线程：不断领取下一个未解码的纹理
+    void decodeLoop(unsigned int worker) {
+        for (;;) {
+            size_t index = next++;
+            if (index >= entries.size())
+                return;
+            Entry &entry = entries[index];
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            Decoded decoded;
+            decoded.index = index;
+            decoded.data = NULL;
+            if (useCompressed() && KtxUpToDate(entry.filename)) {
+                decoded.ktx.reset(new KtxTexture());
+                if (!ReadKtx(KtxPath(entry.filename), *decoded.ktx))
+                    decoded.ktx.reset();
+            }
+            if (!decoded.ktx)
+                decoded.data = stbi_load(entry.filename.c_str(), &entry.width, &entry.height, &entry.nrComponents, 0);
+            entry.decodeMs = elapsedMs(start);
+            entry.worker = worker;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                queue.push_back(std::move(decoded));
+            }
+            ready.notify_one();
+        }
+    }
+    static double elapsedMs(std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+};
+
+#endif /* texture_loader_h */
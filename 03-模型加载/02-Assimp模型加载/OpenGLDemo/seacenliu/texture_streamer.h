@@ -0,0 +1,523 @@
+//
+//  texture_streamer.h
+//  OpenGLDemo
+//
+//  Created by SeacenLiu on 2020/2/21.
+//  Copyright © 2020 SeacenLiu. All rights reserved.
+//
+
+/**
+ * 纹理流式加载（PBO 上传环）
+ *
+ * TextureLoader 在构造模型时一次性解码、上传全部纹理，大纹理会让那一帧卡住。
+ * TextureStreamer 把这些工作分摊到之后的多帧：
+ * 1. add：登记纹理（纹理 ID 已经交给网格使用），后台线程读取 KTX 压缩纹理，
+ *    或者用 stb_image 解码并在 CPU 上生成整条 mipmap 链
+ * 2. update（每帧一次，主线程）：把数据拷贝进像素解包缓冲（GL_PIXEL_UNPACK_BUFFER）环中的一个缓冲，
+ *    再以缓冲内偏移调用 glTexSubImage2D / glCompressedTexSubImage2D，驱动可以异步传输；
+ *    每帧上传的字节数不超过预算，大的层级按行（压缩纹理按 4 行一组的块行）拆到多帧
+ * 3. 每个纹理先上传最小的 mipmap，GL_TEXTURE_BASE_LEVEL 指向已经上传完的最大层级，
+ *    更大的层级到达后逐级下调：物体先显示模糊的纹理，再逐渐变清晰。
+ *    多个纹理同时在传时，优先传当前层级最小的
+ *
+ * 环中每个缓冲用完后插入围栏（glFenceSync），复用前用 glClientWaitSync（超时为 0）检查，
+ * GPU 还在读取时这一帧直接停止上传而不是等待，因此映射时可以用 GL_MAP_UNSYNCHRONIZED_BIT。
+ * 解码完还没上传完的图片数量有上限（TEXTURE_STREAM_MAX_READY），解码线程领先太多时会等待，避免占用大量内存。
+ * 纹理所有层级上传完成后调用 TextureCache::commit 登记显存占用。
+ */
+#ifndef texture_streamer_h
+#define texture_streamer_h
+
+#include <glad/glad.h>
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <algorithm>
+#include <condition_variable>
+
+#include "texture_loader.h"
+
+// 环中的缓冲数量
+#define TEXTURE_STREAM_SLOTS 4
+// 每个缓冲的大小（字节；一行数据超过这个大小时缓冲会扩大）
+#define TEXTURE_STREAM_SLOT_BYTES (2u * 1024u * 1024u)
+// 默认每帧上传预算（字节）
+#define TEXTURE_STREAM_FRAME_BUDGET (4u * 1024u * 1024u)
+// 解码完还没上传完的图片最多几张
+#define TEXTURE_STREAM_MAX_READY 4
+
+// 未压缩图像缩小一级（2x2 盒式滤波，任意通道数，奇数尺寸时边缘像素重复使用）
+inline void DownsampleImage(const unsigned char *src, int width, int height, int components, unsigned char *dst) {
+    int w = std::max(1, width / 2), h = std::max(1, height / 2);
+    for (int y = 0; y < h; ++y) {
+        int y0 = std::min(y * 2, height - 1), y1 = std::min(y * 2 + 1, height - 1);
+        for (int x = 0; x < w; ++x) {
+            int x0 = std::min(x * 2, width - 1), x1 = std::min(x * 2 + 1, width - 1);
+            const unsigned char *p00 = src + ((size_t)y0 * width + x0) * components;
+            const unsigned char *p01 = src + ((size_t)y0 * width + x1) * components;
+            const unsigned char *p10 = src + ((size_t)y1 * width + x0) * components;
+            const unsigned char *p11 = src + ((size_t)y1 * width + x1) * components;
+            unsigned char *q = dst + ((size_t)y * w + x) * components;
+            for (int k = 0; k < components; ++k)
+                q[k] = (unsigned char)((p00[k] + p01[k] + p10[k] + p11[k] + 2) / 4);
+        }
+    }
+}
+
+// 流式加载统计（累计）
+struct TextureStreamStats {
+    unsigned long textures;     // 上传完成的纹理
+    unsigned long levels;       // 上传完成的 mipmap 层级
+    unsigned long chunks;       // 上传次数（每次占用环中的一个缓冲）
+    unsigned long frames;       // 有上传的帧数
+    unsigned long stalls;       // 缓冲还在被 GPU 读取、提前结束上传的帧数
+    size_t bytes;               // 上传字节数
+    size_t maxFrameBytes;       // 单帧最多上传字节数
+};
+
+class TextureStreamer {
+public:
+    // 单个纹理的加载记录
+    struct Entry {
+        std::string filename;
+        unsigned int id;
+        int width, height;
+        GLenum compressedFormat;    // 使用压缩纹理时的格式（否则为 0）
+        int nrComponents;
+        size_t bytes;               // 显存占用（压缩纹理为实际数据量，否则为估算值）
+        double decodeMs;            // 解码耗时（工作线程）
+        double visibleMs;           // 从登记到最小层级可以采样
+        double completeMs;          // 从登记到全部层级上传完成
+        unsigned long frames;       // 上传分摊到的帧数
+        bool done;
+    };
+    // 所有纹理（登记顺序）
+    std::vector<Entry> entries;
+
+    // 构造函数（需要在 OpenGL 上下文创建之后调用）；threads 为 0 时使用硬件线程数减一（给渲染线程留一个）
+    TextureStreamer(size_t frameBudget = TEXTURE_STREAM_FRAME_BUDGET, unsigned int slotCount = TEXTURE_STREAM_SLOTS,
+                    size_t slotBytes = TEXTURE_STREAM_SLOT_BYTES, unsigned int threads = 0)
+        : frameBudget(frameBudget), slots(std::max(1u, slotCount)), nextSlot(0), frameIndex(0),
+          completed(0), inFlight(0), stopping(false) {
+        memset(&totals, 0, sizeof(totals));
+        for (unsigned int i = 0; i < slots.size(); ++i) {
+            glGenBuffers(1, &slots[i].buffer);
+            GLState::instance().bindBuffer(GL_PIXEL_UNPACK_BUFFER, slots[i].buffer);
+            glBufferData(GL_PIXEL_UNPACK_BUFFER, (GLsizeiptr)slotBytes, NULL, GL_STREAM_DRAW);
+            slots[i].size = slotBytes;
+            slots[i].fence = 0;
+        }
+        GLState::instance().bindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        // 扩展查询需要在 OpenGL 上下文所在的线程进行，先在这里缓存结果
+        KtxSupported(GL_COMPRESSED_RGB_S3TC_DXT1_EXT);
+        // 默认留一个核给渲染线程（hardware_concurrency 无法确定时返回 0）
+        if (threads == 0) {
+            unsigned int hw = std::thread::hardware_concurrency();
+            threads = hw > 1 ? hw - 1 : 1;
+        }
+        for (unsigned int t = 0; t < threads; ++t)
+            workers.push_back(std::thread(&TextureStreamer::decodeLoop, this));
+    }
+    // 析构时只停止解码线程（不调用 OpenGL，缓冲和围栏由 release 释放）
+    ~TextureStreamer() {
+        stopWorkers();
+    }
+    // 释放 OpenGL 资源（未完成的纹理停止上传）
+    void release() {
+        stopWorkers();
+        for (unsigned int i = 0; i < slots.size(); ++i) {
+            if (slots[i].fence)
+                glDeleteSync(slots[i].fence);
+            slots[i].fence = 0;
+            GLState::instance().deleteBuffers(1, &slots[i].buffer);
+        }
+        slots.clear();
+        active.clear();
+    }
+    // 每帧上传预算（字节）
+    void setFrameBudget(size_t bytes) {
+        frameBudget = bytes;
+    }
+    size_t budget() const {
+        return frameBudget;
+    }
+    // 登记纹理文件和它的纹理 ID（在之后的 update 中逐步上传）
+    void add(const std::string &filename, unsigned int id) {
+        Entry entry;
+        entry.filename = filename;
+        entry.id = id;
+        entry.width = entry.height = entry.nrComponents = 0;
+        entry.compressedFormat = 0;
+        entry.bytes = 0;
+        entry.decodeMs = entry.visibleMs = entry.completeMs = 0.0;
+        entry.frames = 0;
+        entry.done = false;
+        entries.push_back(entry);
+        addTimes.push_back(std::chrono::steady_clock::now());
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            jobs.push_back(Job{ entries.size() - 1, filename });
+        }
+        wakeup.notify_one();
+    }
+    // 还没有上传完成的纹理数量
+    size_t pending() const {
+        return entries.size() - completed;
+    }
+    bool idle() const {
+        return pending() == 0;
+    }
+    // 每帧调用一次（主线程）：接收解码好的图片，在预算内通过缓冲环上传
+    void update() {
+        ++frameIndex;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            while (!ready.empty()) {
+                active.push_back(std::move(ready.front()));
+                ready.pop_front();
+            }
+        }
+        // 新到达的图片：设置采样参数，解码失败的直接结束
+        for (unsigned int i = 0; i < active.size(); ) {
+            if (active[i]->level >= 0 || begin(*active[i])) {
+                ++i;
+            } else {
+                finish(*active[i]);
+                active.erase(active.begin() + i);
+            }
+        }
+        if (active.empty())
+            return;
+        // 行宽不一定是 4 的倍数
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        size_t uploaded = 0;
+        while (!active.empty()) {
+            // 当前层级最小的图片优先（所有纹理都先变得可以采样，再逐级变清晰）
+            unsigned int pick = 0;
+            for (unsigned int i = 1; i < active.size(); ++i) {
+                if (active[i]->levelBytes(active[i]->level) < active[pick]->levelBytes(active[pick]->level))
+                    pick = i;
+            }
+            StreamImage &image = *active[pick];
+            size_t rowBytes = image.rowBytes(image.level);
+            int rows = std::min(image.rowCount(image.level) - image.row,
+                                (int)(std::min(frameBudget - std::min(frameBudget, uploaded), slots[nextSlot].size) / rowBytes));
+            if (rows == 0) {
+                // 预算用完；一行都放不下时至少传一行，保证进度
+                if (uploaded > 0)
+                    break;
+                rows = 1;
+            }
+            Slot &slot = slots[nextSlot];
+            if (slot.fence) {
+                if (glClientWaitSync(slot.fence, 0, 0) == GL_TIMEOUT_EXPIRED) {
+                    ++totals.stalls;
+                    break;
+                }
+                glDeleteSync(slot.fence);
+                slot.fence = 0;
+            }
+            GLState::instance().bindTexture(GL_TEXTURE_2D, entries[image.entry].id);
+            if (image.row == 0)
+                allocateLevel(image);
+            size_t bytes = (size_t)rows * rowBytes;
+            GLState::instance().bindBuffer(GL_PIXEL_UNPACK_BUFFER, slot.buffer);
+            if (bytes > slot.size) {
+                glBufferData(GL_PIXEL_UNPACK_BUFFER, (GLsizeiptr)bytes, NULL, GL_STREAM_DRAW);
+                slot.size = bytes;
+            }
+            // 围栏已经通过，GPU 不再读取这个缓冲，不需要驱动再做同步
+            void *mapped = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, (GLsizeiptr)bytes,
+                                            GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+            if (!mapped)
+                break;
+            memcpy(mapped, &image.data[image.levelOffsets[image.level] + (size_t)image.row * rowBytes], bytes);
+            glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+            int width = image.levelWidth(image.level);
+            if (image.compressed) {
+                int y = image.row * 4;
+                int height = std::min(rows * 4, image.levelHeight(image.level) - y);
+                glCompressedTexSubImage2D(GL_TEXTURE_2D, image.level, 0, y, width, height,
+                                          image.format, (GLsizei)bytes, (void*)0);
+            } else {
+                glTexSubImage2D(GL_TEXTURE_2D, image.level, 0, image.row, width, rows,
+                                image.format, GL_UNSIGNED_BYTE, (void*)0);
+            }
+            slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+            nextSlot = (nextSlot + 1) % slots.size();
+            uploaded += bytes;
+            ++totals.chunks;
+            if (image.lastFrame != frameIndex) {
+                image.lastFrame = frameIndex;
+                ++entries[image.entry].frames;
+            }
+            image.row += rows;
+            if (image.row < image.rowCount(image.level))
+                continue;
+            // 这一级上传完成：开始采样这一级
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, image.level);
+            ++totals.levels;
+            if (image.level == image.levelCount() - 1)
+                entries[image.entry].visibleMs = elapsedMs(addTimes[image.entry]);
+            if (image.level > 0) {
+                --image.level;
+                image.row = 0;
+            } else {
+                finish(image);
+                active.erase(active.begin() + pick);
+            }
+        }
+        // 之后用客户端内存上传的代码不能受缓冲绑定影响
+        GLState::instance().bindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        if (uploaded > 0) {
+            ++totals.frames;
+            totals.bytes += uploaded;
+            totals.maxFrameBytes = std::max(totals.maxFrameBytes, uploaded);
+        }
+    }
+    // 累计统计
+    const TextureStreamStats &stats() const {
+        return totals;
+    }
+    // 输出每个纹理的解码耗时、可见和完成延迟，以及上传环的统计
+    void printStats() const {
+        double visibleSum = 0.0, completeMax = 0.0;
+        size_t bytesSum = 0, compressedCount = 0;
+        for (unsigned int i = 0; i < entries.size(); ++i) {
+            const Entry &e = entries[i];
+            if (!e.done)
+                continue;
+            std::cout << "流式纹理 " << e.filename << " (" << e.width << "x" << e.height << "x";
+            if (e.compressedFormat)
+                std::cout << KtxFormatName(e.compressedFormat) << " KTX";
+            else
+                std::cout << e.nrComponents;
+            std::cout << "): 解码 " << e.decodeMs << " ms, 可见 " << e.visibleMs << " ms, 完成 " << e.completeMs
+                      << " ms (分 " << e.frames << " 帧), 显存 " << e.bytes / 1024 << " KB" << std::endl;
+            visibleSum += e.visibleMs;
+            completeMax = std::max(completeMax, e.completeMs);
+            bytesSum += e.bytes;
+            compressedCount += e.compressedFormat ? 1 : 0;
+        }
+        std::cout << "纹理流式加载: " << completed << " / " << entries.size() << " 个 (压缩纹理 " << compressedCount << " 个), "
+                  << workers.size() << " 个解码线程, 每帧预算 " << frameBudget / 1024 << " KB, 上传 "
+                  << totals.bytes / 1024 << " KB 共 " << totals.chunks << " 次 / " << totals.frames << " 帧 (单帧最多 "
+                  << totals.maxFrameBytes / 1024 << " KB, 缓冲环 " << slots.size() << " 个, 缓冲忙提前结束 "
+                  << totals.stalls << " 帧), 平均 " << (completed ? visibleSum / completed : 0.0)
+                  << " ms 后可见, " << completeMax << " ms 全部完成, 显存 " << bytesSum / 1024 << " KB" << std::endl;
+    }
+
+private:
+    // 解码任务（文件名单独拷贝一份，工作线程不访问 entries）
+    struct Job {
+        size_t entry;
+        std::string filename;
+    };
+    // 解码好的图片（所有层级连续存放）和上传进度
+    struct StreamImage {
+        size_t entry;
+        bool compressed;
+        GLenum format;              // 压缩格式，或者 GL_RED / GL_RG / GL_RGB / GL_RGBA
+        int width, height, components;
+        std::vector<unsigned char> data;
+        std::vector<size_t> levelOffsets;
+        double decodeMs;
+        int level;                  // 正在上传的层级（-1 表示还没分配存储）
+        int row;                    // 这一级已经上传的行数（压缩纹理为块行）
+        unsigned long lastFrame;
+
+        int levelCount() const {
+            return (int)levelOffsets.size();
+        }
+        int levelWidth(int level) const {
+            return std::max(1, width >> level);
+        }
+        int levelHeight(int level) const {
+            return std::max(1, height >> level);
+        }
+        // 一行（压缩纹理为 4 行像素组成的一行块）的字节数
+        size_t rowBytes(int level) const {
+            if (compressed)
+                return (size_t)((levelWidth(level) + 3) / 4) * KtxBlockBytes(format);
+            return (size_t)levelWidth(level) * components;
+        }
+        int rowCount(int level) const {
+            return compressed ? (levelHeight(level) + 3) / 4 : levelHeight(level);
+        }
+        size_t levelBytes(int level) const {
+            return rowBytes(level) * rowCount(level);
+        }
+    };
+    // 缓冲环中的一个缓冲
+    struct Slot {
+        GLuint buffer;
+        size_t size;
+        GLsync fence;               // 最近一次上传之后插入的围栏（0 表示空闲）
+    };
+
+    size_t frameBudget;
+    std::vector<Slot> slots;
+    unsigned int nextSlot;
+    unsigned long frameIndex;
+    size_t completed;
+    TextureStreamStats totals;
+    std::vector<std::chrono::steady_clock::time_point> addTimes;
+    // 正在上传的图片（主线程）
+    std::vector<std::unique_ptr<StreamImage>> active;
+    // 工作线程共享的状态
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable wakeup;
+    std::deque<Job> jobs;
+    std::deque<std::unique_ptr<StreamImage>> ready;
+    unsigned int inFlight;          // 正在解码、等待上传和正在上传的图片数量
+    bool stopping;
+
+    // 新图片：设置采样参数，最小一级上传完之前纹理不可采样；解码失败时返回 false
+    bool begin(StreamImage &image) {
+        Entry &entry = entries[image.entry];
+        entry.decodeMs = image.decodeMs;
+        if (image.data.empty()) {
+            std::cout << "Texture failed to load at path: " << entry.filename << std::endl;
+            return false;
+        }
+        entry.width = image.width;
+        entry.height = image.height;
+        entry.nrComponents = image.components;
+        entry.compressedFormat = image.compressed ? image.format : 0;
+        GLState::instance().bindTexture(GL_TEXTURE_2D, entry.id);
+        image.level = image.levelCount() - 1;
+        image.row = 0;
+        image.lastFrame = 0;
+        // BASE_LEVEL 超出 MAX_LEVEL 时纹理不完整（采样结果为黑色）
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, image.levelCount());
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, image.level);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, image.level > 0 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        return true;
+    }
+    // 开始上传一级之前分配这一级的存储（不传数据）：分配也有开销，分摊到各级第一次上传的那一帧；
+    // 比 BASE_LEVEL 更大的层级不参与采样，还没分配也不影响纹理完整性
+    void allocateLevel(const StreamImage &image) {
+        int level = image.level;
+        // 数据参数为空指针时不能绑定解包缓冲（否则会被当作缓冲内偏移 0）
+        GLState::instance().bindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        if (image.compressed)
+            glCompressedTexImage2D(GL_TEXTURE_2D, level, image.format, image.levelWidth(level), image.levelHeight(level),
+                                   0, (GLsizei)image.levelBytes(level), NULL);
+        else
+            glTexImage2D(GL_TEXTURE_2D, level, image.format, image.levelWidth(level), image.levelHeight(level),
+                         0, image.format, GL_UNSIGNED_BYTE, NULL);
+    }
+    // 图片处理完成（上传完或解码失败）：登记显存，让解码线程继续
+    void finish(const StreamImage &image) {
+        Entry &entry = entries[image.entry];
+        if (!image.data.empty()) {
+            entry.bytes = image.compressed ? image.data.size()
+                                           : TextureCache::estimateBytes(image.width, image.height, image.components);
+            TextureCache::instance().commit(entry.id, entry.bytes);
+            ++totals.textures;
+        }
+        entry.completeMs = elapsedMs(addTimes[image.entry]);
+        entry.done = true;
+        ++completed;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            --inFlight;
+        }
+        wakeup.notify_one();
+    }
+    // 工作线程：领取任务，未上传的图片太多时等待
+    void decodeLoop() {
+        for (;;) {
+            Job job;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                wakeup.wait(lock, [this] {
+                    return stopping || (!jobs.empty() && inFlight < TEXTURE_STREAM_MAX_READY);
+                });
+                if (stopping)
+                    return;
+                job = std::move(jobs.front());
+                jobs.pop_front();
+                ++inFlight;
+            }
+            std::unique_ptr<StreamImage> image = decode(job);
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                ready.push_back(std::move(image));
+            }
+        }
+    }
+    // 读取压缩纹理，或者解码图片并生成 mipmap 链
+    static std::unique_ptr<StreamImage> decode(const Job &job) {
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        std::unique_ptr<StreamImage> image(new StreamImage());
+        image->entry = job.entry;
+        image->level = -1;
+        image->row = 0;
+        KtxTexture ktx;
+        if (TextureLoader::useCompressed() && KtxUpToDate(job.filename)
+            && ReadKtx(KtxPath(job.filename), ktx) && KtxSupported(ktx.internalFormat)) {
+            image->compressed = true;
+            image->format = ktx.internalFormat;
+            image->width = ktx.width;
+            image->height = ktx.height;
+            image->components = 0;
+            image->data.swap(ktx.data);
+            image->levelOffsets.swap(ktx.levelOffsets);
+        } else {
+            int width = 0, height = 0, components = 0;
+            unsigned char *pixels = stbi_load(job.filename.c_str(), &width, &height, &components, 0);
+            image->compressed = false;
+            image->width = width;
+            image->height = height;
+            image->components = components;
+            image->format = components == 1 ? GL_RED : components == 2 ? GL_RG : components == 3 ? GL_RGB : GL_RGBA;
+            if (pixels) {
+                // 代替 glGenerateMipmap：在工作线程上逐级缩小
+                size_t total = 0;
+                for (int level = 0; ; ++level) {
+                    image->levelOffsets.push_back(total);
+                    total += image->levelBytes(level);
+                    if (image->levelWidth(level) == 1 && image->levelHeight(level) == 1)
+                        break;
+                }
+                image->data.resize(total);
+                memcpy(&image->data[0], pixels, image->levelBytes(0));
+                stbi_image_free(pixels);
+                for (int level = 1; level < image->levelCount(); ++level)
+                    DownsampleImage(&image->data[image->levelOffsets[level - 1]], image->levelWidth(level - 1),
+                                    image->levelHeight(level - 1), components, &image->data[image->levelOffsets[level]]);
+            }
+        }
+        image->decodeMs = elapsedMs(start);
+        return image;
+    }
+    void stopWorkers() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wakeup.notify_all();
+        for (unsigned int t = 0; t < workers.size(); ++t) {
+            if (workers[t].joinable())
+                workers[t].join();
+        }
+    }
+    static double elapsedMs(std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+};
+
+#endif /* texture_streamer_h */
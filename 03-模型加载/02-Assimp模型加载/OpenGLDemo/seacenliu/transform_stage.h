@@ -0,0 +1,165 @@
+//
+//  transform_stage.h
+//  OpenGLDemo
+//
+//  Created by SeacenLiu on 2020/2/8.
+//  Copyright © 2020 SeacenLiu. All rights reserved.
+//
+
+/**
+ * CPU 端变换阶段
+ *
+ * 每个物体的模型矩阵、法线矩阵（模型矩阵左上角的逆矩阵的转置）和 MVP 矩阵
+ * 每帧在 CPU 上只算一次，顶点着色器直接使用，不再逐顶点求逆、连乘矩阵：
+ * - 法线矩阵只在模型矩阵修改后重新计算（与相机无关）
+ * - MVP = (projection * view) * model，投影 * 视图只算一次，再批量乘上所有物体的模型矩阵
+ *
+ * 3x3 的逆矩阵的转置等于三列两两叉乘再除以行列式：
+ *   inverse(M)^T = [c1 x c2, c2 x c0, c0 x c1] / det(M)
+ * 在支持 SSE 的平台上矩阵乘法和叉乘都用 128 位向量计算。
+ */
+#ifndef transform_stage_h
+#define transform_stage_h
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include <vector>
+#include <algorithm>
+#if defined(__SSE__)
+#include <xmmintrin.h>
+#endif
+
+#include "shader.h"
+
+#if defined(__SSE__)
+// a.yzx * b.zxy - a.zxy * b.yzx
+inline __m128 TransformCross(__m128 a, __m128 b) {
+    __m128 a1 = _mm_shuffle_ps(a, a, _MM_SHUFFLE(3, 0, 2, 1));
+    __m128 b1 = _mm_shuffle_ps(b, b, _MM_SHUFFLE(3, 1, 0, 2));
+    __m128 a2 = _mm_shuffle_ps(a, a, _MM_SHUFFLE(3, 1, 0, 2));
+    __m128 b2 = _mm_shuffle_ps(b, b, _MM_SHUFFLE(3, 0, 2, 1));
+    return _mm_sub_ps(_mm_mul_ps(a1, b1), _mm_mul_ps(a2, b2));
+}
+#endif
+
+// 法线矩阵：模型矩阵左上角 3x3 的逆矩阵的转置
+inline glm::mat3 NormalMatrix(const glm::mat4 &model) {
+#if defined(__SSE__)
+    const float *m = glm::value_ptr(model);
+    __m128 c0 = _mm_loadu_ps(m), c1 = _mm_loadu_ps(m + 4), c2 = _mm_loadu_ps(m + 8);
+    __m128 r0 = TransformCross(c1, c2);
+    __m128 r1 = TransformCross(c2, c0);
+    __m128 r2 = TransformCross(c0, c1);
+    // det = dot(c0, c1 x c2)
+    __m128 d = _mm_mul_ps(c0, r0);
+    float det = _mm_cvtss_f32(d)
+              + _mm_cvtss_f32(_mm_shuffle_ps(d, d, _MM_SHUFFLE(1, 1, 1, 1)))
+              + _mm_cvtss_f32(_mm_shuffle_ps(d, d, _MM_SHUFFLE(2, 2, 2, 2)));
+    __m128 inv = _mm_set1_ps(1.0f / det);
+    float out[12];
+    _mm_storeu_ps(out, _mm_mul_ps(r0, inv));
+    _mm_storeu_ps(out + 4, _mm_mul_ps(r1, inv));
+    _mm_storeu_ps(out + 8, _mm_mul_ps(r2, inv));
+    return glm::mat3(glm::vec3(out[0], out[1], out[2]),
+                     glm::vec3(out[4], out[5], out[6]),
+                     glm::vec3(out[8], out[9], out[10]));
+#else
+    return glm::transpose(glm::inverse(glm::mat3(model)));
+#endif
+}
+
+// 批量矩阵乘法：out[i] = lhs * rhs[i]
+inline void MultiplyMatrices(const glm::mat4 &lhs, const glm::mat4 *rhs, glm::mat4 *out, size_t count) {
+#if defined(__SSE__)
+    const float *l = glm::value_ptr(lhs);
+    __m128 l0 = _mm_loadu_ps(l), l1 = _mm_loadu_ps(l + 4), l2 = _mm_loadu_ps(l + 8), l3 = _mm_loadu_ps(l + 12);
+    for (size_t i = 0; i < count; ++i) {
+        const float *r = glm::value_ptr(rhs[i]);
+        float *o = glm::value_ptr(out[i]);
+        // 结果的第 j 列 = lhs 的四列按 rhs 第 j 列的分量加权求和
+        for (int j = 0; j < 4; ++j) {
+            __m128 col = _mm_mul_ps(l0, _mm_set1_ps(r[j * 4 + 0]));
+            col = _mm_add_ps(col, _mm_mul_ps(l1, _mm_set1_ps(r[j * 4 + 1])));
+            col = _mm_add_ps(col, _mm_mul_ps(l2, _mm_set1_ps(r[j * 4 + 2])));
+            col = _mm_add_ps(col, _mm_mul_ps(l3, _mm_set1_ps(r[j * 4 + 3])));
+            _mm_storeu_ps(o + j * 4, col);
+        }
+    }
+#else
+    for (size_t i = 0; i < count; ++i)
+        out[i] = lhs * rhs[i];
+#endif
+}
+
+class TransformStage {
+public:
+    TransformStage() : dirtyBegin(0), dirtyEnd(0) {}
+
+    // 添加物体，返回其下标
+    unsigned int add(const glm::mat4 &model = glm::mat4(1.0f)) {
+        models.push_back(model);
+        normals.push_back(glm::mat3(1.0f));
+        mvps.push_back(glm::mat4(1.0f));
+        markDirty((unsigned int)models.size() - 1);
+        return (unsigned int)models.size() - 1;
+    }
+    // 修改物体的模型矩阵
+    void setModel(unsigned int index, const glm::mat4 &model) {
+        models[index] = model;
+        markDirty(index);
+    }
+    // 清空物体
+    void clear() {
+        models.clear();
+        normals.clear();
+        mvps.clear();
+        dirtyBegin = dirtyEnd = 0;
+    }
+    size_t size() const {
+        return models.size();
+    }
+    // 计算所有物体的法线矩阵（只算修改过的）和 MVP 矩阵（每帧相机更新后调用一次）
+    void update(const glm::mat4 &view, const glm::mat4 &projection) {
+        for (size_t i = dirtyBegin; i < dirtyEnd; ++i)
+            normals[i] = NormalMatrix(models[i]);
+        dirtyBegin = dirtyEnd = 0;
+        if (!models.empty())
+            MultiplyMatrices(projection * view, &models[0], &mvps[0], models.size());
+    }
+    const glm::mat4 &model(unsigned int index) const {
+        return models[index];
+    }
+    const glm::mat3 &normalMatrix(unsigned int index) const {
+        return normals[index];
+    }
+    const glm::mat4 &mvp(unsigned int index) const {
+        return mvps[index];
+    }
+    // 上传到着色器的 model、normalMatrix、mvp uniform（需先激活着色器程序，着色器没用到的会被跳过）
+    void apply(const Shader &shader, unsigned int index) const {
+        shader.setMat4("model", models[index]);
+        shader.setMat3("normalMatrix", normals[index]);
+        shader.setMat4("mvp", mvps[index]);
+    }
+
+private:
+    std::vector<glm::mat4> models;
+    std::vector<glm::mat3> normals;
+    std::vector<glm::mat4> mvps;
+    // 需要重新计算法线矩阵的范围 [dirtyBegin, dirtyEnd)
+    size_t dirtyBegin, dirtyEnd;
+
+    void markDirty(unsigned int index) {
+        if (dirtyBegin == dirtyEnd) {
+            dirtyBegin = index;
+            dirtyEnd = index + 1;
+        } else {
+            dirtyBegin = std::min(dirtyBegin, (size_t)index);
+            dirtyEnd = std::max(dirtyEnd, (size_t)index + 1);
+        }
+    }
+};
+
+#endif /* transform_stage_h */
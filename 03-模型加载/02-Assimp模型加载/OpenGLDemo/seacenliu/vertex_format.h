@@ -0,0 +1,178 @@
+//
+//  vertex_format.h
+//  OpenGLDemo
+//
+//  Created by SeacenLiu on 2020/2/14.
+//  Copyright © 2020 SeacenLiu. All rights reserved.
+//
+
+/**
+ * 紧凑顶点格式
+ *
+ * 完整格式（Vertex）每个顶点 32 字节，全部是 32 位浮点数；紧凑格式（CompactVertex）每个顶点 16 字节：
+ * - 位置：按模型包围盒量化为 16 位整数（x、y、z + 1 个填充），着色器中乘以 positionScale 再加 positionOffset
+ * - 法向量：八面体编码（Octahedral）后量化为 2 个 16 位整数
+ * - 纹理坐标：2 个半精度浮点数（GL_HALF_FLOAT）
+ * 整数属性都以非归一化（normalized = GL_FALSE）方式读取再在着色器中缩放，
+ * 避免 OpenGL 4.2 前后 snorm 转换公式不同带来的偏差。
+ *
+ * 所有网格的顶点数都小于 65536 时索引使用 16 位（每个网格的索引相对自己的基础顶点）。
+ * 转换时同时统计量化误差，和数据量一起由 VertexFormatReport 输出。
+ */
+#ifndef vertex_format_h
+#define vertex_format_h
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <algorithm>
+
+// 顶点格式
+enum VertexFormat {
+    VERTEX_FORMAT_FULL,     // 32 字节：位置、法向量、纹理坐标均为 float
+    VERTEX_FORMAT_COMPACT   // 16 字节：16 位量化位置、八面体法向量、半精度纹理坐标
+};
+
+// 紧凑顶点
+struct CompactVertex {
+    int16_t  position[4];   // 量化位置（第 4 个分量为填充）
+    int16_t  normal[2];     // 八面体编码的法向量
+    uint16_t texCoords[2];  // 半精度纹理坐标
+};
+
+static_assert(sizeof(CompactVertex) == 16, "CompactVertex must be 16 bytes");
+
+// float 转半精度（就近舍入，超出范围时为无穷大）
+inline uint16_t FloatToHalf(float value) {
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    uint32_t sign = (bits >> 16) & 0x8000u;
+    int32_t exponent = (int32_t)((bits >> 23) & 0xFF) - 127 + 15;
+    uint32_t mantissa = bits & 0x7FFFFFu;
+    if (((bits >> 23) & 0xFF) == 0xFF)                  // Inf / NaN
+        return (uint16_t)(sign | 0x7C00u | (mantissa ? 0x200u : 0u));
+    if (exponent >= 31)                                 // 上溢
+        return (uint16_t)(sign | 0x7C00u);
+    if (exponent <= 0) {                                // 非规格化数或下溢
+        if (exponent < -10)
+            return (uint16_t)sign;
+        mantissa |= 0x800000u;
+        uint32_t shift = (uint32_t)(14 - exponent);
+        uint32_t half = mantissa >> shift;
+        if ((mantissa >> (shift - 1)) & 1u)
+            ++half;
+        return (uint16_t)(sign | half);
+    }
+    uint32_t half = sign | ((uint32_t)exponent << 10) | (mantissa >> 13);
+    if (mantissa & 0x1000u)                             // 舍入（进位可能进到指数，结果仍然正确）
+        ++half;
+    return (uint16_t)half;
+}
+
+// 半精度转 float
+inline float HalfToFloat(uint16_t half) {
+    uint32_t sign = (uint32_t)(half & 0x8000u) << 16;
+    uint32_t exponent = (half >> 10) & 0x1Fu;
+    uint32_t mantissa = half & 0x3FFu;
+    uint32_t bits;
+    if (exponent == 0) {
+        if (mantissa == 0) {
+            bits = sign;
+        } else {                                        // 非规格化数
+            exponent = 127 - 15 + 1;
+            while (!(mantissa & 0x400u)) {
+                mantissa <<= 1;
+                --exponent;
+            }
+            bits = sign | (exponent << 23) | ((mantissa & 0x3FFu) << 13);
+        }
+    } else if (exponent == 31) {
+        bits = sign | 0x7F800000u | (mantissa << 13);
+    } else {
+        bits = sign | ((exponent - 15 + 127) << 23) | (mantissa << 13);
+    }
+    float value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+// 八面体编码：单位向量映射到 [-1, 1]^2
+inline void OctEncode(const glm::vec3 &n, float &u, float &v) {
+    float l1 = std::fabs(n.x) + std::fabs(n.y) + std::fabs(n.z);
+    if (l1 == 0.0f) {
+        u = v = 0.0f;
+        return;
+    }
+    float x = n.x / l1, y = n.y / l1;
+    if (n.z < 0.0f) {
+        float ox = (1.0f - std::fabs(y)) * (x >= 0.0f ? 1.0f : -1.0f);
+        float oy = (1.0f - std::fabs(x)) * (y >= 0.0f ? 1.0f : -1.0f);
+        x = ox;
+        y = oy;
+    }
+    u = x;
+    v = y;
+}
+
+// 八面体解码（与 model_loading.vs 中的 OctDecode 一致）
+inline glm::vec3 OctDecode(float u, float v) {
+    float z = 1.0f - std::fabs(u) - std::fabs(v);
+    float x = u, y = v;
+    if (z < 0.0f) {
+        x = (1.0f - std::fabs(v)) * (u >= 0.0f ? 1.0f : -1.0f);
+        y = (1.0f - std::fabs(u)) * (v >= 0.0f ? 1.0f : -1.0f);
+    }
+    float length = std::sqrt(x * x + y * y + z * z);
+    return glm::vec3(x / length, y / length, z / length);
+}
+
+// [-1, 1] 量化为 16 位整数
+inline int16_t QuantizeSnorm16(float value) {
+    value = std::max(-1.0f, std::min(1.0f, value));
+    return (int16_t)std::lround(value * 32767.0f);
+}
+
+// 顶点格式转换报告（数据量 + 量化误差）
+struct VertexFormatReport {
+    VertexFormat format;
+    GLenum indexType;
+    size_t vertexCount;
+    size_t indexCount;
+    double maxPositionError;    // 位置最大误差（模型空间单位）
+    double maxNormalError;      // 法向量最大角度误差（度）
+    double maxTexCoordError;    // 纹理坐标最大误差
+
+    VertexFormatReport()
+        : format(VERTEX_FORMAT_FULL), indexType(GL_UNSIGNED_INT), vertexCount(0), indexCount(0),
+          maxPositionError(0.0), maxNormalError(0.0), maxTexCoordError(0.0) {}
+
+    size_t vertexSize() const {
+        return format == VERTEX_FORMAT_COMPACT ? sizeof(CompactVertex) : 32;
+    }
+    size_t indexSize() const {
+        return indexType == GL_UNSIGNED_SHORT ? 2 : 4;
+    }
+    // 顶点和索引数据总量（字节），也就是绘制一遍模型需要读取的数据量
+    size_t bytes() const {
+        return vertexCount * vertexSize() + indexCount * indexSize();
+    }
+    size_t fullBytes() const {
+        return vertexCount * 32 + indexCount * 4;
+    }
+    void print() const {
+        std::cout << "顶点格式: " << (format == VERTEX_FORMAT_COMPACT ? "紧凑" : "完整") << " "
+                  << vertexSize() << " 字节/顶点, " << indexSize() * 8 << " 位索引; "
+                  << vertexCount << " 个顶点, " << indexCount << " 个索引, 共 " << bytes() / 1024
+                  << " KB (完整格式 " << fullBytes() / 1024 << " KB, "
+                  << (fullBytes() ? 100.0 * bytes() / fullBytes() : 100.0) << "%)" << std::endl;
+        if (format == VERTEX_FORMAT_COMPACT)
+            std::cout << "量化误差: 位置 " << maxPositionError << ", 法向量 " << maxNormalError
+                      << " 度, 纹理坐标 " << maxTexCoordError << std::endl;
+    }
+};
+
+#endif /* vertex_format_h */
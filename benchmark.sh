@@ -0,0 +1,72 @@
+#!/bin/sh
+#
+#  benchmark.sh
+#  OpenGLDemo
+#
+#  Created by SeacenLiu on 2020/2/25.
+#  Copyright © 2020 SeacenLiu. All rights reserved.
+#
+#  统一基准测试：离屏运行各示例的基准测试场景，结果追加到同一个 CSV（格式见 bench_report.h）
+#
+#  用法: ./benchmark.sh 多光源示例 模型加载示例 [结果文件]
+#    多光源示例、模型加载示例为编译好的可执行文件（11-多光源效果、02-Assimp模型加载），
+#    在各自的工程目录下运行（着色器、纹理、模型按相对路径加载）；结果文件默认为 benchmark.csv
+#
+#  场景参数（环境变量）:
+#    SIZE=800x600                 离屏渲染的大小
+#    CUBES=10,1000,10000          光照场景的盒子数量
+#    LIGHTS=4,64,256,1024         光照场景的光源数量
+#    FRAMES=30                    光照场景每个组合测量的帧数
+#    MODELS="resources/objects/nanosuit/nanosuit.obj"
+#                                 冷 / 热加载的模型（相对模型加载示例的目录，空格分隔）
+#    REPEAT=3                     加载、纹理基准测试的重复次数
+#    TRANSFORM=1000,10000,100000  CPU 变换阶段的物体数量
+#
+#  没有 GPU 的机器上可以用 LIBGL_ALWAYS_SOFTWARE=1 GALLIUM_DRIVER=llvmpipe 运行
+
+set -e
+
+if [ $# -lt 2 ]; then
+    sed -n '11,13p' "$0" | sed 's/^#  //'
+    exit 1
+fi
+
+ROOT=$(cd "$(dirname "$0")" && pwd)
+abspath() {
+    case "$1" in
+        /*) echo "$1" ;;
+        *) echo "$(pwd)/$1" ;;
+    esac
+}
+LIGHTING_BIN=$(abspath "$1")
+MODEL_BIN=$(abspath "$2")
+OUT=$(abspath "${3:-benchmark.csv}")
+
+SIZE=${SIZE:-800x600}
+CUBES=${CUBES:-10,1000,10000}
+LIGHTS=${LIGHTS:-4,64,256,1024}
+FRAMES=${FRAMES:-30}
+MODELS=${MODELS:-resources/objects/nanosuit/nanosuit.obj}
+REPEAT=${REPEAT:-3}
+TRANSFORM=${TRANSFORM:-1000,10000,100000}
+
+rm -f "$OUT"
+
+# 光照场景：盒子数量 × 光源数量 × 渲染路径
+(cd "$ROOT/02-OpenGL光照/11-多光源效果/OpenGLDemo" &&
+    "$LIGHTING_BIN" --headless "$SIZE" --bench --bench-cubes "$CUBES" --bench-lights "$LIGHTS" \
+        --bench-frames "$FRAMES" --bench-out "$OUT")
+
+# 模型冷 / 热加载
+for model in $MODELS; do
+    (cd "$ROOT/03-模型加载/02-Assimp模型加载/OpenGLDemo" &&
+        "$MODEL_BIN" --headless "$SIZE" --bench-load "$model" --bench-repeat "$REPEAT" --bench-out "$OUT")
+done
+
+# 纹理解码上传（第一个模型所在目录的图片）和 CPU 变换阶段
+set -- $MODELS
+(cd "$ROOT/03-模型加载/02-Assimp模型加载/OpenGLDemo" &&
+    "$MODEL_BIN" --headless "$SIZE" --bench-texture "${1%/*}" --bench-transform "$TRANSFORM" \
+        --bench-repeat "$REPEAT" --bench-out "$OUT")
+
+echo "结果: $OUT"